@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    AnalyzerTap.h
+    lock-free mono feed from the audio thread to the spectrum analyzer.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ one writer (the audio thread), one reader (the analyzer's timer). push() stores the
+ mono sum (l + r) / 2 straight into the ring, and whatever doesn't fit is dropped, the
+ analyzer only ever looks at the newest fft frame anyway.
+
+ most instances never have their editor open, so the ring only gets allocated the first
+ time it is (allocate(), while nothing pushes) and is never resized after that, so
+ prepareToPlay can't pull it out from under a reader. capacity covers a 30 Hz reader at
+ 192 kHz with room to spare.
+*/
+struct AnalyzerTap
+{
+    static constexpr int capacity = 1 << 15;
+
+    //message thread, only while the audio thread isn't pushing. does nothing the second time
+    void allocate()
+    {
+        if( samples.empty() )
+            samples.resize(static_cast<size_t>(capacity));
+    }
+
+    //audio thread, once allocate() has run
+    void push(const float* left, const float* right, int numSamples) noexcept
+    {
+        jassert(! samples.empty());
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+        write(left, right, start1, size1);
+        write(left + size1, right + size1, start2, size2);
+
+        fifo.finishedWrite(size1 + size2);
+    }
+
+    //reader, returns how many samples landed in dest
+    int pull(float* dest, int maxSamples) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(maxSamples, start1, size1, start2, size2);
+
+        if( size1 > 0 )
+            std::copy_n(samples.data() + start1, size1, dest);
+        if( size2 > 0 )
+            std::copy_n(samples.data() + start2, size2, dest + size1);
+
+        fifo.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+
+    //reader. throws away everything that's waiting
+    void discard() noexcept { fifo.finishedRead(fifo.getNumReady()); }
+
+private:
+    void write(const float* left, const float* right, int start, int numSamples) noexcept
+    {
+        if( numSamples <= 0 )
+            return;
+
+        auto* dest = samples.data() + start;
+        juce::FloatVectorOperations::add(dest, left, right, numSamples);
+        juce::FloatVectorOperations::multiply(dest, 0.5f, numSamples);
+    }
+
+    juce::AbstractFifo fifo { capacity };
+    std::vector<float> samples;
+};
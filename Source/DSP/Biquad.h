@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    Biquad.h
+    mono 2nd order filter for the general filter slot, state in the DSPArena.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientCache.h"
+#include "DSPArena.h"
+#include "SIMDLanes.h"
+
+/*
+ the same transposed direct form II as juce::dsp::IIR::Filter, so it sounds the same,
+ without the refcounted Coefficients object and the HeapBlock of state that came with
+ it. the coefficients are copied in (they come out of the CoefficientCache anyway) and
+ the two state values sit in the chain's arena block. layoutArena() before prepare().
+ processLanes() runs up to SIMDLanes::width of them side by side, one per lane.
+*/
+struct Biquad
+{
+    void layoutArena(DSPArena& arena, const juce::dsp::ProcessSpec& spec)
+    {
+        jassert(spec.numChannels == 1);
+        juce::ignoreUnused(spec);
+        state = arena.take<float>(2);
+    }
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        jassert(spec.numChannels == 1 && state != nullptr);
+        juce::ignoreUnused(spec);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        if( state != nullptr )
+            state[0] = state[1] = 0.f;
+    }
+
+    //normalized b0, b1, b2, a1, a2
+    void setCoefficients(const BiquadCoefficients& newCoefficients) noexcept { coefficients = newCoefficients; }
+
+    template<typename ProcessContext>
+    void process(const ProcessContext& context) noexcept
+    {
+        if( context.isBypassed )
+            return;
+
+        auto& block = context.getOutputBlock();
+        jassert(block.getNumChannels() == 1);
+        auto* samples = block.getChannelPointer(0);
+        const auto numSamples = block.getNumSamples();
+
+        const auto [b0, b1, b2, a1, a2] = coefficients;
+        auto s1 = state[0];
+        auto s2 = state[1];
+
+        for( size_t n = 0; n < numSamples; ++n )
+        {
+            const auto x = samples[n];
+            const auto y = b0 * x + s1;
+            s1 = b1 * x - a1 * y + s2;
+            s2 = b2 * x - a2 * y;
+            samples[n] = y;
+        }
+
+        juce::dsp::util::snapToZero(s1);
+        juce::dsp::util::snapToZero(s2);
+        state[0] = s1;
+        state[1] = s2;
+    }
+
+    //filters[i] over lane i of the frames, the same arithmetic as process() per lane.
+    //each lane keeps its own coefficients and state
+    static void processLanes(const std::array<Biquad*, SIMDLanes::width>& filters, size_t numLanes,
+                             SIMDLanes::Register* frames, size_t numFrames) noexcept
+    {
+        auto gather = [&](auto get) { return SIMDLanes::gather(numLanes, get); };
+
+        const auto b0 = gather([&](size_t i) { return filters[i]->coefficients[0]; });
+        const auto b1 = gather([&](size_t i) { return filters[i]->coefficients[1]; });
+        const auto b2 = gather([&](size_t i) { return filters[i]->coefficients[2]; });
+        const auto a1 = gather([&](size_t i) { return filters[i]->coefficients[3]; });
+        const auto a2 = gather([&](size_t i) { return filters[i]->coefficients[4]; });
+        auto s1 = gather([&](size_t i) { return filters[i]->state[0]; });
+        auto s2 = gather([&](size_t i) { return filters[i]->state[1]; });
+
+        for( size_t n = 0; n < numFrames; ++n )
+        {
+            const auto x = frames[n];
+            const auto y = b0 * x + s1;
+            s1 = b1 * x - a1 * y + s2;
+            s2 = b2 * x - a2 * y;
+            frames[n] = y;
+        }
+
+        for( size_t i = 0; i < numLanes; ++i )
+        {
+            auto v1 = s1.get(i);
+            auto v2 = s2.get(i);
+            juce::dsp::util::snapToZero(v1);
+            juce::dsp::util::snapToZero(v2);
+            filters[i]->state[0] = v1;
+            filters[i]->state[1] = v2;
+        }
+    }
+
+private:
+    BiquadCoefficients coefficients { 1.f, 0.f, 0.f, 0.f, 0.f };
+    float* state = nullptr;
+};
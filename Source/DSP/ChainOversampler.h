@@ -0,0 +1,378 @@
+/*
+  ==============================================================================
+
+    ChainOversampler.h
+    one oversampling stage around the whole effect chain.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SharedResources.h"
+
+//order has to match oversamplingFilterChoices
+enum class OversamplingFilter
+{
+    //polyphase IIR halfbands, a few samples of latency but phase shift towards the top
+    MinimumPhase,
+    //equiripple FIR halfbands, flat phase at the cost of more latency
+    LinearPhase,
+    END_OF_LIST
+};
+
+/*
+ the halfband designs behind one factor and filter type: one stage per doubling, each
+ with an upsampling and a downsampling filter. they're the same for every instance, so
+ they're designed once per process (SharedResources) instead of on every prepare(),
+ where each equiripple one is a Remez run. the stage specs are the ones
+ juce::dsp::Oversampling uses at maximum quality, the first stage steepest.
+*/
+struct OversamplingKernels
+{
+    struct Stage
+    {
+        //linear phase: the halfband's taps. minimum phase: the allpass coefficients of the
+        //direct path, then the delayed path's
+        std::vector<float> up, down;
+        int numDirectUp = 0, numDirectDown = 0;
+        //up and down together, in samples at this stage's output rate
+        float latency = 0.f;
+    };
+
+    OversamplingKernels(int factorExponent, OversamplingFilter filterType) : filter(filterType)
+    {
+        for( int n = 0; n < factorExponent; ++n )
+        {
+            auto widthUp = 0.10f * (n == 0 ? 0.5f : 1.f);
+            auto widthDown = 0.12f * (n == 0 ? 0.5f : 1.f);
+            auto attenuationUp = -90.f + 10.f * static_cast<float>(n);
+            auto attenuationDown = -75.f + 10.f * static_cast<float>(n);
+
+            auto& stage = stages.emplace_back();
+            if( filter == OversamplingFilter::LinearPhase )
+            {
+                designFIR(stage.up, widthUp, attenuationUp);
+                designFIR(stage.down, widthDown, attenuationDown);
+                stage.latency = static_cast<float>(stage.up.size() + stage.down.size() - 2) * 0.5f;
+            }
+            else
+            {
+                stage.numDirectUp = designIIR(stage.up, widthUp, attenuationUp);
+                stage.numDirectDown = designIIR(stage.down, widthDown, attenuationDown);
+                stage.latency = getPhaseDelay(stage.up, stage.numDirectUp) + getPhaseDelay(stage.down, stage.numDirectDown);
+            }
+        }
+    }
+
+    static std::shared_ptr<const OversamplingKernels> get(int factorExponent, OversamplingFilter filter)
+    {
+        auto key = "oversampling " + juce::String(factorExponent) + " " + juce::String(static_cast<int>(filter));
+        return SharedResources::get<OversamplingKernels>(key, [=] { return std::make_shared<OversamplingKernels>(factorExponent, filter); });
+    }
+
+    std::vector<Stage> stages;
+    OversamplingFilter filter;
+
+private:
+    static void designFIR(std::vector<float>& taps, float transitionWidth, float attenuationDb)
+    {
+        auto coefficients = juce::dsp::FilterDesign<float>::designFIRLowpassHalfBandEquirippleMethod(transitionWidth, attenuationDb);
+        auto* raw = coefficients->getRawCoefficients();
+        taps.assign(raw, raw + coefficients->getFilterOrder() + 1);
+    }
+
+    //returns the size of the direct path
+    static int designIIR(std::vector<float>& alphas, float transitionWidth, float attenuationDb)
+    {
+        auto structure = juce::dsp::FilterDesign<float>::designIIRLowpassHalfBandPolyphaseAllpassMethod(transitionWidth, attenuationDb);
+
+        for( int i = 0; i < structure.directPath.size(); ++i )
+            alphas.push_back(structure.directPath[i]->coefficients[0]);
+
+        //the delayed path starts with its unit delay
+        for( int i = 1; i < structure.delayedPath.size(); ++i )
+            alphas.push_back(structure.delayedPath[i]->coefficients[0]);
+
+        return structure.directPath.size();
+    }
+
+    //near dc, where the paths agree: every (a + z^-2) / (1 + a z^-2) section delays by
+    //2 (1 - a) / (1 + a), the delayed path adds its sample and the two are averaged
+    static float getPhaseDelay(const std::vector<float>& alphas, int numDirect)
+    {
+        float direct = 0.f, delayed = 1.f;
+        for( size_t i = 0; i < alphas.size(); ++i )
+            (static_cast<int>(i) < numDirect ? direct : delayed) += 2.f * (1.f - alphas[i]) / (1.f + alphas[i]);
+
+        return 0.5f * (direct + delayed);
+    }
+};
+
+/*
+ upsamples both channels of a sub block once, the whole chain (every band and effect)
+ runs at getFactor() times the host rate, and processDown() brings it back. that's one
+ pair of filters instead of one per effect.
+
+ the stages run the same filters the same way juce::dsp::Oversampling does, but on the
+ shared OversamplingKernels, so only the state and the buffers belong to the instance.
+
+ the latency is made a whole number of host samples with a Thiran allpass on the way
+ out, so it can be added straight to what goes to setLatencySamples(). at 1x nothing is
+ allocated and processUp() hands the block back.
+
+ prepare() allocates, message thread only.
+*/
+struct ChainOversampler
+{
+    static constexpr int maxFactorExponent = 3; // 8x
+    static constexpr int numChannels = 2;
+
+    void prepare(int factorExponent, OversamplingFilter filter, int maxBlockSize)
+    {
+        exponent = juce::jlimit(0, maxFactorExponent, factorExponent);
+        kernels.reset();
+        stages.clear();
+        latency = 0;
+
+        if( exponent == 0 )
+            return;
+
+        kernels = OversamplingKernels::get(exponent, filter);
+
+        auto uncompensated = 0.f;
+        for( size_t n = 0; n < kernels->stages.size(); ++n )
+        {
+            auto& kernel = kernels->stages[n];
+            auto& stage = stages.emplace_back();
+            stage.output.setSize(numChannels, maxBlockSize << (n + 1));
+            stage.upState.setSize(numChannels, static_cast<int>(kernel.up.size()));
+            stage.downState.setSize(numChannels, static_cast<int>(kernel.down.size()));
+            if( filter == OversamplingFilter::LinearPhase )
+                stage.downCentre.setSize(numChannels, static_cast<int>(kernel.down.size()) / 4 + 1);
+
+            uncompensated += kernel.latency / static_cast<float>(2 << n);
+        }
+
+        //what's left to the next whole sample, kept above 0.618 where the Thiran is stable
+        auto fractionalDelay = 1.f - (uncompensated - std::floor(uncompensated));
+        if( fractionalDelay >= 1.f )
+            fractionalDelay = 0.f;
+        else if( fractionalDelay < 0.618f )
+            fractionalDelay += 1.f;
+
+        thiranAlpha = (1.f - fractionalDelay) / (1.f + fractionalDelay);
+        useThiran = fractionalDelay > 0.f;
+        latency = juce::roundToInt(uncompensated + fractionalDelay);
+
+        for( auto& stage : stages )
+        {
+            stage.upState.clear();
+            stage.downState.clear();
+            stage.downCentre.clear();
+            stage.centrePosition = {};
+            stage.delayedOutput = {};
+        }
+
+        thiranState = {};
+    }
+
+    int getFactor() const noexcept { return 1 << exponent; }
+
+    int getLatencySamples() const noexcept { return latency; }
+
+    //the block to run the chain on, at the oversampled rate
+    juce::dsp::AudioBlock<float> processUp(juce::dsp::AudioBlock<float> block) noexcept
+    {
+        if( stages.empty() )
+            return block;
+
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+        jassert(block.getNumChannels() <= static_cast<size_t>(numChannels));
+
+        for( size_t channel = 0; channel < block.getNumChannels(); ++channel )
+        {
+            const float* input = block.getChannelPointer(channel);
+            const auto ch = static_cast<int>(channel);
+
+            for( size_t n = 0; n < stages.size(); ++n )
+            {
+                auto& kernel = kernels->stages[n];
+                auto& stage = stages[n];
+                auto* output = stage.output.getWritePointer(ch);
+
+                if( kernels->filter == OversamplingFilter::LinearPhase )
+                    upFIR(kernel.up, stage.upState.getWritePointer(ch), input, output, numSamples << n);
+                else
+                    upIIR(kernel.up, kernel.numDirectUp, stage.upState.getWritePointer(ch), input, output, numSamples << n);
+
+                input = output;
+            }
+        }
+
+        return juce::dsp::AudioBlock<float>(stages.back().output)
+                   .getSubsetChannelBlock(0, block.getNumChannels())
+                   .getSubBlock(0, static_cast<size_t>(numSamples << exponent));
+    }
+
+    //writes the chain's output back into the host rate block given to processUp()
+    void processDown(juce::dsp::AudioBlock<float> block) noexcept
+    {
+        if( stages.empty() )
+            return;
+
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+
+        for( size_t channel = 0; channel < block.getNumChannels(); ++channel )
+        {
+            const auto ch = static_cast<int>(channel);
+
+            for( auto n = static_cast<int>(stages.size()) - 1; n >= 0; --n )
+            {
+                auto& kernel = kernels->stages[static_cast<size_t>(n)];
+                auto& stage = stages[static_cast<size_t>(n)];
+                const auto* input = stage.output.getReadPointer(ch);
+                auto* output = n > 0 ? stages[static_cast<size_t>(n - 1)].output.getWritePointer(ch) : block.getChannelPointer(channel);
+
+                if( kernels->filter == OversamplingFilter::LinearPhase )
+                    downFIR(kernel.down, stage.downState.getWritePointer(ch), stage.downCentre.getWritePointer(ch),
+                            stage.centrePosition[channel], input, output, numSamples << n);
+                else
+                    downIIR(kernel.down, kernel.numDirectDown, stage.downState.getWritePointer(ch),
+                            stage.delayedOutput[channel], input, output, numSamples << n);
+            }
+
+            if( useThiran )
+            {
+                auto* samples = block.getChannelPointer(channel);
+                for( int i = 0; i < numSamples; ++i )
+                    samples[i] = allpass(thiranAlpha, thiranState[channel], samples[i]);
+            }
+        }
+    }
+
+private:
+    struct StageState
+    {
+        //this stage's output at its rate. processDown() reuses it for the stage below's
+        juce::AudioBuffer<float> output;
+        juce::AudioBuffer<float> upState, downState, downCentre;
+        std::array<int, numChannels> centrePosition {};
+        std::array<float, numChannels> delayedOutput {};
+    };
+
+    //the symmetric halfband, only every other tap and the centre aren't zero. the input
+    //is doubled for the zeros stuffed in between
+    static void upFIR(const std::vector<float>& fir, float* buf, const float* input, float* output, int numSamples) noexcept
+    {
+        const auto N = static_cast<int>(fir.size());
+        const auto half = N / 2;
+
+        for( int i = 0; i < numSamples; ++i )
+        {
+            buf[N - 1] = 2.f * input[i];
+
+            auto out = 0.f;
+            for( int k = 0; k < half; k += 2 )
+                out += (buf[k] + buf[N - k - 1]) * fir[static_cast<size_t>(k)];
+
+            output[i << 1] = out;
+            output[(i << 1) + 1] = buf[half + 1] * fir[static_cast<size_t>(half)];
+
+            for( int k = 0; k < N - 2; k += 2 )
+                buf[k] = buf[k + 2];
+        }
+    }
+
+    //the even samples go through the taps, the odd ones only meet the centre tap, a short ring
+    static void downFIR(const std::vector<float>& fir, float* buf, float* centre, int& position,
+                        const float* input, float* output, int numSamples) noexcept
+    {
+        const auto N = static_cast<int>(fir.size());
+        const auto half = N / 2;
+        const auto quarter = half / 2;
+        auto pos = position;
+
+        for( int i = 0; i < numSamples; ++i )
+        {
+            buf[N - 1] = input[i << 1];
+
+            auto out = 0.f;
+            for( int k = 0; k < half; k += 2 )
+                out += (buf[k] + buf[N - k - 1]) * fir[static_cast<size_t>(k)];
+
+            out += centre[pos] * fir[static_cast<size_t>(half)];
+            centre[pos] = input[(i << 1) + 1];
+            output[i] = out;
+
+            for( int k = 0; k < N - 2; ++k )
+                buf[k] = buf[k + 2];
+
+            pos = pos == 0 ? quarter : pos - 1;
+        }
+
+        position = pos;
+    }
+
+    static float allpass(float alpha, float& state, float input) noexcept
+    {
+        auto output = alpha * input + state;
+        state = input - alpha * output;
+        return output;
+    }
+
+    //two allpass chains, one per output phase
+    static void upIIR(const std::vector<float>& alphas, int numDirect, float* state, const float* input, float* output, int numSamples) noexcept
+    {
+        const auto numAlphas = static_cast<int>(alphas.size());
+
+        for( int i = 0; i < numSamples; ++i )
+        {
+            auto direct = input[i];
+            for( int n = 0; n < numDirect; ++n )
+                direct = allpass(alphas[static_cast<size_t>(n)], state[n], direct);
+
+            auto delayed = input[i];
+            for( int n = numDirect; n < numAlphas; ++n )
+                delayed = allpass(alphas[static_cast<size_t>(n)], state[n], delayed);
+
+            output[i << 1] = direct;
+            output[(i << 1) + 1] = delayed;
+        }
+
+        for( int n = 0; n < numAlphas; ++n )
+            juce::dsp::util::snapToZero(state[n]);
+    }
+
+    static void downIIR(const std::vector<float>& alphas, int numDirect, float* state, float& delayedOutput,
+                        const float* input, float* output, int numSamples) noexcept
+    {
+        const auto numAlphas = static_cast<int>(alphas.size());
+
+        for( int i = 0; i < numSamples; ++i )
+        {
+            auto direct = input[i << 1];
+            for( int n = 0; n < numDirect; ++n )
+                direct = allpass(alphas[static_cast<size_t>(n)], state[n], direct);
+
+            auto delayed = input[(i << 1) + 1];
+            for( int n = numDirect; n < numAlphas; ++n )
+                delayed = allpass(alphas[static_cast<size_t>(n)], state[n], delayed);
+
+            output[i] = 0.5f * (direct + delayedOutput);
+            delayedOutput = delayed;
+        }
+
+        for( int n = 0; n < numAlphas; ++n )
+            juce::dsp::util::snapToZero(state[n]);
+    }
+
+    std::shared_ptr<const OversamplingKernels> kernels;
+    std::vector<StageState> stages;
+    std::array<float, numChannels> thiranState {};
+    float thiranAlpha = 0.f;
+    bool useThiran = false;
+    int exponent = 0;
+    int latency = 0;
+};
@@ -0,0 +1,245 @@
+/*
+  ==============================================================================
+
+    CoefficientCache.h
+    quantized biquad design + cache for the general filter.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SharedResources.h"
+
+enum class GeneralFilterMode
+{
+    Peak,
+    Bandpass,
+    Notch,
+    Allpass,
+    END_OF_LIST
+};
+
+//normalized b0, b1, b2, a1, a2. same layout as IIR::Coefficients::coefficients for a 2nd order filter
+using BiquadCoefficients = std::array<float, 5>;
+
+/*
+ the smoothers move freq/Q/gain a little every sub block, and every one of those
+ steps used to be a full trig evaluation + a heap allocated Coefficients object.
+ the inputs are quantized first (5 cents, 0.01 Q, 0.05 dB) so an automation sweep
+ keeps landing on the same keys, and a miss is designed from the sin and dB
+ tables instead of std::tan / std::pow.
+ quantizing before designing means a hit and a miss give identical coefficients.
+ nothing in here allocates after construction. the tables are read-only and the same
+ for every cache, so they're one SharedResources entry for the whole process.
+ designExact() is the same design without any of that, for render quality.
+*/
+struct CoefficientCache
+{
+    CoefficientCache() : tables(DesignTables::get())
+    {
+        clear();
+    }
+
+    void clear() noexcept
+    {
+        for( auto& e : entries )
+            e.key = emptyKey;
+
+        hits = 0;
+        misses = 0;
+    }
+
+    const BiquadCoefficients& get(GeneralFilterMode mode, float freq, float q, float gainDb, double sampleRate) noexcept
+    {
+        jassert(mode != GeneralFilterMode::END_OF_LIST);
+
+        auto srKey = static_cast<uint64_t>(juce::roundToInt(sampleRate)) & 0x3fffff;
+        auto modeKey = static_cast<uint64_t>(mode);
+
+        auto freqIndex = juce::jlimit(0, 0xffff, juce::roundToInt(std::log2(juce::jmax(freq, minFreq) / minFreq) * freqStepsPerOctave));
+        auto qIndex = juce::jlimit(0, 0xfff, juce::roundToInt((q - minQ) / qStep));
+        //only the peak filter uses gain, so keep it out of the key for the other modes
+        auto gainIndex = mode == GeneralFilterMode::Peak ?
+                         juce::jlimit(0, numGainSteps - 1, juce::roundToInt((gainDb - minGainDb) / gainStepDb)) :
+                         0;
+
+        auto key = (srKey << 42)
+                 | (modeKey << 39)
+                 | (static_cast<uint64_t>(freqIndex) << 23)
+                 | (static_cast<uint64_t>(qIndex) << 11)
+                 | static_cast<uint64_t>(gainIndex);
+
+        //2 way set associative, most recently designed entry goes in the first slot
+        auto set = static_cast<size_t>(hash(key) & (numEntries - 1)) & ~size_t(1);
+        auto& first = entries[set];
+        auto& second = entries[set + 1];
+
+        if( first.key == key )
+        {
+            ++hits;
+            return first.coefficients;
+        }
+
+        if( second.key == key )
+        {
+            ++hits;
+            return second.coefficients;
+        }
+
+        ++misses;
+        second = first;
+
+        auto& entry = first;
+        entry.key = key;
+
+        auto quantizedFreq = minFreq * std::exp2(static_cast<float>(freqIndex) / freqStepsPerOctave);
+        auto quantizedQ = minQ + static_cast<float>(qIndex) * qStep;
+        design<float>(entry.coefficients, mode, quantizedFreq, quantizedQ, tables->gain[static_cast<size_t>(gainIndex)], sampleRate,
+                      [this](float x) { return fastSin(x); }, [this](float x) { return fastCos(x); });
+
+        return entry.coefficients;
+    }
+
+    //the values as they are, designed in double with std::sin / std::cos. no cache, no tables
+    static BiquadCoefficients designExact(GeneralFilterMode mode, float freq, float q, float gainDb, double sampleRate) noexcept
+    {
+        jassert(mode != GeneralFilterMode::END_OF_LIST);
+
+        BiquadCoefficients c;
+        design<double>(c, mode, freq, q, juce::Decibels::decibelsToGain(static_cast<double>(gainDb)), sampleRate,
+                       [](double x) { return std::sin(x); }, [](double x) { return std::cos(x); });
+        return c;
+    }
+
+    int getNumHits() const noexcept { return hits; }
+    int getNumMisses() const noexcept { return misses; }
+
+private:
+    //same formulas as juce::dsp::IIR::Coefficients::make*, in T, with whatever sin / cos it's given
+    template<typename T, typename Sin, typename Cos>
+    static void design(BiquadCoefficients& c, GeneralFilterMode mode, T freq, T q, T gainFactor, double sampleRate, Sin sin, Cos cos) noexcept
+    {
+        const auto rate = static_cast<T>(sampleRate);
+        auto nyquistSafeFreq = juce::jmin(juce::jmax(freq, T(2)), static_cast<T>(sampleRate * 0.499));
+        T b0 = 1, b1 = 0, b2 = 0, a0 = 1, a1 = 0, a2 = 0;
+
+        if( mode == GeneralFilterMode::Peak )
+        {
+            auto omega = juce::MathConstants<T>::twoPi * nyquistSafeFreq / rate;
+            auto A = std::sqrt(juce::jmax(T(0), gainFactor));
+            auto alpha = sin(omega) / (q * T(2));
+            auto c2 = T(-2) * cos(omega);
+
+            b0 = T(1) + alpha * A;
+            b1 = c2;
+            b2 = T(1) - alpha * A;
+            a0 = T(1) + alpha / A;
+            a1 = c2;
+            a2 = T(1) - alpha / A;
+        }
+        else
+        {
+            auto theta = juce::MathConstants<T>::pi * nyquistSafeFreq / rate;
+            //1 / tan
+            auto n = cos(theta) / sin(theta);
+            auto nSquared = n * n;
+            auto invQ = T(1) / q;
+            auto c1 = T(1) / (T(1) + invQ * n + nSquared);
+
+            a1 = c1 * T(2) * (T(1) - nSquared);
+            a2 = c1 * (T(1) - invQ * n + nSquared);
+
+            switch( mode )
+            {
+                case GeneralFilterMode::Bandpass:
+                    b0 = c1 * n * invQ;
+                    b1 = T(0);
+                    b2 = -c1 * n * invQ;
+                    break;
+                case GeneralFilterMode::Notch:
+                    b0 = c1 * (T(1) + nSquared);
+                    b1 = T(2) * c1 * (T(1) - nSquared);
+                    b2 = c1 * (T(1) + nSquared);
+                    break;
+                case GeneralFilterMode::Allpass:
+                    b0 = a2;
+                    b1 = a1;
+                    b2 = T(1);
+                    break;
+                case GeneralFilterMode::Peak:
+                case GeneralFilterMode::END_OF_LIST:
+                    jassertfalse;
+                    break;
+            }
+        }
+
+        auto a0inv = T(1) / a0;
+        c = { static_cast<float>(b0 * a0inv), static_cast<float>(b1 * a0inv), static_cast<float>(b2 * a0inv),
+              static_cast<float>(a1 * a0inv), static_cast<float>(a2 * a0inv) };
+    }
+
+    float fastSin(float x) const noexcept
+    {
+        auto index = x * (sinTableSize / juce::MathConstants<float>::twoPi);
+        auto i = static_cast<int>(std::floor(index));
+        auto frac = index - static_cast<float>(i);
+        auto i0 = static_cast<size_t>(i & (sinTableSize - 1));
+        auto i1 = static_cast<size_t>((i + 1) & (sinTableSize - 1));
+        const auto& sinTable = tables->sin;
+        return sinTable[i0] + frac * (sinTable[i1] - sinTable[i0]);
+    }
+
+    float fastCos(float x) const noexcept { return fastSin(x + juce::MathConstants<float>::halfPi); }
+
+    static uint64_t hash(uint64_t key) noexcept
+    {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return key;
+    }
+
+    static constexpr int sinTableSize = 4096;
+    static constexpr int numGainSteps = 1921; // -48 to +48 dB in 0.05 dB steps
+    static constexpr size_t numEntries = 1024;
+    static constexpr uint64_t emptyKey = ~uint64_t(0);
+
+    static constexpr float minFreq = 10.f;
+    static constexpr float freqStepsPerOctave = 240.f; // 5 cents
+    static constexpr float minQ = 0.05f;
+    static constexpr float qStep = 0.01f;
+    static constexpr float minGainDb = -48.f;
+    static constexpr float gainStepDb = 0.05f;
+
+    struct Entry
+    {
+        uint64_t key;
+        BiquadCoefficients coefficients;
+    };
+
+    struct DesignTables
+    {
+        DesignTables()
+        {
+            for( size_t i = 0; i < sin.size(); ++i )
+                sin[i] = static_cast<float>(std::sin(juce::MathConstants<double>::twoPi * static_cast<double>(i) / sinTableSize));
+
+            for( size_t i = 0; i < gain.size(); ++i )
+                gain[i] = juce::Decibels::decibelsToGain(minGainDb + static_cast<float>(i) * gainStepDb);
+        }
+
+        static std::shared_ptr<const DesignTables> get()
+        {
+            return SharedResources::get<DesignTables>("biquad design", [] { return std::make_shared<DesignTables>(); });
+        }
+
+        std::array<float, sinTableSize> sin;
+        std::array<float, numGainSteps> gain;
+    };
+
+    std::array<Entry, numEntries> entries;
+    std::shared_ptr<const DesignTables> tables;
+    int hits = 0, misses = 0;
+};
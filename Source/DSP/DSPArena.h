@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    DSPArena.h
+    one cache aligned block holding the per channel dsp state of every chain.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <type_traits>
+
+/*
+ the delay lines, filter states and scratch buffers of every chain come out of one
+ allocation, in the order the chains are laid out, instead of a vector each. a chain's
+ state sits on consecutive cache lines and the next chain's follows straight after it,
+ so the prefetcher can stream through a whole sub block's worth of processing.
+
+ build() calls the layout function twice. the first pass only adds up the sizes (take()
+ returns nullptr), then the block is allocated and the second pass hands it out, so
+ every user just calls take() in its layoutArena() and keeps the pointers:
+
+    void layoutArena(DSPArena& arena, const juce::dsp::ProcessSpec& spec)
+    {
+        buffer = arena.take<float>(spec.maximumBlockSize);
+    }
+
+ every take() starts on a new cache line, and the memory is zeroed. only trivially
+ copyable types, nothing is constructed or destroyed. message thread only, and only
+ while the audio thread is stopped (prepareToPlay): build() frees the previous block.
+
+ setScattered(true) gives every take() its own allocation instead, like a vector per
+ buffer. that's only there so the render tool can measure what the arena saves.
+*/
+struct DSPArena
+{
+    static constexpr size_t alignment = 64;
+
+    template<typename LayoutFunc>
+    void build(LayoutFunc&& layout)
+    {
+        storage.reset();
+        scatteredBlocks.clear();
+
+        sizing = true;
+        used = 0;
+        layout(*this);
+
+        numBytes = used;
+        if( ! scattered && numBytes > 0 )
+            storage.reset(new CacheLine[numBytes / alignment]());
+
+        sizing = false;
+        used = 0;
+        layout(*this);
+        jassert(used == numBytes); // the two passes have to ask for the same
+    }
+
+    template<typename T>
+    T* take(size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>);
+        static_assert(alignof(T) <= alignment);
+
+        const auto bytes = (count * sizeof(T) + alignment - 1) / alignment * alignment;
+        const auto offset = used;
+        used += bytes;
+
+        if( sizing || bytes == 0 )
+            return nullptr;
+
+        if( scattered )
+        {
+            scatteredBlocks.push_back(std::unique_ptr<CacheLine[]>(new CacheLine[bytes / alignment]()));
+            return reinterpret_cast<T*>(scatteredBlocks.back().get());
+        }
+
+        return reinterpret_cast<T*>(reinterpret_cast<std::byte*>(storage.get()) + offset);
+    }
+
+    void setScattered(bool shouldScatter) noexcept { scattered = shouldScatter; }
+    size_t getSizeInBytes() const noexcept { return numBytes; }
+
+private:
+    struct alignas(alignment) CacheLine
+    {
+        std::byte bytes[alignment];
+    };
+
+    std::unique_ptr<CacheLine[]> storage;
+    std::vector<std::unique_ptr<CacheLine[]>> scatteredBlocks;
+    size_t used = 0, numBytes = 0;
+    bool sizing = false, scattered = false;
+};
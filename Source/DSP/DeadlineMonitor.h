@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+
+    DeadlineMonitor.h
+    processBlock cost vs. its real time deadline, as a lock-free histogram.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ every block is timed against numSamples / sampleRate and its load (time / deadline)
+ goes into a histogram with 1% bins. the audio thread is the only writer, so the
+ counters are plain relaxed atomics, and the editor or a dump can read them at any time.
+
+    near miss   load >= 80%, a little more work somewhere else and the host would glitch
+    overrun     load >= 100%, this block on its own was late
+
+ reset() from the message thread only raises a flag, the audio thread does the clearing.
+*/
+struct DeadlineMonitor
+{
+    static constexpr int numBins = 200; // the last bin is everything >= 199%
+    static constexpr float nearMissLoad = 0.8f;
+
+    struct Snapshot
+    {
+        uint64_t numBlocks = 0, nearMisses = 0, overruns = 0;
+        float p50 = 0.f, p95 = 0.f, p99 = 0.f, max = 0.f;
+    };
+
+    //times one processBlock, whichever way it returns
+    struct ScopedBlock
+    {
+        ScopedBlock(DeadlineMonitor& m, int samples) noexcept
+            : monitor(m), numSamples(samples), startTicks(juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedBlock() noexcept { monitor.addBlock(juce::Time::getHighResolutionTicks() - startTicks, numSamples); }
+
+        DeadlineMonitor& monitor;
+        int numSamples;
+        juce::int64 startTicks;
+    };
+
+    void prepare(double newSampleRate) noexcept
+    {
+        sampleRate.store(newSampleRate);
+        reset();
+    }
+
+    void reset() noexcept { resetRequested.store(true); }
+
+    //audio thread
+    void addBlock(juce::int64 elapsedTicks, int numSamples) noexcept
+    {
+        auto rate = sampleRate.load(std::memory_order_relaxed);
+        if( numSamples <= 0 || rate <= 0.0 )
+            return;
+
+        if( resetRequested.exchange(false) )
+        {
+            for( auto& bin : bins )
+                bin.store(0, std::memory_order_relaxed);
+
+            nearMisses.store(0, std::memory_order_relaxed);
+            overruns.store(0, std::memory_order_relaxed);
+            maxLoad.store(0.f, std::memory_order_relaxed);
+        }
+
+        auto deadlineTicks = numSamples / rate * static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+        auto load = static_cast<float>(static_cast<double>(elapsedTicks) / deadlineTicks);
+
+        auto bin = juce::jlimit(0, numBins - 1, static_cast<int>(load * 100.f));
+        increment(bins[static_cast<size_t>(bin)]);
+
+        if( load >= nearMissLoad )
+            increment(nearMisses);
+
+        if( load >= 1.f )
+            increment(overruns);
+
+        if( load > maxLoad.load(std::memory_order_relaxed) )
+            maxLoad.store(load, std::memory_order_relaxed);
+    }
+
+    //any thread. the counts can be a block apart from each other, which doesn't matter here
+    Snapshot getSnapshot() const noexcept
+    {
+        Snapshot s;
+        std::array<uint64_t, numBins> counts;
+        uint64_t total = 0;
+
+        for( size_t i = 0; i < counts.size(); ++i )
+        {
+            counts[i] = bins[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+
+        s.numBlocks = total;
+        s.nearMisses = nearMisses.load(std::memory_order_relaxed);
+        s.overruns = overruns.load(std::memory_order_relaxed);
+        s.max = maxLoad.load(std::memory_order_relaxed);
+
+        if( total == 0 )
+            return s;
+
+        //upper edge of the bin the percentile lands in
+        auto percentile = [&counts, total](double p)
+        {
+            auto target = static_cast<uint64_t>(std::ceil(p * static_cast<double>(total)));
+            uint64_t running = 0;
+            for( size_t i = 0; i < counts.size(); ++i )
+            {
+                running += counts[i];
+                if( running >= target )
+                    return static_cast<float>(i + 1) * 0.01f;
+            }
+            return static_cast<float>(numBins) * 0.01f;
+        };
+
+        s.p50 = percentile(0.5);
+        s.p95 = percentile(0.95);
+        s.p99 = percentile(0.99);
+        return s;
+    }
+
+    //message thread, for when a client reports crackles
+    bool writeToFile(const juce::File& file) const
+    {
+        auto snapshot = getSnapshot();
+
+        auto* json = new juce::DynamicObject();
+        json->setProperty("sampleRate", sampleRate.load());
+        json->setProperty("numBlocks", static_cast<juce::int64>(snapshot.numBlocks));
+        json->setProperty("nearMisses", static_cast<juce::int64>(snapshot.nearMisses));
+        json->setProperty("overruns", static_cast<juce::int64>(snapshot.overruns));
+        json->setProperty("p50Load", snapshot.p50);
+        json->setProperty("p95Load", snapshot.p95);
+        json->setProperty("p99Load", snapshot.p99);
+        json->setProperty("maxLoad", snapshot.max);
+
+        //bin i counts the blocks with a load in [i%, i + 1%)
+        juce::Array<juce::var> histogram;
+        for( auto& bin : bins )
+            histogram.add(static_cast<juce::int64>(bin.load(std::memory_order_relaxed)));
+        json->setProperty("histogram", histogram);
+
+        return file.replaceWithText(juce::JSON::toString(juce::var(json)));
+    }
+
+private:
+    //single writer, so no read-modify-write needed
+    static void increment(std::atomic<uint64_t>& counter) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, numBins> bins {};
+    std::atomic<uint64_t> nearMisses { 0 }, overruns { 0 };
+    std::atomic<float> maxLoad { 0.f };
+    std::atomic<double> sampleRate { 0.0 };
+    std::atomic<bool> resetRequested { false };
+};
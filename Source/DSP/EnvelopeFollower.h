@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    EnvelopeFollower.h
+    control rate envelope of the input, for the auto-wah / dynamic filter.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//order has to match envelopeTargetChoices
+enum class EnvelopeTarget
+{
+    Off,
+    LadderCutoff,
+    GeneralFilterFreq,
+    END_OF_LIST
+};
+
+/*
+ runs once per control block (64 samples, 1 while rendering) on the sum of squares that
+ the input meter pass (MidSide::encode/measure) already produced, so it never touches the
+ samples itself. the block's rms goes through an attack/release one pole whose coefficient
+ is worked out for the block's length, so the times hold whatever the length is.
+
+ getAmount() maps the envelope from -60..0 dBFS onto 0..1, and a target frequency is
+ moved by depth octaves at an amount of 1.
+*/
+struct EnvelopeFollower
+{
+    static constexpr float floorDecibels = -60.f;
+
+    void prepare(double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+        cachedNumSamples = -1;
+        reset();
+    }
+
+    void reset() noexcept { envelope = 0.f; }
+
+    void setAttackMs(float newAttackMs) noexcept
+    {
+        if( newAttackMs != attackMs )
+        {
+            attackMs = newAttackMs;
+            cachedNumSamples = -1;
+        }
+    }
+
+    void setReleaseMs(float newReleaseMs) noexcept
+    {
+        if( newReleaseMs != releaseMs )
+        {
+            releaseMs = newReleaseMs;
+            cachedNumSamples = -1;
+        }
+    }
+
+    //sumOfSquares covers numChannels * numSamples samples
+    void process(double sumOfSquares, int numChannels, int numSamples) noexcept
+    {
+        if( numSamples <= 0 || numChannels <= 0 )
+            return;
+
+        updateCoefficients(numSamples);
+
+        auto rms = static_cast<float>(std::sqrt(sumOfSquares / (numChannels * numSamples)));
+        auto coefficient = rms > envelope ? attackCoefficient : releaseCoefficient;
+        envelope = rms + coefficient * (envelope - rms);
+    }
+
+    float getEnvelope() const noexcept { return envelope; }
+
+    float getAmount() const noexcept
+    {
+        auto decibels = juce::Decibels::gainToDecibels(envelope, floorDecibels);
+        return juce::jlimit(0.f, 1.f, 1.f - decibels / floorDecibels);
+    }
+
+    //2^(depth * amount), what the target frequency gets multiplied by
+    float getFrequencyRatio(float depthOctaves) const noexcept { return std::exp2(depthOctaves * getAmount()); }
+
+private:
+    void updateCoefficients(int numSamples) noexcept
+    {
+        //nearly every sub block is the same length, so this is only redone on a change
+        if( numSamples == cachedNumSamples )
+            return;
+
+        cachedNumSamples = numSamples;
+        attackCoefficient = getCoefficient(attackMs, numSamples);
+        releaseCoefficient = getCoefficient(releaseMs, numSamples);
+    }
+
+    float getCoefficient(float timeMs, int numSamples) const noexcept
+    {
+        auto timeSamples = timeMs * 0.001 * sampleRate;
+        return timeSamples > 0.0 ? static_cast<float>(std::exp(-numSamples / timeSamples)) : 0.f;
+    }
+
+    double sampleRate = 44100.0;
+    float attackMs = 10.f, releaseMs = 150.f;
+    float attackCoefficient = 0.f, releaseCoefficient = 0.f;
+    int cachedNumSamples = -1;
+    float envelope = 0.f;
+};
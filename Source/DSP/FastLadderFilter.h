@@ -0,0 +1,327 @@
+/*
+  ==============================================================================
+
+    FastLadderFilter.h
+    juce::dsp::LadderFilter with a selectable saturation curve.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FastMath.h"
+#include "DSPArena.h"
+#include "SIMDLanes.h"
+
+/*
+ same topology and coefficients as juce::dsp::LadderFilter. the only difference is
+ the saturation curve, which is picked per block so the inner loop has no branch in
+ it. juce's own curve is a 128 point tanh table, so no quality here reproduces juce
+ exactly: Precise is the real tanh, Normal is within 1.4e-5 of it (see FastMath.h).
+ the per channel state comes from the DSPArena, layoutArena() has to run before prepare().
+ the cutoff glides over defaultCutoffRampSeconds like juce's, unless setCutoffRampSeconds()
+ says otherwise: a cutoff that's already smoothed upstream and updated every control block
+ only needs to be interpolated across that block, not lagged another 50 ms behind.
+ processLanes() runs mono float filters side by side in SIMDRegister lanes: the smoothers
+ and the saturation stay scalar per lane, the ladder stages run in the registers.
+*/
+template<typename SampleType>
+struct FastLadderFilter
+{
+    using Mode = juce::dsp::LadderFilterMode;
+
+    static constexpr SampleType defaultCutoffRampSeconds = SampleType(0.05);
+
+    FastLadderFilter() : tanhTable(FastMath::getTanhTable<SampleType>())
+    {
+        setSampleRate(SampleType(1000));
+        setResonance(SampleType(0));
+        setDrive(SampleType(1.2));
+        mode = Mode::LPF24;
+        setMode(Mode::LPF12);
+    }
+
+    void setEnabled(bool isEnabled) noexcept { enabled = isEnabled; }
+    bool isEnabled() const noexcept { return enabled; }
+    void setSaturationQuality(SaturationQuality newQuality) noexcept { quality = newQuality; }
+
+    void setMode(Mode newMode) noexcept
+    {
+        if( mode == newMode )
+            return;
+
+        switch( newMode )
+        {
+            case Mode::LPF12: A = {{ SampleType(0), SampleType(0),  SampleType(1),  SampleType(0),  SampleType(0) }}; comp = SampleType(0.5); break;
+            case Mode::HPF12: A = {{ SampleType(1), SampleType(-2), SampleType(1),  SampleType(0),  SampleType(0) }}; comp = SampleType(0);   break;
+            case Mode::BPF12: A = {{ SampleType(0), SampleType(0),  SampleType(-1), SampleType(1),  SampleType(0) }}; comp = SampleType(0.5); break;
+            case Mode::LPF24: A = {{ SampleType(0), SampleType(0),  SampleType(0),  SampleType(0),  SampleType(1) }}; comp = SampleType(0.5); break;
+            case Mode::HPF24: A = {{ SampleType(1), SampleType(-4), SampleType(6),  SampleType(-4), SampleType(1) }}; comp = SampleType(0);   break;
+            case Mode::BPF24: A = {{ SampleType(0), SampleType(0),  SampleType(1),  SampleType(-2), SampleType(1) }}; comp = SampleType(0.5); break;
+            default: jassertfalse; break;
+        }
+
+        static constexpr auto outputGain = SampleType(1.2);
+
+        for( auto& a : A )
+            a *= outputGain;
+
+        mode = newMode;
+        reset();
+    }
+
+    void layoutArena(DSPArena& arena, const juce::dsp::ProcessSpec& spec)
+    {
+        numStateChannels = spec.numChannels;
+        state = arena.take<std::array<SampleType, numStates>>(numStateChannels);
+    }
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        jassert(spec.numChannels == numStateChannels); // layoutArena() first, with the same spec
+        setSampleRate(SampleType(spec.sampleRate));
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        for( size_t ch = 0; ch < numStateChannels; ++ch )
+            state[ch].fill(SampleType(0));
+
+        cutoffTransformSmoother.setCurrentAndTargetValue(cutoffTransformSmoother.getTargetValue());
+        scaledResonanceSmoother.setCurrentAndTargetValue(scaledResonanceSmoother.getTargetValue());
+    }
+
+    void setCutoffFrequencyHz(SampleType newCutoff) noexcept
+    {
+        jassert(newCutoff > SampleType(0));
+        cutoffFreqHz = newCutoff;
+        updateCutoffFreq();
+    }
+
+    //a new ramp length lands the glide in progress
+    void setCutoffRampSeconds(SampleType newRampSeconds) noexcept
+    {
+        if( newRampSeconds == cutoffRampSeconds )
+            return;
+
+        cutoffRampSeconds = newRampSeconds;
+        cutoffTransformSmoother.reset(static_cast<double>(sampleRate), static_cast<double>(cutoffRampSeconds));
+    }
+
+    void setResonance(SampleType newResonance) noexcept
+    {
+        jassert(newResonance >= SampleType(0) && newResonance <= SampleType(1));
+        resonance = newResonance;
+        updateResonance();
+    }
+
+    void setDrive(SampleType newDrive) noexcept
+    {
+        jassert(newDrive >= SampleType(1));
+        drive = newDrive;
+        gain = std::pow(drive, SampleType(-2.642)) * SampleType(0.6103) + SampleType(0.3903);
+        drive2 = drive * SampleType(0.04) + SampleType(0.96);
+        gain2 = std::pow(drive2, SampleType(-2.642)) * SampleType(0.6103) + SampleType(0.3903);
+    }
+
+    template<typename ProcessContext>
+    void process(const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+
+        jassert(inputBlock.getNumChannels() <= numStateChannels);
+        jassert(inputBlock.getNumChannels() == outputBlock.getNumChannels());
+        jassert(inputBlock.getNumSamples() == outputBlock.getNumSamples());
+
+        if( ! enabled || context.isBypassed )
+        {
+            outputBlock.copyFrom(inputBlock);
+            return;
+        }
+
+        switch( quality )
+        {
+            case SaturationQuality::Eco:     processWith<SaturationQuality::Eco>(inputBlock, outputBlock); break;
+            case SaturationQuality::Normal:  processWith<SaturationQuality::Normal>(inputBlock, outputBlock); break;
+            case SaturationQuality::Precise: processWith<SaturationQuality::Precise>(inputBlock, outputBlock); break;
+            case SaturationQuality::END_OF_LIST: jassertfalse; break;
+        }
+    }
+
+    //filters[i] over lane i of the frames, each a mono, enabled filter with its own settings
+    //and state. the quality is the first one's, the lanes all come from one parameter
+    static void processLanes(const std::array<FastLadderFilter*, SIMDLanes::width>& filters, size_t numLanes,
+                             SIMDLanes::Register* frames, size_t numFrames) noexcept
+    {
+        static_assert(std::is_same_v<SampleType, float>, "the lanes are float registers");
+        jassert(numLanes > 0);
+
+        switch( filters[0]->quality )
+        {
+            case SaturationQuality::Eco:     processLanesWith<SaturationQuality::Eco>(filters, numLanes, frames, numFrames); break;
+            case SaturationQuality::Normal:  processLanesWith<SaturationQuality::Normal>(filters, numLanes, frames, numFrames); break;
+            case SaturationQuality::Precise: processLanesWith<SaturationQuality::Precise>(filters, numLanes, frames, numFrames); break;
+            case SaturationQuality::END_OF_LIST: jassertfalse; break;
+        }
+    }
+
+private:
+    template<SaturationQuality Q>
+    static void processLanesWith(const std::array<FastLadderFilter*, SIMDLanes::width>& filters, size_t numLanes,
+                                 SIMDLanes::Register* frames, size_t numFrames) noexcept
+    {
+        using Register = SIMDLanes::Register;
+        auto gather = [&](auto get) { return SIMDLanes::gather(numLanes, get); };
+
+        for( size_t i = 0; i < numLanes; ++i )
+            jassert(filters[i]->numStateChannels == 1 && filters[i]->enabled && filters[i]->quality == Q);
+
+        const auto comp = gather([&](size_t i) { return filters[i]->comp; });
+        std::array<Register, numStates> A, s;
+        for( size_t j = 0; j < numStates; ++j )
+        {
+            A[j] = gather([&](size_t i) { return filters[i]->A[j]; });
+            s[j] = gather([&](size_t i) { return filters[i]->state[0][j]; });
+        }
+
+        for( size_t n = 0; n < numFrames; ++n )
+        {
+            //what processSample() works out per channel before the ladder
+            const auto a1 = gather([&](size_t i)
+            {
+                auto& f = *filters[i];
+                f.cutoffTransformValue = f.cutoffTransformSmoother.getNextValue();
+                f.scaledResonanceValue = f.scaledResonanceSmoother.getNextValue();
+                return f.cutoffTransformValue;
+            });
+            const auto resonance = gather([&](size_t i) { return filters[i]->scaledResonanceValue; });
+            const auto dx = gather([&](size_t i)
+            {
+                auto& f = *filters[i];
+                return f.gain * f.template saturate<Q>(f.drive * frames[n].get(i));
+            });
+            const auto feedback = gather([&](size_t i)
+            {
+                auto& f = *filters[i];
+                return f.gain2 * f.template saturate<Q>(f.drive2 * s[4].get(i));
+            });
+
+            const auto g = a1 * SampleType(-1) + SampleType(1);
+            const auto b0 = g * SampleType(0.76923076923);
+            const auto b1 = g * SampleType(0.23076923076);
+
+            const auto a = dx + resonance * SampleType(-4) * (feedback - dx * comp);
+
+            const auto b = b1 * s[0] + a1 * s[1] + b0 * a;
+            const auto c = b1 * s[1] + a1 * s[2] + b0 * b;
+            const auto d = b1 * s[2] + a1 * s[3] + b0 * c;
+            const auto e = b1 * s[3] + a1 * s[4] + b0 * d;
+
+            s[0] = a;
+            s[1] = b;
+            s[2] = c;
+            s[3] = d;
+            s[4] = e;
+
+            frames[n] = a * A[0] + b * A[1] + c * A[2] + d * A[3] + e * A[4];
+        }
+
+        for( size_t i = 0; i < numLanes; ++i )
+            for( size_t j = 0; j < numStates; ++j )
+                filters[i]->state[0][j] = s[j].get(i);
+    }
+
+    template<SaturationQuality Q>
+    SampleType saturate(SampleType x) const noexcept
+    {
+        if constexpr( Q == SaturationQuality::Eco )
+            return FastMath::tanhRational(x);
+        else if constexpr( Q == SaturationQuality::Normal )
+            return (*tanhTable)(x);
+        else
+            return std::tanh(x);
+    }
+
+    template<SaturationQuality Q, typename InBlock, typename OutBlock>
+    void processWith(const InBlock& inputBlock, OutBlock& outputBlock) noexcept
+    {
+        const auto numChannels = outputBlock.getNumChannels();
+        const auto numSamples = outputBlock.getNumSamples();
+
+        for( size_t n = 0; n < numSamples; ++n )
+        {
+            cutoffTransformValue = cutoffTransformSmoother.getNextValue();
+            scaledResonanceValue = scaledResonanceSmoother.getNextValue();
+
+            for( size_t ch = 0; ch < numChannels; ++ch )
+                outputBlock.getChannelPointer(ch)[n] = processSample<Q>(inputBlock.getChannelPointer(ch)[n], ch);
+        }
+    }
+
+    template<SaturationQuality Q>
+    SampleType processSample(SampleType inputValue, size_t channelToUse) noexcept
+    {
+        auto& s = state[channelToUse];
+
+        const auto a1 = cutoffTransformValue;
+        const auto g = a1 * SampleType(-1) + SampleType(1);
+        const auto b0 = g * SampleType(0.76923076923);
+        const auto b1 = g * SampleType(0.23076923076);
+
+        const auto dx = gain * saturate<Q>(drive * inputValue);
+        const auto a = dx + scaledResonanceValue * SampleType(-4) * (gain2 * saturate<Q>(drive2 * s[4]) - dx * comp);
+
+        const auto b = b1 * s[0] + a1 * s[1] + b0 * a;
+        const auto c = b1 * s[1] + a1 * s[2] + b0 * b;
+        const auto d = b1 * s[2] + a1 * s[3] + b0 * c;
+        const auto e = b1 * s[3] + a1 * s[4] + b0 * d;
+
+        s[0] = a;
+        s[1] = b;
+        s[2] = c;
+        s[3] = d;
+        s[4] = e;
+
+        return a * A[0] + b * A[1] + c * A[2] + d * A[3] + e * A[4];
+    }
+
+    void setSampleRate(SampleType newValue) noexcept
+    {
+        jassert(newValue > SampleType(0));
+        cutoffFreqScaler = SampleType(-2.0 * juce::MathConstants<double>::pi) / newValue;
+
+        sampleRate = newValue;
+        cutoffTransformSmoother.reset(newValue, cutoffRampSeconds);
+        scaledResonanceSmoother.reset(newValue, defaultCutoffRampSeconds);
+
+        updateCutoffFreq();
+    }
+
+    void updateCutoffFreq() noexcept { cutoffTransformSmoother.setTargetValue(std::exp(cutoffFreqHz * cutoffFreqScaler)); }
+    void updateResonance() noexcept { scaledResonanceSmoother.setTargetValue(juce::jmap(resonance, SampleType(0.1), SampleType(1.0))); }
+
+    std::shared_ptr<const FastMath::TanhTable<SampleType>> tanhTable;
+    SaturationQuality quality = SaturationQuality::Normal;
+
+    SampleType drive, drive2, gain, gain2, comp;
+
+    static constexpr size_t numStates = 5;
+    std::array<SampleType, numStates>* state = nullptr;
+    size_t numStateChannels = 0;
+    std::array<SampleType, numStates> A;
+
+    juce::SmoothedValue<SampleType> cutoffTransformSmoother, scaledResonanceSmoother;
+    SampleType cutoffTransformValue, scaledResonanceValue;
+
+    SampleType sampleRate = SampleType(1000);
+    SampleType cutoffRampSeconds = defaultCutoffRampSeconds;
+    SampleType cutoffFreqHz { SampleType(200) };
+    SampleType resonance;
+    SampleType cutoffFreqScaler;
+
+    Mode mode;
+    bool enabled = true;
+};
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    FastMath.h
+    tanh-style saturation curves with selectable accuracy.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SharedResources.h"
+
+/*
+ quality levels for the saturation stage inside the ladder filters.
+ max abs error over [-10, 10] (step 1e-5) and ns/sample, float, -O2 x86-64,
+ from AudioProRender saturation:
+
+    mode      curve                          vs std::tanh   vs juce's LUT   ns/sample
+    Eco       [3/2] rational, clamped at |3|   2.4e-2         2.4e-2          ~1.1
+    Normal    1024 point table, linear interp  1.4e-5         5.9e-4          ~2.1
+    Precise   std::tanh                         0             6.0e-4          ~20.7
+    (juce     128 point table over [-5, 5]     6.0e-4          0              ~2.6)
+
+ juce::dsp::LadderFilter saturates through that last one, a clamped, linearly
+ interpolated LookupTableTransform, so none of the three is bit for bit juce's sound.
+ Normal and Precise are both closer to a real tanh than juce is.
+
+ the overdrive and ladder saturate every sample (twice per sample with
+ resonance), so this is where most of their cost goes.
+*/
+enum class SaturationQuality
+{
+    Eco,
+    Normal,
+    Precise,
+    END_OF_LIST
+};
+
+namespace FastMath
+{
+    //[3/2] pade of tanh, exact at 0 and hits +-1 with zero slope at +-3
+    template<typename SampleType>
+    inline SampleType tanhRational(SampleType x) noexcept
+    {
+        x = juce::jlimit(SampleType(-3), SampleType(3), x);
+        const auto x2 = x * x;
+        return x * (SampleType(27) + x2) / (SampleType(27) + SampleType(9) * x2);
+    }
+
+    //tanh sampled over [-6, 6], anything outside is within 1.3e-5 of +-1 anyway
+    template<typename SampleType>
+    struct TanhTable
+    {
+        static constexpr int numPoints = 1024;
+        static constexpr SampleType minInput = SampleType(-6);
+        static constexpr SampleType maxInput = SampleType(6);
+
+        TanhTable()
+        {
+            for( int i = 0; i <= numPoints; ++i )
+            {
+                auto x = minInput + (maxInput - minInput) * static_cast<SampleType>(i) / static_cast<SampleType>(numPoints);
+                table[static_cast<size_t>(i)] = std::tanh(x);
+            }
+        }
+
+        SampleType operator()(SampleType x) const noexcept
+        {
+            //the clamp keeps index + 1 inside the table
+            auto index = juce::jlimit(SampleType(0),
+                                      static_cast<SampleType>(numPoints) - SampleType(0.0001),
+                                      x * scaler + offset);
+            auto i = static_cast<size_t>(index);
+            auto frac = index - static_cast<SampleType>(i);
+            return table[i] + frac * (table[i + 1] - table[i]);
+        }
+
+    private:
+        static constexpr SampleType scaler = static_cast<SampleType>(numPoints) / (maxInput - minInput);
+        static constexpr SampleType offset = -minInput * scaler;
+        std::array<SampleType, numPoints + 1> table;
+    };
+
+    //one table for every instance in the process, see SharedResources
+    template<typename SampleType>
+    std::shared_ptr<const TanhTable<SampleType>> getTanhTable()
+    {
+        return SharedResources::get<TanhTable<SampleType>>("tanh", [] { return std::make_shared<TanhTable<SampleType>>(); });
+    }
+}
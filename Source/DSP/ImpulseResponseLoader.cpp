@@ -0,0 +1,209 @@
+/*
+  ==============================================================================
+
+    ImpulseResponseLoader.cpp
+
+  ==============================================================================
+*/
+
+#include "ImpulseResponseLoader.h"
+
+ImpulseResponseLoader::ImpulseResponseLoader() : juce::Thread("IR Loader")
+{
+}
+
+ImpulseResponseLoader::~ImpulseResponseLoader()
+{
+    stopThread(2000);
+
+    delete pending.exchange(nullptr);
+    delete retired.exchange(nullptr);
+    delete active;
+}
+
+void ImpulseResponseLoader::requestLoad(const juce::File& file, double sampleRate, int numEngines)
+{
+    //most instances never load an IR, so the thread and the formats wait for the first one.
+    //until then there's nothing active either, so there's nothing to clear
+    if( file == juce::File() && ! started.load() )
+        return;
+
+    //prepareToPlay and setStateInformation can both get here first, and not always on
+    //the same thread, so only one of them registers the formats and starts the thread
+    std::call_once(startOnce, [this]
+    {
+        formatManager.registerBasicFormats();
+        startThread();
+        started = true;
+    });
+
+    {
+        const juce::ScopedLock sl(requestLock);
+        request = { file, sampleRate, numEngines };
+        hasRequest = true;
+        loading = true;
+        failed = false;
+    }
+
+    notify();
+}
+
+bool ImpulseResponseLoader::updateActivePackage(double sampleRate, int numEngines) noexcept
+{
+    //the loader hasn't collected the last one yet, try again next block
+    if( retired.load() != nullptr )
+        return false;
+
+    //taken out before it's looked at, the loader deletes whatever it replaces in pending
+    auto* next = pending.exchange(nullptr);
+    if( next == nullptr )
+        return false;
+
+    if( ! next->matches(sampleRate, numEngines) )
+    {
+        //back it goes, unless a newer one landed in the meantime. then this one is stale
+        ConvolutionPackage* expected = nullptr;
+        if( ! pending.compare_exchange_strong(expected, next) )
+            retired.store(next);
+
+        return false;
+    }
+
+    retired.store(active);
+    active = next;
+    return true;
+}
+
+void ImpulseResponseLoader::releaseActivePackage()
+{
+    delete active;
+    active = nullptr;
+}
+
+bool ImpulseResponseLoader::takePendingPackage(double sampleRate, int numEngines)
+{
+    std::unique_ptr<ConvolutionPackage> next(pending.exchange(nullptr));
+    if( next == nullptr )
+        return false;
+
+    if( ! next->matches(sampleRate, numEngines) )
+        return false;
+
+    delete active;
+    active = next.release();
+    return true;
+}
+
+void ImpulseResponseLoader::run()
+{
+    while( ! threadShouldExit() )
+    {
+        wait(100);
+
+        delete retired.exchange(nullptr);
+
+        Request next;
+        {
+            const juce::ScopedLock sl(requestLock);
+            if( ! hasRequest )
+                continue;
+
+            next = request;
+            hasRequest = false;
+        }
+
+        auto package = build(next);
+        failed = package == nullptr;
+
+        //if the audio thread never took the previous one it's still ours to delete
+        if( package != nullptr && ! threadShouldExit() )
+            delete pending.exchange(package.release());
+
+        //pending is set first, so a render waiting on isLoading() always finds it
+        const juce::ScopedLock sl(requestLock);
+        if( ! hasRequest )
+            loading = false;
+    }
+}
+
+std::unique_ptr<ConvolutionPackage> ImpulseResponseLoader::build(const Request& r)
+{
+    if( r.file == juce::File() )
+        return std::make_unique<ConvolutionPackage>(nullptr, r.numEngines, r.sampleRate, juce::String());
+
+    if( r.sampleRate <= 0.0 )
+        return nullptr;
+
+    //every instance that loads this file at this rate gets the same transformed impulse.
+    //the modification time and size are in the key so an edited file is read again
+    auto key = r.file.getFullPathName()
+             + "|" + juce::String(r.file.getLastModificationTime().toMilliseconds())
+             + "|" + juce::String(r.file.getSize())
+             + "|" + juce::String(r.sampleRate);
+
+    auto impulse = SharedResources::get<ConvolutionImpulse>(key, [this, &r]() -> std::shared_ptr<ConvolutionImpulse>
+    {
+        juce::AudioBuffer<float> buffer;
+        if( ! readImpulse(r, buffer) )
+            return nullptr;
+
+        return std::make_shared<ConvolutionImpulse>(buffer);
+    });
+
+    if( impulse == nullptr )
+        return nullptr;
+
+    return std::make_unique<ConvolutionPackage>(std::move(impulse), r.numEngines, r.sampleRate, r.file.getFileNameWithoutExtension());
+}
+
+bool ImpulseResponseLoader::readImpulse(const Request& r, juce::AudioBuffer<float>& impulse)
+{
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(r.file));
+    if( reader == nullptr )
+    {
+        DBG("ImpulseResponseLoader: couldn't read " << r.file.getFullPathName());
+        return false;
+    }
+
+    const auto numChannels = juce::jmin(2, static_cast<int>(reader->numChannels));
+    const auto numFileSamples = static_cast<int>(juce::jmin(reader->lengthInSamples,
+                                                            static_cast<juce::int64>(maxImpulseSeconds * reader->sampleRate)));
+    if( numChannels == 0 || numFileSamples == 0 )
+        return false;
+
+    //a few zeros past the end, the interpolator reads slightly ahead
+    static constexpr int padding = 8;
+    juce::AudioBuffer<float> fileBuffer(numChannels, numFileSamples + padding);
+    fileBuffer.clear();
+    reader->read(&fileBuffer, 0, numFileSamples, 0, true, numChannels > 1);
+
+    const auto ratio = reader->sampleRate / r.sampleRate;
+    const auto numSamples = static_cast<int>(std::ceil(numFileSamples / ratio));
+    impulse.setSize(numChannels, numSamples);
+
+    for( int ch = 0; ch < numChannels; ++ch )
+    {
+        if( juce::approximatelyEqual(ratio, 1.0) )
+        {
+            impulse.copyFrom(ch, 0, fileBuffer, ch, 0, numSamples);
+        }
+        else
+        {
+            juce::LagrangeInterpolator interpolator;
+            interpolator.process(ratio, fileBuffer.getReadPointer(ch), impulse.getWritePointer(ch), numSamples);
+        }
+    }
+
+    //unit energy on the louder channel, so a cabinet and a long hall come out at a similar level
+    float maxEnergy = 0.f;
+    for( int ch = 0; ch < numChannels; ++ch )
+    {
+        auto rms = impulse.getRMSLevel(ch, 0, numSamples);
+        maxEnergy = juce::jmax(maxEnergy, rms * rms * static_cast<float>(numSamples));
+    }
+
+    if( maxEnergy > 0.f )
+        impulse.applyGain(1.f / std::sqrt(maxEnergy));
+
+    return true;
+}
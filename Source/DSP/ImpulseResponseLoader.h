@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    ImpulseResponseLoader.h
+    background thread that reads, resamples and partitions impulse responses.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PartitionedConvolver.h"
+#include "SharedResources.h"
+
+/*
+ the audio thread never allocates or frees a ConvolutionPackage:
+
+    loader thread  -> builds a package, parks it in 'pending'
+    audio thread   -> updateActivePackage() swaps 'pending' in, parks the old one in 'retired'
+    loader thread  -> deletes whatever is in 'retired' the next time it wakes up
+
+ a new package is only taken once the previous retired one has been collected, so
+ each slot holds at most one package.
+*/
+struct ImpulseResponseLoader : juce::Thread
+{
+    static constexpr double maxImpulseSeconds = 10.0;
+
+    ImpulseResponseLoader();
+    ~ImpulseResponseLoader() override;
+
+    //any thread but the audio thread. an empty file clears the IR. the thread starts with the first load
+    void requestLoad(const juce::File& file, double sampleRate, int numEngines);
+
+    //audio thread. returns true when a new package became active. one built for another
+    //rate or engine count stays parked, it was asked for ahead of a re-prepare
+    bool updateActivePackage(double sampleRate, int numEngines) noexcept;
+    ConvolutionPackage* getActivePackage() const noexcept { return active; }
+
+    //only while the audio thread is stopped, e.g. prepareToPlay()
+    void releaseActivePackage();
+    //same, makes the parked package active if it fits. returns false when there wasn't one
+    bool takePendingPackage(double sampleRate, int numEngines);
+
+    //a request is still being built. once it's false the next updateActivePackage() takes
+    //the result, so offline renders wait on this before their first block
+    bool isLoading() const noexcept { return loading.load(); }
+    //the last request built nothing: the file is missing, unreadable or empty. only
+    //settled once isLoading() is false
+    bool didLastLoadFail() const noexcept { return failed.load(); }
+
+    void run() override;
+
+private:
+    struct Request
+    {
+        juce::File file;
+        double sampleRate = 0.0;
+        int numEngines = 0;
+    };
+
+    std::unique_ptr<ConvolutionPackage> build(const Request& request);
+    //read, resample to the request's rate and normalize
+    bool readImpulse(const Request& request, juce::AudioBuffer<float>& impulse);
+
+    juce::AudioFormatManager formatManager;
+    std::once_flag startOnce;
+    std::atomic<bool> started { false };
+
+    juce::CriticalSection requestLock;
+    Request request;
+    bool hasRequest = false;
+
+    std::atomic<ConvolutionPackage*> pending { nullptr }, retired { nullptr };
+    std::atomic<bool> loading { false }, failed { false };
+    ConvolutionPackage* active = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ImpulseResponseLoader)
+};
@@ -0,0 +1,264 @@
+/*
+  ==============================================================================
+
+    LookaheadLimiter.h
+    stereo linked brickwall limiter with lookahead, for the end of the chain.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DSPArena.h"
+
+/*
+ both channels go through a fixed delay of delaySamples, and one gain for each
+ delayed frame is worked out from the loudest frame still ahead of it:
+
+    level   -> max(|l|, |r|), or |m| + |s| for a mid/side pair, which is the same thing
+    peak    -> sliding max of level over lookahead + 1 samples (monotonic deque, O(1) per sample)
+    target  -> ceiling / peak, held instantly on the way down, released exponentially
+    gain    -> moving average of target over the same window, so the gain ramps down
+               over the lookahead and is fully at target when the peak comes out
+
+ the detector doesn't read the input, it taps the delay line lookahead samples before
+ the output. so the lookahead only moves that tap: the audio, and the latency, stay
+ put at delaySamples, and a new lookahead just rebuilds the detector from the samples
+ already in the line. one gain for both channels keeps the image where it was.
+ a bypassed limiter still delays, so the reported latency never changes.
+ the ring buffers come from the DSPArena, setDelaySamples() and layoutArena() have to
+ run before prepare().
+*/
+template<typename SampleType>
+struct LookaheadLimiter
+{
+    static constexpr SampleType maxLookaheadMs = SampleType(10);
+    static constexpr int numChannels = 2;
+
+    //the fixed delay, the most lookahead there can be. takes effect in layoutArena()
+    void setDelaySamples(int newDelaySamples) noexcept { delaySamples = juce::jmax(0, newDelaySamples); }
+    int getDelaySamples() const noexcept { return delaySamples; }
+
+    void layoutArena(DSPArena& arena, const juce::dsp::ProcessSpec& spec)
+    {
+        jassert(spec.numChannels == numChannels);
+        bufferSize = static_cast<size_t>(juce::nextPowerOfTwo(delaySamples + 2));
+
+        for( auto& buffer : delayBuffers )
+            buffer = arena.take<SampleType>(bufferSize);
+
+        gainBuffer = arena.take<SampleType>(bufferSize);
+        dequeValues = arena.take<SampleType>(bufferSize);
+        dequeIndices = arena.take<uint32_t>(bufferSize);
+    }
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        jassert(spec.numChannels == numChannels);
+        jassert(gainBuffer != nullptr); // layoutArena() first, at the same rate
+        sampleRate = spec.sampleRate;
+        mask = static_cast<uint32_t>(bufferSize - 1);
+        lookaheadSamples = juce::jmin(lookaheadSamples, delaySamples);
+
+        setRelease(releaseMs);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        for( auto* buffer : delayBuffers )
+            std::fill_n(buffer, bufferSize, SampleType(0));
+
+        writeIndex = 0;
+        restartDetector();
+    }
+
+    //the state of another limiter with the same delay, so the shadow of an order fade
+    //starts with the audio that's already on its way out instead of delaySamples of silence
+    void copyStateFrom(const LookaheadLimiter& other) noexcept
+    {
+        jassert(other.bufferSize == bufferSize);
+
+        for( size_t ch = 0; ch < delayBuffers.size(); ++ch )
+            std::copy_n(other.delayBuffers[ch], bufferSize, delayBuffers[ch]);
+
+        std::copy_n(other.gainBuffer, bufferSize, gainBuffer);
+        std::copy_n(other.dequeValues, bufferSize, dequeValues);
+        std::copy_n(other.dequeIndices, bufferSize, dequeIndices);
+
+        writeIndex = other.writeIndex;
+        dequeHead = other.dequeHead;
+        dequeTail = other.dequeTail;
+        lookaheadSamples = other.lookaheadSamples;
+        wasBypassed = other.wasBypassed;
+        gainSum = other.gainSum;
+        heldGain = other.heldGain;
+    }
+
+    //call from the audio thread only. nothing is cleared, only the detector starts over
+    void setLookaheadSamples(int newLookahead) noexcept
+    {
+        newLookahead = juce::jlimit(0, delaySamples, newLookahead);
+        if( newLookahead == lookaheadSamples )
+            return;
+
+        lookaheadSamples = newLookahead;
+        restartDetector();
+    }
+
+    int getLookaheadSamples() const noexcept { return lookaheadSamples; }
+
+    //mid/side in, so the level is measured on the left/right it decodes to
+    void setMidSide(bool isMidSide) noexcept { midSide = isMidSide; }
+
+    void setCeilingDecibels(SampleType newCeilingDb) noexcept
+    {
+        ceiling = juce::Decibels::decibelsToGain(newCeilingDb);
+    }
+
+    void setRelease(SampleType newReleaseMs) noexcept
+    {
+        releaseMs = juce::jmax(SampleType(0.1), newReleaseMs);
+        if( sampleRate > 0.0 )
+            releaseCoeff = static_cast<SampleType>(std::exp(-1.0 / (0.001 * static_cast<double>(releaseMs) * sampleRate)));
+    }
+
+    template<typename ProcessContext>
+    void process(const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+        jassert(inputBlock.getNumChannels() == numChannels && outputBlock.getNumChannels() == numChannels);
+
+        const auto* inL = inputBlock.getChannelPointer(0);
+        const auto* inR = inputBlock.getChannelPointer(1);
+        auto* outL = outputBlock.getChannelPointer(0);
+        auto* outR = outputBlock.getChannelPointer(1);
+        const auto numSamples = outputBlock.getNumSamples();
+        const auto delay = static_cast<uint32_t>(delaySamples);
+        auto* delayL = delayBuffers[0];
+        auto* delayR = delayBuffers[1];
+
+        if( context.isBypassed )
+        {
+            for( size_t n = 0; n < numSamples; ++n )
+            {
+                delayL[writeIndex & mask] = inL[n];
+                delayR[writeIndex & mask] = inR[n];
+                outL[n] = delayL[(writeIndex - delay) & mask];
+                outR[n] = delayR[(writeIndex - delay) & mask];
+                ++writeIndex;
+            }
+
+            wasBypassed = true;
+            return;
+        }
+
+        //the detector didn't see what went through while bypassed, the line did
+        if( wasBypassed )
+        {
+            restartDetector();
+            wasBypassed = false;
+        }
+
+        const auto tap = static_cast<uint32_t>(delaySamples - lookaheadSamples);
+
+        for( size_t n = 0; n < numSamples; ++n )
+        {
+            delayL[writeIndex & mask] = inL[n];
+            delayR[writeIndex & mask] = inR[n];
+
+            auto gain = detect(writeIndex, getLevel(delayL[(writeIndex - tap) & mask], delayR[(writeIndex - tap) & mask]));
+
+            auto l = delayL[(writeIndex - delay) & mask] * gain;
+            auto r = delayR[(writeIndex - delay) & mask] * gain;
+
+            //the average can overshoot by rounding, this is what makes it a brickwall.
+            //both channels by the same amount, like the gain
+            auto level = getLevel(l, r);
+            if( level > ceiling )
+            {
+                auto scale = ceiling / level;
+                l *= scale;
+                r *= scale;
+            }
+
+            outL[n] = l;
+            outR[n] = r;
+            ++writeIndex;
+        }
+    }
+
+private:
+    SampleType getLevel(SampleType a, SampleType b) const noexcept
+    {
+        return midSide ? std::abs(a) + std::abs(b) : juce::jmax(std::abs(a), std::abs(b));
+    }
+
+    //one step of the detector for the frame the tap reads at 'index', returns the gain
+    //for the frame coming out of the delay at the same index
+    SampleType detect(uint32_t index, SampleType level) noexcept
+    {
+        const auto window = static_cast<uint32_t>(lookaheadSamples + 1);
+
+        //push the new level, anything it beats can never be the max again
+        while( dequeHead != dequeTail && dequeValues[(dequeTail - 1) & mask] <= level )
+            --dequeTail;
+
+        dequeValues[dequeTail & mask] = level;
+        dequeIndices[dequeTail & mask] = index;
+        ++dequeTail;
+
+        //drop the front once it has left the window
+        while( index - dequeIndices[dequeHead & mask] >= window )
+            ++dequeHead;
+
+        auto peak = dequeValues[dequeHead & mask];
+        auto target = peak > ceiling ? ceiling / peak : SampleType(1);
+
+        heldGain = target < heldGain ? target : target + (heldGain - target) * releaseCoeff;
+
+        //moving average of heldGain over the window
+        auto oldest = gainBuffer[(index - window) & mask];
+        gainSum += static_cast<double>(heldGain) - static_cast<double>(oldest);
+        gainBuffer[index & mask] = heldGain;
+
+        return static_cast<SampleType>(gainSum / static_cast<double>(window));
+    }
+
+    //empties the detector and runs it again over the last lookahead samples, the ones the
+    //tap has already passed that haven't come out yet. O(lookahead), and nothing audible is cleared
+    void restartDetector() noexcept
+    {
+        std::fill_n(gainBuffer, bufferSize, SampleType(1));
+        dequeHead = dequeTail = 0;
+        heldGain = SampleType(1);
+        gainSum = static_cast<double>(lookaheadSamples + 1);
+
+        const auto tap = static_cast<uint32_t>(delaySamples - lookaheadSamples);
+        for( auto index = writeIndex - static_cast<uint32_t>(lookaheadSamples); index != writeIndex; ++index )
+            detect(index, getLevel(delayBuffers[0][(index - tap) & mask], delayBuffers[1][(index - tap) & mask]));
+    }
+
+    //indices are unsigned so the differences stay right when they wrap
+    std::array<SampleType*, numChannels> delayBuffers {};
+    SampleType* gainBuffer = nullptr;
+    SampleType* dequeValues = nullptr;
+    uint32_t* dequeIndices = nullptr;
+    size_t bufferSize = 0;
+    uint32_t mask = 0;
+    uint32_t writeIndex = 0;
+    uint32_t dequeHead = 0, dequeTail = 0;
+    int delaySamples = 0;
+    int lookaheadSamples = 0;
+    bool wasBypassed = false;
+    bool midSide = false;
+
+    double sampleRate = 0.0;
+    double gainSum = 1.0;
+    SampleType heldGain = SampleType(1);
+    SampleType ceiling = SampleType(1);
+    SampleType releaseMs = SampleType(50);
+    SampleType releaseCoeff = SampleType(0);
+};
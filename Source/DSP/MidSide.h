@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    MidSide.h
+    in place M/S encode/decode for the stereo mode.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+enum class StereoMode
+{
+    Stereo,
+    MidSide,
+    END_OF_LIST
+};
+
+/*
+ these run on each 64 sample sub block right before and right after the chain, while
+ the samples are still in cache, and they also sum the squares for the in/out meters.
+ so M/S costs nothing extra over the meter passes it replaces.
+
+    mid  = (l + r) / 2        l = mid + side
+    side = (l - r) / 2        r = mid - side
+*/
+namespace MidSide
+{
+//sum of squares per channel, divided by the sample count at the end of the block
+using Energy = std::array<double, 2>;
+
+inline float getRMS(const Energy& energy, size_t channel, int numSamples) noexcept
+{
+    return numSamples > 0 ? static_cast<float>(std::sqrt(energy[channel] / numSamples)) : 0.f;
+}
+
+inline void measure(const float* left, const float* right, int numSamples, Energy& energy) noexcept
+{
+    double l2 = 0.0, r2 = 0.0;
+
+    for( int n = 0; n < numSamples; ++n )
+    {
+        l2 += static_cast<double>(left[n]) * left[n];
+        r2 += static_cast<double>(right[n]) * right[n];
+    }
+
+    energy[0] += l2;
+    energy[1] += r2;
+}
+
+//measures the L/R input on the way in
+inline void encode(float* left, float* right, int numSamples, Energy& energy) noexcept
+{
+    double l2 = 0.0, r2 = 0.0;
+
+    for( int n = 0; n < numSamples; ++n )
+    {
+        auto l = left[n];
+        auto r = right[n];
+        l2 += static_cast<double>(l) * l;
+        r2 += static_cast<double>(r) * r;
+
+        left[n] = 0.5f * (l + r);
+        right[n] = 0.5f * (l - r);
+    }
+
+    energy[0] += l2;
+    energy[1] += r2;
+}
+
+//measures the L/R output on the way out
+inline void decode(float* mid, float* side, int numSamples, Energy& energy) noexcept
+{
+    double l2 = 0.0, r2 = 0.0;
+
+    for( int n = 0; n < numSamples; ++n )
+    {
+        auto l = mid[n] + side[n];
+        auto r = mid[n] - side[n];
+        l2 += static_cast<double>(l) * l;
+        r2 += static_cast<double>(r) * r;
+
+        mid[n] = l;
+        side[n] = r;
+    }
+
+    energy[0] += l2;
+    energy[1] += r2;
+}
+}
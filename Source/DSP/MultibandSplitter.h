@@ -0,0 +1,232 @@
+/*
+  ==============================================================================
+
+    MultibandSplitter.h
+    Linkwitz-Riley band split + sum for the multiband mode.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDLanes.h"
+
+/*
+ same crossover as SimpleMultiBandComp (LR4, allpass compensated), extended to
+ 2-4 bands. crossover k splits what's left above crossover k - 1:
+
+    in -> LR0 -> low                                      band 0
+              -> high -> LR1 -> low                       band 1
+                              -> high -> LR2 -> low       band 2
+                                              -> high     band 3
+
+ every band below crossover k also goes through crossover k's allpass, so all the
+ bands have the same phase and summing them back is flat.
+
+ both channels split together. the filters are juce::dsp::LinkwitzRileyFilter's, with
+ the state in SIMDRegister lanes: a crossover runs left and right as lanes 0 and 1, and
+ crossover k's allpass runs every band below it, band b's channels in lanes 2b and 2b + 1.
+ the lanes of one filter share its cutoff, so the coefficients stay scalar.
+*/
+struct MultibandSplitter
+{
+    static constexpr int maxBands = 4;
+    static constexpr int maxCrossovers = maxBands - 1;
+
+    //the last crossover's allpass has the most bands below it
+    static_assert(SIMDLanes::width >= 2 * (maxCrossovers - 1), "not enough lanes for the allpass compensation");
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        jassert(spec.numChannels == 2);
+
+        sampleRate = spec.sampleRate;
+        bandBuffer.setSize(maxBands * 2, static_cast<int>(spec.maximumBlockSize));
+        frequencies.fill(0.f);
+
+        for( size_t k = 0; k < maxCrossovers; ++k )
+        {
+            crossovers[k].setCutoffFrequency(0.f, sampleRate);
+            allpasses[k].setCutoffFrequency(0.f, sampleRate);
+        }
+
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        for( auto& filter : crossovers )
+            filter.reset();
+
+        for( auto& filter : allpasses )
+            filter.reset();
+
+        bandBuffer.clear();
+    }
+
+    void setNumBands(int newNumBands) noexcept
+    {
+        newNumBands = juce::jlimit(1, maxBands, newNumBands);
+        if( newNumBands == numBands )
+            return;
+
+        numBands = newNumBands;
+        reset();
+    }
+
+    int getNumBands() const noexcept { return numBands; }
+
+    //crossovers are kept in ascending order, one below the previous just makes an empty band
+    void setCrossoverFrequency(int index, float newFrequency) noexcept
+    {
+        jassert(juce::isPositiveAndBelow(index, maxCrossovers));
+
+        if( index > 0 )
+            newFrequency = juce::jmax(newFrequency, frequencies[static_cast<size_t>(index - 1)]);
+
+        if( frequencies[static_cast<size_t>(index)] == newFrequency )
+            return;
+
+        frequencies[static_cast<size_t>(index)] = newFrequency;
+        crossovers[static_cast<size_t>(index)].setCutoffFrequency(newFrequency, sampleRate);
+        allpasses[static_cast<size_t>(index)].setCutoffFrequency(newFrequency, sampleRate);
+    }
+
+    void split(const float* left, const float* right, int numSamples) noexcept
+    {
+        jassert(numSamples <= bandBuffer.getNumSamples());
+        const auto numCrossovers = static_cast<size_t>(numBands - 1);
+
+        std::array<float*, maxBands * 2> bands;
+        for( size_t row = 0; row < bands.size(); ++row )
+            bands[row] = bandBuffer.getWritePointer(static_cast<int>(row));
+
+        //lanes 0 and 1 of every band, the others are 0
+        std::array<Register, maxBands> bandValues;
+
+        for( int n = 0; n < numSamples; ++n )
+        {
+            auto remaining = Register::expand(0.f);
+            remaining.set(0, left[n]);
+            remaining.set(1, right[n]);
+
+            for( size_t k = 0; k < numCrossovers; ++k )
+                crossovers[k].process(remaining, bandValues[k], remaining);
+
+            bandValues[numCrossovers] = remaining;
+
+            //phase compensation: band b sees the allpass of every crossover above its own
+            for( size_t k = 1; k < numCrossovers; ++k )
+            {
+                auto below = Register::expand(0.f);
+                for( size_t b = 0; b < k; ++b )
+                {
+                    below.set(2 * b, bandValues[b].get(0));
+                    below.set(2 * b + 1, bandValues[b].get(1));
+                }
+
+                below = allpasses[k].processAllpass(below);
+
+                for( size_t b = 0; b < k; ++b )
+                {
+                    bandValues[b].set(0, below.get(2 * b));
+                    bandValues[b].set(1, below.get(2 * b + 1));
+                }
+            }
+
+            for( size_t b = 0; b <= numCrossovers; ++b )
+            {
+                bands[2 * b][n] = bandValues[b].get(0);
+                bands[2 * b + 1][n] = bandValues[b].get(1);
+            }
+        }
+    }
+
+    juce::dsp::AudioBlock<float> getBandBlock(int band, int channel, int numSamples) noexcept
+    {
+        jassert(juce::isPositiveAndBelow(band, numBands));
+        jassert(channel == 0 || channel == 1);
+        return juce::dsp::AudioBlock<float>(bandBuffer).getSingleChannelBlock(static_cast<size_t>(band * 2 + channel))
+                                                       .getSubBlock(0, static_cast<size_t>(numSamples));
+    }
+
+    void sum(int channel, float* output, int numSamples) const noexcept
+    {
+        juce::FloatVectorOperations::copy(output, bandBuffer.getReadPointer(channel), numSamples);
+
+        for( int b = 1; b < numBands; ++b )
+            juce::FloatVectorOperations::add(output, bandBuffer.getReadPointer(b * 2 + channel), numSamples);
+    }
+
+private:
+    using Register = SIMDLanes::Register;
+
+    //juce::dsp::LinkwitzRileyFilter's TPT structure, sample for sample, on a register of state
+    struct LaneFilter
+    {
+        void setCutoffFrequency(float frequency, double rate) noexcept
+        {
+            jassert(rate > 0.0 && frequency < rate * 0.5);
+            g = static_cast<float>(std::tan(juce::MathConstants<double>::pi * frequency / rate));
+            h = static_cast<float>(1.0 / (1.0 + R2 * g + g * g));
+        }
+
+        void reset() noexcept
+        {
+            s1 = s2 = s3 = s4 = Register::expand(0.f);
+        }
+
+        //the LR4 low and high outputs from one set of state
+        void process(Register input, Register& low, Register& high) noexcept
+        {
+            auto yH = (input - s1 * (R2 + g) - s2) * h;
+
+            auto yB = yH * g + s1;
+            s1 = yH * g + yB;
+
+            auto yL = yB * g + s2;
+            s2 = yB * g + yL;
+
+            auto yH2 = (yL - s3 * (R2 + g) - s4) * h;
+
+            auto yB2 = yH2 * g + s3;
+            s3 = yH2 * g + yB2;
+
+            auto yL2 = yB2 * g + s4;
+            s4 = yB2 * g + yL2;
+
+            low = yL2;
+            high = yL - yB * R2 + yH - yL2;
+        }
+
+        //the 2nd order allpass with the same phase as low + high
+        Register processAllpass(Register input) noexcept
+        {
+            auto yH = (input - s1 * (R2 + g) - s2) * h;
+
+            auto yB = yH * g + s1;
+            s1 = yH * g + yB;
+
+            auto yL = yB * g + s2;
+            s2 = yB * g + yL;
+
+            return yL - yB * R2 + yH;
+        }
+
+        static constexpr float R2 = juce::MathConstants<float>::sqrt2;
+        float g = 0.f, h = 1.f;
+        Register s1 = Register::expand(0.f), s2 = Register::expand(0.f),
+                 s3 = Register::expand(0.f), s4 = Register::expand(0.f);
+    };
+
+    std::array<LaneFilter, maxCrossovers> crossovers;
+    //allpasses[k] is crossover k's, for every band below it (k > 0)
+    std::array<LaneFilter, maxCrossovers> allpasses;
+    std::array<float, maxCrossovers> frequencies {};
+    double sampleRate = 44100.0;
+
+    //[band * 2 + channel]
+    juce::AudioBuffer<float> bandBuffer;
+    int numBands = 1;
+};
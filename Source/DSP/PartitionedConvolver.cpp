@@ -0,0 +1,289 @@
+/*
+  ==============================================================================
+
+    PartitionedConvolver.cpp
+
+  ==============================================================================
+*/
+
+#include "PartitionedConvolver.h"
+
+int ConvolutionIR::getFFTOrder(int level) noexcept
+{
+    auto blockSize = headBlockSize;
+    for( int l = 0; l < level; ++l )
+        blockSize *= levelGrowth;
+
+    return juce::roundToInt(std::log2(2 * blockSize));
+}
+
+ConvolutionIR::ConvolutionIR(const float* impulse, int numTaps) : length(numTaps)
+{
+    const auto headSize = 2 * headBlockSize;
+    headReversed.assign(static_cast<size_t>(headSize), 0.f);
+
+    for( int i = 0; i < juce::jmin(headSize, numTaps); ++i )
+        headReversed[static_cast<size_t>(headSize - 1 - i)] = impulse[i];
+
+    auto blockSize = headBlockSize;
+
+    for( int l = 0; l < numLevels; ++l, blockSize *= levelGrowth )
+    {
+        auto offset = 2 * blockSize;
+        if( offset >= numTaps )
+            break;
+
+        //the last level takes whatever is left of the impulse
+        auto end = (l == numLevels - 1) ? numTaps : juce::jmin(numTaps, 2 * blockSize * levelGrowth);
+
+        Level level;
+        level.blockSize = blockSize;
+        level.offset = offset;
+        level.numPartitions = (end - offset + blockSize - 1) / blockSize;
+        //only for the partitions, the engines use their package's FFTs
+        juce::dsp::FFT fft(getFFTOrder(l));
+
+        const auto numFloatsPerPartition = static_cast<size_t>(2 * (blockSize + 1));
+        level.spectra.assign(static_cast<size_t>(level.numPartitions) * numFloatsPerPartition, 0.f);
+
+        std::vector<float> buffer(static_cast<size_t>(4 * blockSize));
+
+        for( int p = 0; p < level.numPartitions; ++p )
+        {
+            std::fill(buffer.begin(), buffer.end(), 0.f);
+
+            auto start = offset + p * blockSize;
+            auto numToCopy = juce::jmin(blockSize, numTaps - start);
+            std::copy(impulse + start, impulse + start + numToCopy, buffer.begin());
+
+            fft.performRealOnlyForwardTransform(buffer.data(), true);
+            std::copy(buffer.begin(),
+                      buffer.begin() + static_cast<std::ptrdiff_t>(numFloatsPerPartition),
+                      level.spectra.begin() + static_cast<std::ptrdiff_t>(static_cast<size_t>(p) * numFloatsPerPartition));
+        }
+
+        levels.push_back(std::move(level));
+    }
+}
+
+PartitionedConvolver::PartitionedConvolver(const ConvolutionIR& impulse, const ConvolutionFFTs& ffts) : ir(impulse)
+{
+    for( size_t l = 0; l < ir.levels.size(); ++l )
+    {
+        LevelState level;
+        level.ir = &ir.levels[l];
+        level.fft = ffts[l].get();
+        jassert(level.fft != nullptr && level.fft->getSize() == 2 * level.ir->blockSize);
+
+        levels.push_back(level);
+    }
+}
+
+void PartitionedConvolver::layoutArena(DSPArena& arena)
+{
+    history = arena.take<float>(2 * ir.headReversed.size());
+
+    for( auto& level : levels )
+    {
+        const auto N = static_cast<size_t>(level.ir->blockSize);
+
+        //every chunk reads and writes these two
+        level.currentBlock = arena.take<float>(N);
+        level.emitting = arena.take<float>(N);
+        //the tasks, in the order runTasks() goes through them
+        level.pendingBlock = arena.take<float>(N);
+        level.previousBlock = arena.take<float>(N);
+        level.fftBuffer = arena.take<float>(4 * N);
+        level.fdl = arena.take<float>(level.ir->spectra.size());
+        level.accumulator = arena.take<float>(2 * (N + 1));
+        level.result = arena.take<float>(N);
+    }
+}
+
+void PartitionedConvolver::reset() noexcept
+{
+    jassert(history != nullptr); // layoutArena() first
+    std::fill_n(history, 2 * ir.headReversed.size(), 0.f);
+    historyIndex = 0;
+
+    //nothing here scales with the IR. currentBlock, pendingBlock, fftBuffer and the
+    //accumulator are always written before they're read, the rest is marked stale
+    for( auto& level : levels )
+    {
+        level.position = 0;
+        level.fdlHead = 0;
+        level.tasksDone = 0;
+        level.validPartitions = 0;
+        level.pending = false;
+        level.previousValid = false;
+        level.resultValid = false;
+        level.emittingValid = false;
+    }
+}
+
+void PartitionedConvolver::process(const float* input, float* output, int numSamples) noexcept
+{
+    jassert(input != output);
+    const auto headSize = static_cast<int>(ir.headReversed.size());
+    const auto* head = ir.headReversed.data();
+    int done = 0;
+
+    while( done < numSamples )
+    {
+        //a chunk never crosses a block boundary of any level
+        auto chunk = numSamples - done;
+        for( auto& level : levels )
+            chunk = juce::jmin(chunk, level.ir->blockSize - level.position);
+
+        for( int i = 0; i < chunk; ++i )
+        {
+            //the history is stored twice so the last headSize samples are always contiguous
+            auto x = input[done + i];
+            history[static_cast<size_t>(historyIndex)] = x;
+            history[static_cast<size_t>(historyIndex + headSize)] = x;
+
+            const auto* window = history + historyIndex + 1;
+            float sum = 0.f;
+            for( int t = 0; t < headSize; ++t )
+                sum += head[t] * window[t];
+
+            output[done + i] = sum;
+            historyIndex = (historyIndex + 1) % headSize;
+        }
+
+        for( auto& level : levels )
+        {
+            const auto N = level.ir->blockSize;
+            const auto totalTasks = level.ir->numPartitions + 2;
+
+            std::copy(input + done, input + done + chunk, level.currentBlock + level.position);
+            if( level.emittingValid )
+                juce::FloatVectorOperations::add(output + done, level.emitting + level.position, chunk);
+            level.position += chunk;
+
+            //spread the work of the pending block evenly over this block
+            if( level.pending )
+                runTasks(level, (totalTasks * level.position + N - 1) / N);
+
+            if( level.position == N )
+            {
+                jassert(! level.pending || level.tasksDone == totalTasks);
+
+                std::swap(level.result, level.emitting);
+                level.emittingValid = level.resultValid;
+                level.resultValid = false;
+                std::swap(level.pendingBlock, level.currentBlock);
+                level.pending = true;
+                level.tasksDone = 0;
+                level.position = 0;
+            }
+        }
+
+        done += chunk;
+    }
+}
+
+/*
+ task 0          forward FFT of [previous block, pending block] into the delay line
+ task 1..P       accumulate one partition: X(k - p) * H(p)
+ task P + 1      inverse FFT, the second half is the result (overlap-save)
+*/
+void PartitionedConvolver::runTasks(LevelState& level, int tasksTarget) noexcept
+{
+    const auto N = static_cast<size_t>(level.ir->blockSize);
+    const auto numPartitions = level.ir->numPartitions;
+    const auto numFloats = 2 * (N + 1);
+
+    while( level.tasksDone < tasksTarget )
+    {
+        auto task = level.tasksDone;
+
+        if( task == 0 )
+        {
+            if( level.previousValid )
+                std::copy_n(level.previousBlock, N, level.fftBuffer);
+            else
+                std::fill_n(level.fftBuffer, N, 0.f);
+            std::copy_n(level.pendingBlock, N, level.fftBuffer + N);
+            std::fill_n(level.fftBuffer + 2 * N, 2 * N, 0.f);
+            level.fft->performRealOnlyForwardTransform(level.fftBuffer, true);
+
+            level.fdlHead = (level.fdlHead + numPartitions - 1) % numPartitions;
+            std::copy_n(level.fftBuffer, numFloats, level.fdl + static_cast<size_t>(level.fdlHead) * numFloats);
+
+            std::swap(level.previousBlock, level.pendingBlock);
+            level.previousValid = true;
+            level.validPartitions = juce::jmin(level.validPartitions + 1, numPartitions);
+            std::fill_n(level.accumulator, numFloats, 0.f);
+        }
+        else if( task <= numPartitions )
+        {
+            //a slot from before the reset holds whatever was there, it counts as silence
+            auto p = task - 1;
+            if( p >= level.validPartitions )
+            {
+                ++level.tasksDone;
+                continue;
+            }
+
+            const auto* x = level.fdl + static_cast<size_t>((level.fdlHead + p) % numPartitions) * numFloats;
+            const auto* h = level.ir->spectra.data() + static_cast<size_t>(p) * numFloats;
+            auto* acc = level.accumulator;
+
+            for( size_t b = 0; b < numFloats; b += 2 )
+            {
+                acc[b]     += x[b] * h[b]     - x[b + 1] * h[b + 1];
+                acc[b + 1] += x[b] * h[b + 1] + x[b + 1] * h[b];
+            }
+        }
+        else
+        {
+            std::copy_n(level.accumulator, numFloats, level.fftBuffer);
+            level.fft->performRealOnlyInverseTransform(level.fftBuffer);
+            std::copy_n(level.fftBuffer + N, N, level.result);
+            level.resultValid = true;
+        }
+
+        ++level.tasksDone;
+    }
+}
+
+ConvolutionImpulse::ConvolutionImpulse(const juce::AudioBuffer<float>& impulse)
+{
+    channels.reserve(static_cast<size_t>(impulse.getNumChannels()));
+
+    for( int ch = 0; ch < impulse.getNumChannels(); ++ch )
+        channels.emplace_back(impulse.getReadPointer(ch), impulse.getNumSamples());
+}
+
+ConvolutionPackage::ConvolutionPackage(std::shared_ptr<const ConvolutionImpulse> sharedImpulse, int numEngines, double rate, juce::String irName)
+    : impulse(std::move(sharedImpulse)), sampleRate(rate), name(std::move(irName))
+{
+    //an empty impulse is how the loader clears the IR, the stages then pass through
+    if( impulse == nullptr || impulse->channels.empty() )
+        return;
+
+    const auto& irs = impulse->channels;
+
+    size_t numLevels = 0;
+    for( auto& ir : irs )
+        numLevels = juce::jmax(numLevels, ir.levels.size());
+
+    for( size_t l = 0; l < numLevels; ++l )
+        ffts[l] = std::make_unique<juce::dsp::FFT>(ConvolutionIR::getFFTOrder(static_cast<int>(l)));
+
+    const auto rightIR = juce::jmin<size_t>(1, irs.size() - 1);
+
+    for( int i = 0; i < numEngines; ++i )
+        engines.push_back(std::make_unique<PartitionedConvolver>(irs[i % 2 == 0 ? 0 : rightIR], ffts));
+
+    //per half (chain set) the left engines, then the right ones
+    const auto half = juce::jmax<size_t>(1, engines.size() / 2);
+    arena.build([this, half](DSPArena& a)
+    {
+        for( size_t first = 0; first < engines.size(); first += half )
+            for( size_t parity = 0; parity < 2; ++parity )
+                for( auto i = first + parity; i < juce::jmin(first + half, engines.size()); i += 2 )
+                    engines[i]->layoutArena(a);
+    });
+}
@@ -0,0 +1,225 @@
+/*
+  ==============================================================================
+
+    PartitionedConvolver.h
+    non-uniform partitioned convolution for the convolution DSP_Option.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DSPArena.h"
+
+/*
+ the impulse is split into a direct FIR head and 3 levels of uniformly partitioned
+ FFT convolution, each level 8x the block size of the one before:
+
+    taps [0, 128)        direct FIR, zero latency
+    taps [128, 1024)     64 sample blocks   (128 point FFT)
+    taps [1024, 8192)    512 sample blocks  (1024 point FFT)
+    taps [8192, end)     4096 sample blocks (8192 point FFT)
+
+ every level starts at 2x its block size. that gives each level one whole block of
+ time to compute its result before it's needed, so the FFTs and the partition
+ multiplies of the big levels are spread evenly over the following block instead of
+ landing in a single callback. small host buffers only ever pay a slice of the work.
+
+ ConvolutionIR is the immutable, pre-transformed impulse and is built on the loader
+ thread. it holds no FFT, so one can be shared by every instance that loads the same
+ file (see ConvolutionImpulse). PartitionedConvolver is the per channel state. its
+ buffers come from its package's DSPArena, laid out in the order process() touches
+ them, so process() never allocates and a whole engine is one run of cache lines.
+*/
+struct ConvolutionIR
+{
+    static constexpr int headBlockSize = 64;
+    static constexpr int levelGrowth = 8;
+    static constexpr int numLevels = 3;
+
+    ConvolutionIR(const float* impulse, int numTaps);
+
+    //a level with block size N runs 2N point FFTs
+    static int getFFTOrder(int level) noexcept;
+
+    struct Level
+    {
+        int blockSize = 0;
+        int offset = 0;
+        int numPartitions = 0;
+        //numPartitions * (blockSize + 1) complex bins, interleaved re/im
+        std::vector<float> spectra;
+    };
+
+    //2 * headBlockSize taps, reversed so the head is a straight dot product
+    std::vector<float> headReversed;
+    std::vector<Level> levels;
+    int length = 0;
+};
+
+//one FFT per level, shared by the engines of a package. they all run on the same audio thread
+using ConvolutionFFTs = std::array<std::unique_ptr<juce::dsp::FFT>, ConvolutionIR::numLevels>;
+
+//every channel of one impulse file, transformed for one sample rate
+struct ConvolutionImpulse
+{
+    explicit ConvolutionImpulse(const juce::AudioBuffer<float>& impulse);
+
+    std::vector<ConvolutionIR> channels;
+};
+
+struct PartitionedConvolver
+{
+    PartitionedConvolver(const ConvolutionIR& impulse, const ConvolutionFFTs& ffts);
+
+    //the history first, then each level's per sample buffers ahead of its block work.
+    //before reset() or process()
+    void layoutArena(DSPArena& arena);
+    //O(1) whatever the IR length: only the head's short history is cleared. the levels
+    //just forget what they hold, and skip each buffer and delay line slot until it has
+    //been written again, like TempoDelay's ring. so it's safe on the audio thread
+    void reset() noexcept;
+    void process(const float* input, float* output, int numSamples) noexcept;
+
+private:
+    //N floats each unless noted, N being the level's block size. they're swapped as pointers
+    struct LevelState
+    {
+        const ConvolutionIR::Level* ir = nullptr;
+        const juce::dsp::FFT* fft = nullptr;
+
+        float* currentBlock = nullptr;
+        float* emitting = nullptr;
+        float* pendingBlock = nullptr;
+        float* previousBlock = nullptr;
+        float* fftBuffer = nullptr;    // 4N
+        float* fdl = nullptr;          // frequency domain delay line, same layout as ir->spectra
+        float* accumulator = nullptr;  // 2(N + 1)
+        float* result = nullptr;
+
+        int position = 0;              // samples into the current block
+        int fdlHead = 0;
+        int tasksDone = 0;
+        //delay line slots written since the reset, the older partitions are skipped
+        int validPartitions = 0;
+        bool pending = false;
+        //what was in these before the reset counts as silence
+        bool previousValid = false, resultValid = false, emittingValid = false;
+    };
+
+    void runTasks(LevelState& level, int tasksTarget) noexcept;
+
+    const ConvolutionIR& ir;
+    float* history = nullptr;      // 2 * headReversed.size()
+    int historyIndex = 0;
+    std::vector<LevelState> levels;
+};
+
+/*
+ everything the audio thread needs for one loaded impulse: the transformed IR per file
+ channel, this instance's FFTs and one engine per mono chain. it's built and destroyed
+ off the audio thread and handed over as a whole, so swapping an IR is a pointer exchange.
+ the impulse itself is shared with any other instance that loaded the same file.
+ even engine indices are left chains, odd ones right chains. the engines' state is one
+ DSPArena, each half of the engines (one chain set) with its left chains before its
+ right ones, which is the order the processor runs them in.
+*/
+struct ConvolutionPackage
+{
+    //a null impulse makes an empty package, the stages then pass through
+    ConvolutionPackage(std::shared_ptr<const ConvolutionImpulse> impulse, int numEngines, double sampleRate, juce::String irName);
+
+    //a package only fits the chain it was resampled for. a load requested before a
+    //re-prepare can still land afterwards, so it's checked before engines are handed out.
+    //an empty package clears whatever chain it lands in
+    bool matches(double chainSampleRate, int numEngines) const noexcept
+    {
+        if( impulse == nullptr || impulse->channels.empty() )
+            return true;
+
+        return sampleRate == chainSampleRate && engines.size() == static_cast<size_t>(numEngines);
+    }
+
+    std::shared_ptr<const ConvolutionImpulse> impulse;
+    ConvolutionFFTs ffts;
+    std::vector<std::unique_ptr<PartitionedConvolver>> engines;
+    DSPArena arena;
+    double sampleRate = 0.0;
+    juce::String name;
+};
+
+/*
+ the convolution slot in MonoChannelDSP. dry/wet mix and output gain live here, the
+ engine pointer is owned by the processor's active ConvolutionPackage.
+ with no IR loaded it passes the signal through.
+*/
+struct ConvolutionStage
+{
+    void layoutArena(DSPArena& arena, const juce::dsp::ProcessSpec& spec)
+    {
+        dryBufferSize = spec.maximumBlockSize;
+        dryBuffer = arena.take<float>(dryBufferSize);
+    }
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        jassert(spec.numChannels == 1);
+        jassert(spec.maximumBlockSize <= dryBufferSize); // layoutArena() first
+        reset();
+    }
+
+    //cheap enough for the audio thread, see PartitionedConvolver::reset()
+    void reset() noexcept
+    {
+        if( engine != nullptr )
+            engine->reset();
+
+        staleEngine = false;
+    }
+
+    void setEngine(PartitionedConvolver* newEngine) noexcept { engine = newEngine; }
+    void setMix(float newMix) noexcept { mix = newMix; }
+    void setGainDecibels(float newGainDb) noexcept { gain = juce::Decibels::decibelsToGain(newGainDb); }
+
+    template<typename ProcessContext>
+    void process(const ProcessContext& context) noexcept
+    {
+        //a bypassed stage isn't fed, so its history stops at whatever it heard last. rather
+        //than paying for the convolution while it's off, it starts from silence when it's
+        //switched back on instead of replaying that old tail. that reset doesn't touch the
+        //delay line, the engine just skips the slots it hasn't written since
+        if( context.isBypassed )
+        {
+            staleEngine = true;
+            return;
+        }
+
+        if( engine == nullptr )
+            return;
+
+        if( staleEngine )
+        {
+            engine->reset();
+            staleEngine = false;
+        }
+
+        auto& block = context.getOutputBlock();
+        auto* samples = block.getChannelPointer(0);
+        auto numSamples = static_cast<int>(block.getNumSamples());
+        jassert(static_cast<size_t>(numSamples) <= dryBufferSize);
+
+        juce::FloatVectorOperations::copy(dryBuffer, samples, numSamples);
+        engine->process(dryBuffer, samples, numSamples);
+
+        juce::FloatVectorOperations::multiply(samples, gain * mix, numSamples);
+        juce::FloatVectorOperations::addWithMultiply(samples, dryBuffer, 1.f - mix, numSamples);
+    }
+
+private:
+    PartitionedConvolver* engine = nullptr;
+    float* dryBuffer = nullptr;
+    size_t dryBufferSize = 0;
+    float mix = 1.f, gain = 1.f;
+    bool staleEngine = false;
+};
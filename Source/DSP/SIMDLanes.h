@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    SIMDLanes.h
+    mono processors of one kind packed into juce::dsp::SIMDRegister lanes.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ the multiband chains are one mono instance per band and channel, all with the same
+ settings. lane i of a register is instance i: the frames are interleaved so frame n
+ holds sample n of every instance, a filter runs once per frame for all of them, and
+ the results are spread back out. lanes past numLanes run on zeros and are dropped.
+*/
+namespace SIMDLanes
+{
+    using Register = juce::dsp::SIMDRegister<float>;
+    static constexpr size_t width = Register::SIMDNumElements;
+
+    //lane i gets get(i), the unused ones 0
+    template<typename Getter>
+    Register gather(size_t numLanes, Getter&& get) noexcept
+    {
+        jassert(numLanes <= width);
+        auto value = Register::expand(0.f);
+
+        for( size_t i = 0; i < numLanes; ++i )
+            value.set(i, get(i));
+
+        return value;
+    }
+
+    inline void interleave(const float* const* channels, size_t numLanes, Register* frames, size_t numFrames) noexcept
+    {
+        for( size_t n = 0; n < numFrames; ++n )
+            frames[n] = gather(numLanes, [&](size_t i) { return channels[i][n]; });
+    }
+
+    inline void deinterleave(const Register* frames, size_t numFrames, float* const* channels, size_t numLanes) noexcept
+    {
+        jassert(numLanes <= width);
+
+        for( size_t n = 0; n < numFrames; ++n )
+            for( size_t i = 0; i < numLanes; ++i )
+                channels[i][n] = frames[n].get(i);
+    }
+}
@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    SharedResources.h
+    process wide, refcounted cache of immutable dsp data.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+#include <typeinfo>
+
+/*
+ every plugin instance in the process asks here for its read-only tables instead of
+ building its own copy. an entry lives as long as somebody holds the shared_ptr, the
+ registry itself only keeps a weak_ptr, so closing the last instance frees it.
+
+    auto table = SharedResources::get<TanhTable<float>>("tanh", [] { return std::make_shared<TanhTable<float>>(); });
+
+ the key only has to be unique per type. create() runs outside the lock, so a slow
+ build (an impulse response) doesn't hold up other instances asking for something
+ else. if two threads race on the same key the first one stored wins and the other
+ build is dropped. create() may return nullptr, which isn't cached.
+
+ message thread or background threads only, never the audio thread. whatever is
+ shared has to be safe to use from several audio threads at once, so nothing with
+ internal locks or scratch state (juce::dsp::FFT's fallback engine locks around
+ perform(), for instance).
+*/
+namespace SharedResources
+{
+    struct Registry
+    {
+        juce::CriticalSection lock;
+        std::map<juce::String, std::weak_ptr<const void>> entries;
+    };
+
+    inline Registry& getRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    template<typename T, typename Factory>
+    std::shared_ptr<const T> get(const juce::String& key, Factory&& create)
+    {
+        auto& registry = getRegistry();
+        const auto fullKey = juce::String(typeid(T).name()) + "/" + key;
+
+        {
+            const juce::ScopedLock sl(registry.lock);
+            auto it = registry.entries.find(fullKey);
+            if( it != registry.entries.end() )
+                if( auto existing = it->second.lock() )
+                    return std::static_pointer_cast<const T>(existing);
+        }
+
+        std::shared_ptr<const T> created = create();
+        if( created == nullptr )
+            return nullptr;
+
+        const juce::ScopedLock sl(registry.lock);
+
+        //drop whatever has been released since, the map only ever holds live entries and a few stale ones
+        for( auto it = registry.entries.begin(); it != registry.entries.end(); )
+            it = it->second.expired() ? registry.entries.erase(it) : std::next(it);
+
+        auto& entry = registry.entries[fullKey];
+        if( auto existing = entry.lock() )
+            return std::static_pointer_cast<const T>(existing);
+
+        entry = created;
+        return created;
+    }
+
+    //entries somebody still holds, e.g. to check they all go with the last instance
+    inline int getNumLiveResources()
+    {
+        auto& registry = getRegistry();
+        const juce::ScopedLock sl(registry.lock);
+
+        int numLive = 0;
+        for( auto& [key, entry] : registry.entries )
+            numLive += entry.expired() ? 0 : 1;
+
+        return numLive;
+    }
+}
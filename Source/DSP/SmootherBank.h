@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    SmootherBank.h
+    all the parameter ramps in one set of arrays, advanced together.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+enum class SmoothingCurve
+{
+    Linear,
+    //ramps in the log domain, for frequencies, so every octave takes the same time
+    Multiplicative
+};
+
+/*
+ juce::SmoothedValue one per parameter, but laid out as structure of arrays so skip()
+ is three FloatVectorOperations calls over every lane instead of a call per smoother.
+ a settled lane has step 0 and nothing remaining, so it rides along for free, and when
+ nothing is ramping skip() returns straight away.
+
+ like SmoothedValue, a new target restarts the full ramp from wherever the lane is.
+ multiplicative lanes must stay above 0, and since prepare() snaps to the current
+ targets, seed those lanes with setCurrentAndTargetValue() before the first prepare().
+*/
+template<size_t Size>
+struct SmootherBank
+{
+    SmootherBank()
+    {
+        rampSeconds.fill(0.005);
+        curves.fill(SmoothingCurve::Linear);
+    }
+
+    //both take effect on the next prepare()
+    void setRampTime(size_t index, double seconds) noexcept { rampSeconds[index] = seconds; }
+    void setCurve(size_t index, SmoothingCurve curve) noexcept { curves[index] = curve; }
+
+    void prepare(double sampleRate) noexcept
+    {
+        for( size_t i = 0; i < Size; ++i )
+        {
+            rampSamples[i] = static_cast<int>(std::floor(rampSeconds[i] * sampleRate));
+            setCurrentAndTargetValue(i, targets[i]);
+        }
+    }
+
+    void setCurrentAndTargetValue(size_t index, float value) noexcept
+    {
+        targets[index] = value;
+        values[index] = value;
+        current[index] = toDomain(index, value);
+        step[index] = 0.f;
+        remaining[index] = 0.f;
+
+        if( active[index] )
+        {
+            active[index] = false;
+            --numActive;
+        }
+    }
+
+    void setTargetValue(size_t index, float value) noexcept
+    {
+        if( value == targets[index] )
+            return;
+
+        if( rampSamples[index] <= 0 )
+        {
+            setCurrentAndTargetValue(index, value);
+            return;
+        }
+
+        targets[index] = value;
+        step[index] = (toDomain(index, value) - current[index]) / static_cast<float>(rampSamples[index]);
+        remaining[index] = static_cast<float>(rampSamples[index]);
+
+        if( ! active[index] )
+        {
+            active[index] = true;
+            ++numActive;
+        }
+    }
+
+    void skip(int numSamples) noexcept
+    {
+        if( numActive == 0 || numSamples <= 0 )
+            return;
+
+        using FVO = juce::FloatVectorOperations;
+        constexpr auto size = static_cast<int>(Size);
+
+        //settled lanes have remaining == 0, so they advance by 0
+        FVO::min(advance.data(), remaining.data(), static_cast<float>(numSamples), size);
+        FVO::addWithMultiply(current.data(), step.data(), advance.data(), size);
+        FVO::subtract(remaining.data(), advance.data(), size);
+
+        for( size_t i = 0; i < Size; ++i )
+        {
+            if( ! active[i] )
+                continue;
+
+            if( remaining[i] <= 0.f )
+            {
+                //lands exactly on the target, the ramp can't leave float error behind
+                setCurrentAndTargetValue(i, targets[i]);
+                continue;
+            }
+
+            values[i] = curves[i] == SmoothingCurve::Multiplicative ? std::exp(current[i]) : current[i];
+        }
+    }
+
+    float getCurrentValue(size_t index) const noexcept { return values[index]; }
+    float getTargetValue(size_t index) const noexcept { return targets[index]; }
+    bool isSmoothing(size_t index) const noexcept { return active[index]; }
+    bool isAnySmoothing() const noexcept { return numActive > 0; }
+
+private:
+    float toDomain(size_t index, float value) const noexcept
+    {
+        if( curves[index] == SmoothingCurve::Linear )
+            return value;
+
+        jassert(value > 0.f);
+        return std::log(juce::jmax(value, std::numeric_limits<float>::min()));
+    }
+
+    //the lanes skip() runs over, in the ramp's domain (log for multiplicative lanes)
+    alignas(16) std::array<float, Size> current {}, step {}, remaining {}, advance {};
+
+    //in the parameter's own units
+    std::array<float, Size> values {}, targets {};
+
+    std::array<double, Size> rampSeconds;
+    std::array<int, Size> rampSamples {};
+    std::array<SmoothingCurve, Size> curves;
+    std::array<bool, Size> active {};
+    size_t numActive = 0;
+};
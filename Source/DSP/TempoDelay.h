@@ -0,0 +1,334 @@
+/*
+  ==============================================================================
+
+    TempoDelay.h
+    feedback delay with a filtered feedback path, for the delay DSP_Option.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DSPArena.h"
+
+/*
+    wet      = ring[write - delay]
+    ring     = in + feedback * highCut(lowCut(wet))
+    out      = in * (1 - mix) + wet * mix
+
+ the line runs at the host rate, whatever the chain is oversampled by. an echo doesn't
+ need the extra bandwidth, and a 2 second ring at 8x would be 8 times the memory. with a
+ decimation of d (the oversampling factor) every d chain samples are averaged into one
+ line sample, and the wet is interpolated back up between the last two line outputs.
+ that interpolation is a line sample late, so the tap reads one sample closer.
+ everything below, the delay time, the glide and the feedback filters, is in line samples.
+
+ at a decimation of 1 the delay time is whole samples and glides to a new value over
+ glideSeconds. while it holds still and is at least a block long, a block's worth of wet
+ samples is already in the ring, so the read and the write are plain copies (two at most,
+ around the wrap) and only the one pole feedback filters run per sample. while it glides
+ every sample reads between two taps, which is what gives the pitch bend instead of clicks.
+
+ the ring holds ringSeconds, which is maxDelaySeconds for the chains that play and only
+ the order fade for the shadow chains, rounded up to a power of two so every position is
+ a mask instead of a compare or a modulo. a tap past what the ring holds, or past what was
+ written since the reset, reads silence. when a fade ends the new live chain takes the
+ long ring over with takeRingFrom(), keeping what it wrote during the fade.
+
+ bypassed, the input still goes into the ring (without feedback), so switching it back on
+ doesn't replay whatever was in there from before. reset() runs on the audio thread when
+ a band or the shadow chain comes in, so the ring isn't cleared: anything older than what
+ was written since the reset reads as silence instead.
+ the ring, the wet and the feedback scratch come from the DSPArena, setDecimation(),
+ setRingSeconds() and layoutArena() have to run before prepare().
+*/
+template<typename SampleType>
+struct TempoDelay
+{
+    static constexpr double maxDelaySeconds = 2.0;
+    static constexpr double glideSeconds = 0.1;
+
+    //the chain rate over the line rate, the oversampling factor. takes effect in layoutArena()
+    void setDecimation(int newDecimation) noexcept { decimation = juce::jmax(1, newDecimation); }
+    //how much delay the ring holds, at most maxDelaySeconds. takes effect in layoutArena()
+    void setRingSeconds(double seconds) noexcept { ringSeconds = juce::jlimit(0.0, maxDelaySeconds, seconds); }
+
+    void layoutArena(DSPArena& arena, const juce::dsp::ProcessSpec& spec)
+    {
+        maxBlockSize = spec.maximumBlockSize;
+        const auto lineRate = spec.sampleRate / decimation;
+        const auto maxLineBlock = maxBlockSize / static_cast<size_t>(decimation) + 1;
+        const auto needed = static_cast<size_t>(std::ceil(ringSeconds * lineRate)) + maxLineBlock + 2;
+        ringSize = static_cast<size_t>(juce::nextPowerOfTwo(static_cast<int>(needed)));
+        ringMask = ringSize - 1;
+
+        ring = arena.take<SampleType>(ringSize);
+        //only the block path at a decimation of 1 uses these
+        wet = decimation == 1 ? arena.take<SampleType>(maxBlockSize) : nullptr;
+        feedbackScratch = decimation == 1 ? arena.take<SampleType>(maxBlockSize) : nullptr;
+    }
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        jassert(spec.numChannels == 1);
+        jassert(ring != nullptr && spec.maximumBlockSize <= maxBlockSize); // layoutArena() first
+        sampleRate = spec.sampleRate / decimation;
+        maxDelaySamples = static_cast<SampleType>(std::ceil(maxDelaySeconds * sampleRate));
+
+        delaySamples.reset(sampleRate, glideSeconds);
+        setLowCutHz(lowCutHz);
+        setHighCutHz(highCutHz);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        writePos = 0;
+        numWritten = 0;
+        lowCutState = highCutState = SampleType(0);
+        decimationSum = previousWet = currentWet = SampleType(0);
+        decimationCount = 0;
+        delaySamples.setCurrentAndTargetValue(delaySamples.getTargetValue());
+        hasProcessed = false;
+    }
+
+    //this chain carries on with other's ring and other starts over with this one's. what this
+    //one wrote since its reset comes along, as much as the new ring holds. for the end of an
+    //order fade, where the shadow chain that wrote into a short ring becomes the live one
+    void takeRingFrom(TempoDelay& other) noexcept
+    {
+        jassert(other.decimation == decimation && other.maxBlockSize == maxBlockSize);
+        const auto keep = juce::jmin(numWritten, other.ringSize - 1);
+        readFromRing(keep, other.ring, keep);
+
+        std::swap(ring, other.ring);
+        std::swap(ringSize, other.ringSize);
+        std::swap(ringMask, other.ringMask);
+        writePos = keep;
+        numWritten = keep;
+        other.reset();
+    }
+
+    void setDelaySeconds(double seconds) noexcept
+    {
+        auto samples = static_cast<SampleType>(juce::roundToInt(seconds * sampleRate));
+        samples = juce::jlimit(SampleType(1), juce::jmax(SampleType(1), maxDelaySamples), samples);
+
+        //nothing to glide from before the first block after a reset
+        if( ! hasProcessed )
+            delaySamples.setCurrentAndTargetValue(samples);
+        else
+            delaySamples.setTargetValue(samples);
+    }
+
+    void setFeedback(SampleType newFeedback) noexcept { feedback = juce::jlimit(SampleType(0), SampleType(0.95), newFeedback); }
+    void setMix(SampleType newMix) noexcept { mix = juce::jlimit(SampleType(0), SampleType(1), newMix); }
+
+    void setLowCutHz(SampleType newLowCutHz) noexcept
+    {
+        lowCutHz = newLowCutHz;
+        lowCutCoeff = getOnePoleCoefficient(lowCutHz);
+    }
+
+    void setHighCutHz(SampleType newHighCutHz) noexcept
+    {
+        highCutHz = newHighCutHz;
+        highCutCoeff = getOnePoleCoefficient(highCutHz);
+    }
+
+    template<typename ProcessContext>
+    void process(const ProcessContext& context) noexcept
+    {
+        auto& block = context.getOutputBlock();
+        jassert(block.getNumChannels() == 1);
+        auto* samples = block.getChannelPointer(0);
+        const auto numSamples = block.getNumSamples();
+        jassert(numSamples <= maxBlockSize);
+        hasProcessed = true;
+
+        if( context.isBypassed )
+        {
+            if( decimation == 1 )
+                writeToRing(samples, numSamples);
+            else
+                writeDecimated(samples, numSamples);
+
+            delaySamples.setCurrentAndTargetValue(delaySamples.getTargetValue());
+            return;
+        }
+
+        if( decimation > 1 )
+            processDecimated(samples, numSamples);
+        else if( delaySamples.isSmoothing() || delaySamples.getTargetValue() < static_cast<SampleType>(numSamples) )
+            processGliding(samples, numSamples);
+        else
+            processFixed(samples, numSamples);
+    }
+
+private:
+    SampleType getOnePoleCoefficient(SampleType cutoffHz) const noexcept
+    {
+        if( sampleRate <= 0.0 )
+            return SampleType(0);
+
+        const auto fc = juce::jlimit(1.0, 0.45 * sampleRate, static_cast<double>(cutoffHz));
+        return static_cast<SampleType>(std::exp(-juce::MathConstants<double>::twoPi * fc / sampleRate));
+    }
+
+    //one pole high pass at lowCutHz into a one pole low pass at highCutHz
+    SampleType filterFeedback(SampleType x) noexcept
+    {
+        lowCutState = x + lowCutCoeff * (lowCutState - x);
+        const auto highPassed = x - lowCutState;
+        highCutState = highPassed + highCutCoeff * (highCutState - highPassed);
+        return highCutState;
+    }
+
+    //where the sample written 'age' line samples ago is, age is at most ringSize
+    size_t getReadPos(size_t age) const noexcept
+    {
+        return (writePos - age) & ringMask;
+    }
+
+    //one line sample: reads the tap, writes in plus the filtered feedback, returns the tap
+    SampleType tick(SampleType x, SampleType delay) noexcept
+    {
+        const auto whole = static_cast<size_t>(delay);
+        const auto fraction = delay - static_cast<SampleType>(whole);
+
+        //delay is at least 1, so both taps were written before this sample, if anything was
+        const auto newer = whole <= numWritten ? ring[getReadPos(whole)] : SampleType(0);
+        const auto older = whole < numWritten ? ring[getReadPos(whole + 1)] : SampleType(0);
+        const auto delayed = newer + fraction * (older - newer);
+
+        ring[writePos] = x + feedback * filterFeedback(delayed);
+        advance(1);
+
+        return delayed;
+    }
+
+    void processFixed(SampleType* samples, size_t numSamples) noexcept
+    {
+        const auto delay = static_cast<size_t>(delaySamples.getTargetValue());
+        const auto n = static_cast<int>(numSamples);
+
+        //every wet sample of this block was written before it, the ones from before a reset are silence
+        const auto numStale = juce::jmin(numSamples, delay - juce::jmin(delay, numWritten));
+        std::fill_n(wet, numStale, SampleType(0));
+        readFromRing(delay - numStale, wet + numStale, numSamples - numStale);
+
+        for( size_t i = 0; i < numSamples; ++i )
+            feedbackScratch[i] = filterFeedback(wet[i]);
+
+        juce::FloatVectorOperations::multiply(feedbackScratch, feedback, n);
+        juce::FloatVectorOperations::add(feedbackScratch, samples, n);
+        writeToRing(feedbackScratch, numSamples);
+
+        juce::FloatVectorOperations::multiply(samples, SampleType(1) - mix, n);
+        juce::FloatVectorOperations::addWithMultiply(samples, wet, mix, n);
+    }
+
+    void processGliding(SampleType* samples, size_t numSamples) noexcept
+    {
+        for( size_t i = 0; i < numSamples; ++i )
+        {
+            const auto x = samples[i];
+            const auto delayed = tick(x, delaySamples.getNextValue());
+            samples[i] = x * (SampleType(1) - mix) + delayed * mix;
+        }
+    }
+
+    void processDecimated(SampleType* samples, size_t numSamples) noexcept
+    {
+        const auto step = SampleType(1) / static_cast<SampleType>(decimation);
+
+        for( size_t i = 0; i < numSamples; ++i )
+        {
+            const auto x = samples[i];
+            decimationSum += x;
+
+            if( ++decimationCount == decimation )
+            {
+                const auto delay = juce::jmax(SampleType(1), delaySamples.getNextValue() - SampleType(1));
+                previousWet = currentWet;
+                currentWet = tick(decimationSum * step, delay);
+                decimationSum = SampleType(0);
+                decimationCount = 0;
+            }
+
+            const auto delayed = previousWet + (currentWet - previousWet) * static_cast<SampleType>(decimationCount + 1) * step;
+            samples[i] = x * (SampleType(1) - mix) + delayed * mix;
+        }
+    }
+
+    void writeDecimated(const SampleType* samples, size_t numSamples) noexcept
+    {
+        for( size_t i = 0; i < numSamples; ++i )
+        {
+            decimationSum += samples[i];
+            if( ++decimationCount == decimation )
+            {
+                ring[writePos] = decimationSum / static_cast<SampleType>(decimation);
+                advance(1);
+                decimationSum = SampleType(0);
+                decimationCount = 0;
+            }
+        }
+
+        previousWet = currentWet = SampleType(0);
+    }
+
+    //the numSamples samples from 'age' line samples ago onwards, age is at most numWritten
+    void readFromRing(size_t age, SampleType* dest, size_t numSamples) const noexcept
+    {
+        if( numSamples == 0 )
+            return;
+
+        const auto start = getReadPos(age);
+        const auto first = juce::jmin(numSamples, ringSize - start);
+        std::copy_n(ring + start, first, dest);
+        std::copy_n(ring, numSamples - first, dest + first);
+    }
+
+    void writeToRing(const SampleType* source, size_t numSamples) noexcept
+    {
+        const auto first = juce::jmin(numSamples, ringSize - writePos);
+        std::copy_n(source, first, ring + writePos);
+        std::copy_n(source + first, numSamples - first, ring);
+        advance(numSamples);
+    }
+
+    void advance(size_t numSamples) noexcept
+    {
+        writePos = (writePos + numSamples) & ringMask;
+
+        numWritten = juce::jmin(numWritten + numSamples, ringSize - 1);
+    }
+
+    SampleType* ring = nullptr;
+    SampleType* wet = nullptr;
+    SampleType* feedbackScratch = nullptr;
+    //a power of two, the smallest that holds the delay it has to
+    size_t ringSize = 0, ringMask = 0, maxBlockSize = 0;
+    size_t writePos = 0;
+    //samples written since the last reset, up to ringSize - 1 (the ring is full from there on)
+    size_t numWritten = 0;
+    double ringSeconds = maxDelaySeconds;
+
+    int decimation = 1, decimationCount = 0;
+    SampleType decimationSum = SampleType(0);
+    //the last two line outputs, the wet is interpolated between them
+    SampleType previousWet = SampleType(0), currentWet = SampleType(0);
+
+    //the line rate
+    double sampleRate = 0.0;
+    SampleType maxDelaySamples = SampleType(1);
+    juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Linear> delaySamples { SampleType(1) };
+    bool hasProcessed = false;
+
+    SampleType feedback = SampleType(0), mix = SampleType(0.5);
+    SampleType lowCutHz = SampleType(80), highCutHz = SampleType(8000);
+    SampleType lowCutCoeff = SampleType(0), highCutCoeff = SampleType(0);
+    SampleType lowCutState = SampleType(0), highCutState = SampleType(0);
+};
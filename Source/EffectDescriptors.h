@@ -0,0 +1,426 @@
+/*
+  ==============================================================================
+
+    EffectDescriptors.h
+    every parameter's ID, range, default and smoothing, and the effect pages, one
+    table indexed by DSP_Option.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include "DSP/SmootherBank.h"
+#include "DSP/FastMath.h"
+#include "DSP/LookaheadLimiter.h"
+#include "DSP/TempoDelay.h"
+
+//parameter IDs. plain literals, so looking a parameter up by one doesn't build a juce::String
+constexpr const char* getPhaserRateName() { return "Phaser RateHz"; }
+constexpr const char* getPhaserDepthName() { return "Phaser Depth %"; }
+constexpr const char* getPhaserCenterFreqName() { return "Phaser Center FreqHz"; }
+constexpr const char* getPhaserFeedbackName() { return "Phaser Feedback %"; }
+constexpr const char* getPhaserMixName() { return "Phaser Mix %"; }
+constexpr const char* getPhaserBypassName() { return "Phaser Bypass"; }
+
+constexpr const char* getChorusRateName() { return "Chorus RateHz"; }
+constexpr const char* getChorusDepthName() { return "Chorus Depth %"; }
+constexpr const char* getChorusCenterDelayName() { return "Chorus Center DelayMs"; }
+constexpr const char* getChorusFeedbackName() { return "Chorus Feedback %"; }
+constexpr const char* getChorusMixName() { return "Chorus Mix %"; }
+constexpr const char* getChorusBypassName() { return "Chorus Bypass"; }
+
+constexpr const char* getOverdriveSaturationName() { return "Overdrive Saturation %"; }
+constexpr const char* getOverdriveBypassName() { return "Overdrive Bypass"; }
+constexpr const char* getSaturationQualityName() { return "Saturation Quality"; }
+
+constexpr const char* getLadderFilterModeName() { return "Ladder Filter Mode"; }
+constexpr const char* getLadderFilterCutoffName() { return "Ladder Filter Cutoff Hz"; }
+constexpr const char* getLadderFilterResonanceName() { return "Ladder Filter Resonance"; }
+constexpr const char* getLadderFilterDriveName() { return "Ladder Filter Drive"; }
+constexpr const char* getLadderFilterBypassName() { return "Ladder Filter Bypass"; }
+
+constexpr const char* getGeneralFilterModeName() { return "General Filter Mode"; }
+constexpr const char* getGeneralFilterFreqName() { return "General Filter Freq hz"; }
+constexpr const char* getGeneralFilterQualityName() { return "General Filter Quality"; }
+constexpr const char* getGeneralFilterGainName() { return "General Filter Gain"; }
+constexpr const char* getGeneralFilterBypassName() { return "General Filter Bypass"; }
+
+constexpr const char* getLimiterCeilingName() { return "Limiter Ceiling dB"; }
+constexpr const char* getLimiterReleaseName() { return "Limiter Release ms"; }
+constexpr const char* getLimiterLookaheadName() { return "Limiter Lookahead ms"; }
+constexpr const char* getLimiterBypassName() { return "Limiter Bypass"; }
+
+constexpr const char* getConvolutionMixName() { return "Convolution Mix %"; }
+constexpr const char* getConvolutionGainName() { return "Convolution Gain dB"; }
+constexpr const char* getConvolutionBypassName() { return "Convolution Bypass"; }
+
+constexpr const char* getDelayTimeName() { return "Delay Time ms"; }
+constexpr const char* getDelaySyncName() { return "Delay Sync"; }
+constexpr const char* getDelayFeedbackName() { return "Delay Feedback %"; }
+constexpr const char* getDelayLowCutName() { return "Delay Low Cut Hz"; }
+constexpr const char* getDelayHighCutName() { return "Delay High Cut Hz"; }
+constexpr const char* getDelayMixName() { return "Delay Mix %"; }
+constexpr const char* getDelayBypassName() { return "Delay Bypass"; }
+
+//the envelope is shown on both filter pages
+constexpr const char* getEnvelopeTargetName() { return "Envelope Target"; }
+constexpr const char* getEnvelopeDepthName() { return "Envelope Depth Oct"; }
+constexpr const char* getEnvelopeAttackName() { return "Envelope Attack ms"; }
+constexpr const char* getEnvelopeReleaseName() { return "Envelope Release ms"; }
+
+constexpr const char* getRenderQualityName() { return "Render Quality"; }
+constexpr const char* getMultibandBandsName() { return "Multiband Bands"; }
+constexpr const char* getStereoModeName() { return "Stereo Mode"; }
+constexpr const char* getOversamplingName() { return "Oversampling"; }
+constexpr const char* getOversamplingFilterName() { return "Oversampling Filter"; }
+
+//the choice lists. the ones an enum is cast from have to keep its order
+inline constexpr std::array saturationQualityChoices { "Eco", "Normal", "Precise" }; // SaturationQuality
+inline constexpr std::array ladderFilterChoices
+{
+    "LPF12",  // low-pass  12 dB/octave
+    "HPF12",  // high-pass 12 dB/octave
+    "BPF12",  // band-pass 12 dB/octave
+    "LPF24",  // low-pass  24 dB/octave
+    "HPF24",  // high-pass 24 dB/octave
+    "BPF24"   // band-pass 24 dB/octave
+};
+inline constexpr std::array generalFilterChoices { "Peak", "bandpass", "notch", "allpass" }; // GeneralFilterMode
+//the processor's getDelaySyncBeats() has one entry per choice
+inline constexpr std::array delaySyncChoices { "Off", "1/1", "1/2", "1/4", "1/4 D", "1/4 T", "1/8", "1/8 D", "1/8 T", "1/16", "1/16 T" };
+//index + 1 is the number of bands
+inline constexpr std::array multibandBandsChoices { "Off", "2 Bands", "3 Bands", "4 Bands" };
+inline constexpr std::array stereoModeChoices { "Stereo", "Mid/Side" }; // StereoMode
+inline constexpr std::array envelopeTargetChoices { "Off", "Ladder Cutoff", "General Filter Freq" }; // EnvelopeTarget
+//index is the factor's exponent
+inline constexpr std::array oversamplingChoices { "1x", "2x", "4x", "8x" };
+inline constexpr std::array oversamplingFilterChoices { "Minimum Phase", "Linear Phase" }; // OversamplingFilter
+
+//one SmootherBank lane per smoothed float parameter, in the order parameterSpecs lists them
+enum class SmoothedParam
+{
+    PhaserRate,
+    PhaserDepth,
+    PhaserCenterFreq,
+    PhaserFeedback,
+    PhaserMix,
+    ChorusRate,
+    ChorusDepth,
+    ChorusCenterDelay,
+    ChorusFeedback,
+    ChorusMix,
+    OverdriveSaturation,
+    LadderFilterCutoff,
+    LadderFilterResonance,
+    LadderFilterDrive,
+    GeneralFilterFreq,
+    GeneralFilterQuality,
+    GeneralFilterGain,
+    LimiterCeiling,
+    ConvolutionMix,
+    ConvolutionGain,
+    DelayFeedback,
+    DelayLowCut,
+    DelayHighCut,
+    DelayMix,
+    EnvelopeDepth,
+    Crossover1,
+    Crossover2,
+    Crossover3,
+    END_OF_LIST
+};
+
+enum class ParameterKind
+{
+    Float,
+    Choice,
+    Bool
+};
+
+//NormalisableRange's arguments
+struct ParameterRange
+{
+    float start = 0.f, end = 1.f, interval = 0.f, skew = 1.f;
+};
+
+/*
+ one parameter as createParameterLayout() makes it. a float with a lane is smoothed on
+ that lane with that curve; multiplicative lanes ramp in octaves, so a sweep sounds even
+ from 20 Hz to 20 kHz, and take a bit longer. without a lane the processor reads the
+ parameter as it is.
+*/
+struct ParameterSpec
+{
+    const char* name;
+    ParameterKind kind;
+    ParameterRange range {};
+    //the value for a float, the index for a choice, 0 or 1 for a bool
+    float defaultValue = 0.f;
+    const char* unit = "";
+    SmoothedParam lane = SmoothedParam::END_OF_LIST;
+    SmoothingCurve curve = SmoothingCurve::Linear;
+    const char* const* choices = nullptr;
+    int numChoices = 0;
+};
+
+constexpr ParameterSpec floatParam(const char* name, ParameterRange range, float defaultValue, const char* unit,
+                                   SmoothedParam lane = SmoothedParam::END_OF_LIST, SmoothingCurve curve = SmoothingCurve::Linear)
+{
+    return { name, ParameterKind::Float, range, defaultValue, unit, lane, curve };
+}
+
+template<size_t N>
+constexpr ParameterSpec choiceParam(const char* name, const std::array<const char*, N>& choices, int defaultIndex)
+{
+    return { name, ParameterKind::Choice, {}, static_cast<float>(defaultIndex), "",
+             SmoothedParam::END_OF_LIST, SmoothingCurve::Linear, choices.data(), static_cast<int>(N) };
+}
+
+constexpr ParameterSpec boolParam(const char* name, bool defaultValue)
+{
+    return { name, ParameterKind::Bool, {}, defaultValue ? 1.f : 0.f };
+}
+
+/*
+ every parameter but the numbered multiband ones, in the order hosts see them, so a new
+ one goes at the end. the smoothed floats come in SmoothedParam's order.
+*/
+inline constexpr std::array parameterSpecs
+{
+    floatParam(getPhaserRateName(), { 0.01f, 2.f, 0.01f }, 0.2f, "Hz", SmoothedParam::PhaserRate),
+    floatParam(getPhaserDepthName(), { 0.01f, 1.f, 0.01f }, 0.05f, "%", SmoothedParam::PhaserDepth),
+    floatParam(getPhaserCenterFreqName(), { 20.f, 20000.f, 1.f }, 1000.f, "Hz", SmoothedParam::PhaserCenterFreq, SmoothingCurve::Multiplicative),
+    floatParam(getPhaserFeedbackName(), { -1.f, 1.f, 0.01f }, 0.f, "%", SmoothedParam::PhaserFeedback),
+    floatParam(getPhaserMixName(), { 0.01f, 1.f, 0.01f }, 0.05f, "%", SmoothedParam::PhaserMix),
+    boolParam(getPhaserBypassName(), false),
+
+    floatParam(getChorusRateName(), { 0.01f, 100.f, 0.01f }, 0.2f, "Hz", SmoothedParam::ChorusRate),
+    floatParam(getChorusDepthName(), { 0.01f, 1.f, 0.01f }, 0.05f, "%", SmoothedParam::ChorusDepth),
+    floatParam(getChorusCenterDelayName(), { 0.01f, 100.f, 0.01f }, 7.5f, "ms", SmoothedParam::ChorusCenterDelay),
+    floatParam(getChorusFeedbackName(), { -1.f, 1.f, 0.01f }, 0.f, "%", SmoothedParam::ChorusFeedback),
+    floatParam(getChorusMixName(), { 0.01f, 1.f, 0.01f }, 0.05f, "%", SmoothedParam::ChorusMix),
+    boolParam(getChorusBypassName(), false),
+
+    floatParam(getOverdriveSaturationName(), { 1.f, 100.f, 0.1f }, 1.f, "%", SmoothedParam::OverdriveSaturation),
+    boolParam(getOverdriveBypassName(), false),
+    //shared by the overdrive and the ladder filter
+    choiceParam(getSaturationQualityName(), saturationQualityChoices, static_cast<int>(SaturationQuality::Normal)),
+
+    choiceParam(getLadderFilterModeName(), ladderFilterChoices, 0),
+    floatParam(getLadderFilterCutoffName(), { 20.f, 20000.f, 0.1f }, 20000.f, "Hz", SmoothedParam::LadderFilterCutoff, SmoothingCurve::Multiplicative),
+    floatParam(getLadderFilterResonanceName(), { 0.f, 100.f, 0.1f }, 0.f, "%", SmoothedParam::LadderFilterResonance),
+    floatParam(getLadderFilterDriveName(), { 1.f, 100.f, 0.1f }, 1.f, "", SmoothedParam::LadderFilterDrive),
+    boolParam(getLadderFilterBypassName(), false),
+
+    choiceParam(getGeneralFilterModeName(), generalFilterChoices, 0),
+    floatParam(getGeneralFilterFreqName(), { 20.f, 20000.f, 1.f }, 750.f, "Hz", SmoothedParam::GeneralFilterFreq, SmoothingCurve::Multiplicative),
+    floatParam(getGeneralFilterQualityName(), { 0.1f, 10.f, 0.05f }, 1.f, "", SmoothedParam::GeneralFilterQuality),
+    floatParam(getGeneralFilterGainName(), { -24.f, 24.f, 0.5f }, 0.f, "dB", SmoothedParam::GeneralFilterGain),
+    boolParam(getGeneralFilterBypassName(), false),
+
+    floatParam(getLimiterCeilingName(), { -24.f, 0.f, 0.1f }, -0.3f, "dB", SmoothedParam::LimiterCeiling),
+    floatParam(getLimiterReleaseName(), { 1.f, 1000.f, 1.f, 0.4f }, 50.f, "ms"),
+    //this is the plugin's latency, so it's only read when the processor re-prepares
+    floatParam(getLimiterLookaheadName(), { 0.f, LookaheadLimiter<float>::maxLookaheadMs, 0.1f }, 1.5f, "ms"),
+    boolParam(getLimiterBypassName(), false),
+
+    floatParam(getConvolutionMixName(), { 0.f, 1.f, 0.01f }, 1.f, "%", SmoothedParam::ConvolutionMix),
+    //the loader normalizes the IR to unit energy
+    floatParam(getConvolutionGainName(), { -24.f, 24.f, 0.1f }, 0.f, "dB", SmoothedParam::ConvolutionGain),
+    boolParam(getConvolutionBypassName(), false),
+
+    //up to what the ring holds. the delay glides to a new time on its own
+    floatParam(getDelayTimeName(), { 1.f, static_cast<float>(TempoDelay<float>::maxDelaySeconds * 1000.0), 1.f, 0.5f }, 375.f, "ms"),
+    //a note length at the host tempo instead of Delay Time
+    choiceParam(getDelaySyncName(), delaySyncChoices, 0),
+    floatParam(getDelayFeedbackName(), { 0.f, 0.95f, 0.01f }, 0.35f, "%", SmoothedParam::DelayFeedback),
+    //both filter every repeat in the feedback path
+    floatParam(getDelayLowCutName(), { 20.f, 2000.f, 1.f, 0.3f }, 80.f, "Hz", SmoothedParam::DelayLowCut, SmoothingCurve::Multiplicative),
+    floatParam(getDelayHighCutName(), { 1000.f, 20000.f, 1.f, 0.3f }, 8000.f, "Hz", SmoothedParam::DelayHighCut, SmoothingCurve::Multiplicative),
+    floatParam(getDelayMixName(), { 0.f, 1.f, 0.01f }, 0.3f, "%", SmoothedParam::DelayMix),
+    boolParam(getDelayBypassName(), false),
+
+    //offline renders switch to the precise settings on their own
+    boolParam(getRenderQualityName(), true),
+    //Off or 2-4 bands, each band runs the chain up to the limiter, the limiter and the rest run on the sum
+    choiceParam(getMultibandBandsName(), multibandBandsChoices, 0),
+    //Mid/Side runs the left chains on mid and the right chains on side
+    choiceParam(getStereoModeName(), stereoModeChoices, 0),
+    //around the whole chain, 1x to 8x
+    choiceParam(getOversamplingName(), oversamplingChoices, 0),
+    choiceParam(getOversamplingFilterName(), oversamplingFilterChoices, 0),
+
+    //the input level moves the target frequency by up to depth octaves, up or down
+    choiceParam(getEnvelopeTargetName(), envelopeTargetChoices, 0),
+    floatParam(getEnvelopeDepthName(), { -4.f, 4.f, 0.01f }, 2.f, "oct", SmoothedParam::EnvelopeDepth),
+    floatParam(getEnvelopeAttackName(), { 0.1f, 200.f, 0.1f, 0.4f }, 10.f, "ms"),
+    floatParam(getEnvelopeReleaseName(), { 5.f, 2000.f, 1.f, 0.4f }, 150.f, "ms"),
+};
+
+//Crossover N Hz, 20 Hz to 20 kHz, on lane Crossover1 + N - 1. the splitter keeps them in order
+inline constexpr ParameterSpec crossoverSpec = floatParam(nullptr, { 20.f, 20000.f, 1.f, 0.25f }, 0.f, "Hz",
+                                                          SmoothedParam::Crossover1, SmoothingCurve::Multiplicative);
+inline constexpr std::array crossoverDefaults { 200.f, 1000.f, 5000.f };
+//Band N Process, off sends the band around the effects before the limiter
+inline constexpr ParameterSpec bandProcessSpec = boolParam(nullptr, true);
+
+//the lanes come up in order, each one once, up to the crossovers which are numbered
+constexpr bool parameterLanesAreInOrder()
+{
+    size_t nextLane = 0;
+    for( const auto& spec : parameterSpecs )
+        if( spec.lane != SmoothedParam::END_OF_LIST
+            && (spec.kind != ParameterKind::Float || static_cast<size_t>(spec.lane) != nextLane++) )
+            return false;
+
+    return nextLane == static_cast<size_t>(SmoothedParam::Crossover1)
+        && crossoverSpec.lane == SmoothedParam::Crossover1
+        && static_cast<size_t>(SmoothedParam::Crossover1) + crossoverDefaults.size() == static_cast<size_t>(SmoothedParam::END_OF_LIST);
+}
+static_assert(parameterLanesAreInOrder(), "parameterSpecs has to list the smoothed parameters in SmoothedParam's order");
+
+constexpr const ParameterSpec* findParameterSpec(std::string_view name)
+{
+    for( const auto& spec : parameterSpecs )
+        if( name == spec.name )
+            return &spec;
+
+    return nullptr;
+}
+
+/*
+ everything outside the dsp that has to know about an effect. the processor resolves the
+ parameter IDs once in its constructor, after that the editor page, the bypass and the
+ tab name for a DSP_Option are array lookups. the ranges, defaults and lanes are in
+ parameterSpecs.
+*/
+struct EffectDescriptor
+{
+    static constexpr size_t maxParams = 10;
+
+    template<size_t N>
+    constexpr EffectDescriptor(const char* display, const char* shortName_, const char* const (&names)[N])
+        : displayName(display), shortName(shortName_), numParams(N)
+    {
+        static_assert(N > 0 && N <= maxParams);
+        for( size_t i = 0; i < N; ++i )
+            paramNames[i] = names[i];
+    }
+
+    constexpr const char* getBypassName() const { return paramNames[numParams - 1]; }
+
+    //the editor's tab and tooltip
+    const char* displayName;
+    //the render tool's file and config names
+    const char* shortName;
+    //the editor page's controls in order, the bypass last
+    std::array<const char*, maxParams> paramNames {};
+    size_t numParams;
+};
+
+//index is DSP_Option, the processor static_asserts the size
+inline constexpr std::array effectDescriptors
+{
+    EffectDescriptor { "PHASE", "phaser",
+    {
+        getPhaserRateName(),
+        getPhaserCenterFreqName(),
+        getPhaserDepthName(),
+        getPhaserFeedbackName(),
+        getPhaserMixName(),
+        getPhaserBypassName(),
+    } },
+    EffectDescriptor { "CHORUS", "chorus",
+    {
+        getChorusRateName(),
+        getChorusDepthName(),
+        getChorusCenterDelayName(),
+        getChorusFeedbackName(),
+        getChorusMixName(),
+        getChorusBypassName(),
+    } },
+    EffectDescriptor { "OVERDRIVE", "overdrive",
+    {
+        getOverdriveSaturationName(),
+        getSaturationQualityName(),
+        getOverdriveBypassName(),
+    } },
+    EffectDescriptor { "LADDERFILTER", "ladderfilter",
+    {
+        getLadderFilterModeName(),
+        getLadderFilterCutoffName(),
+        getLadderFilterResonanceName(),
+        getLadderFilterDriveName(),
+        getSaturationQualityName(),
+        getEnvelopeTargetName(),
+        getEnvelopeDepthName(),
+        getEnvelopeAttackName(),
+        getEnvelopeReleaseName(),
+        getLadderFilterBypassName(),
+    } },
+    EffectDescriptor { "GEN FILTER", "generalfilter",
+    {
+        getGeneralFilterModeName(),
+        getGeneralFilterFreqName(),
+        getGeneralFilterQualityName(),
+        getGeneralFilterGainName(),
+        getEnvelopeTargetName(),
+        getEnvelopeDepthName(),
+        getEnvelopeAttackName(),
+        getEnvelopeReleaseName(),
+        getGeneralFilterBypassName(),
+    } },
+    EffectDescriptor { "LIMITER", "limiter",
+    {
+        getLimiterCeilingName(),
+        getLimiterReleaseName(),
+        getLimiterLookaheadName(),
+        getLimiterBypassName(),
+    } },
+    EffectDescriptor { "CONVOLUTION", "convolution",
+    {
+        getConvolutionMixName(),
+        getConvolutionGainName(),
+        getConvolutionBypassName(),
+    } },
+    EffectDescriptor { "DELAY", "delay",
+    {
+        getDelayTimeName(),
+        getDelaySyncName(),
+        getDelayFeedbackName(),
+        getDelayLowCutName(),
+        getDelayHighCutName(),
+        getDelayMixName(),
+        getDelayBypassName(),
+    } },
+};
+
+//every page ends in its own bypass, every control has a spec, and no two tabs share a name
+constexpr bool effectDescriptorsAreConsistent()
+{
+    for( size_t i = 0; i < effectDescriptors.size(); ++i )
+    {
+        std::string_view bypass = effectDescriptors[i].getBypassName();
+        if( ! bypass.ends_with(" Bypass") )
+            return false;
+
+        for( size_t j = 0; j < effectDescriptors[i].numParams; ++j )
+            if( findParameterSpec(effectDescriptors[i].paramNames[j]) == nullptr )
+                return false;
+
+        if( findParameterSpec(bypass)->kind != ParameterKind::Bool )
+            return false;
+
+        for( size_t j = 0; j < i; ++j )
+            if( bypass == effectDescriptors[j].getBypassName()
+                || std::string_view(effectDescriptors[i].displayName) == effectDescriptors[j].displayName )
+                return false;
+    }
+
+    return true;
+}
+static_assert(effectDescriptorsAreConsistent());
@@ -0,0 +1,256 @@
+/*
+  ==============================================================================
+
+    ParameterUpdateBatcher.cpp
+    parameter changes for the editor, collected and handed over once a frame.
+
+  ==============================================================================
+*/
+
+#include "ParameterUpdateBatcher.h"
+#include <bit>
+
+ParameterUpdateBatcher::ParameterUpdateBatcher(juce::AudioProcessor& processor)
+    : parameters(processor.getParameters())
+{
+    const auto numParameters = static_cast<size_t>(parameters.size());
+    numDirtyWords = (numParameters + bitsPerWord - 1) / bitsPerWord;
+    //value initialised, so every bit starts clear
+    dirtyWords = std::make_unique<std::atomic<uint64_t>[]>(numDirtyWords);
+    attachments.resize(numParameters);
+
+    for( auto* param : parameters )
+        param->addListener(this);
+}
+
+ParameterUpdateBatcher::~ParameterUpdateBatcher()
+{
+    for( auto* param : parameters )
+        param->removeListener(this);
+}
+
+void ParameterUpdateBatcher::parameterValueChanged(int parameterIndex, float)
+{
+    //the audio thread when the host automates, so nothing but the bit
+    const auto index = static_cast<size_t>(parameterIndex);
+    jassert(index < attachments.size());
+    dirtyWords[index / bitsPerWord].fetch_or(uint64_t(1) << (index % bitsPerWord), std::memory_order_release);
+}
+
+void ParameterUpdateBatcher::flush()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    for( size_t word = 0; word < numDirtyWords; ++word )
+    {
+        //a change that lands after the exchange stays set for the next frame
+        auto bits = dirtyWords[word].exchange(0, std::memory_order_acquire);
+
+        while( bits != 0 )
+        {
+            const auto index = word * bitsPerWord + static_cast<size_t>(std::countr_zero(bits));
+            bits &= bits - 1;
+
+            //by index, a control's change notification may add or remove attachments
+            auto& list = attachments[index];
+            for( size_t i = 0; i < list.size(); ++i )
+                list[i]->update();
+        }
+    }
+}
+
+//==============================================================================
+ParameterUpdateBatcher::Attachment::Attachment(ParameterUpdateBatcher& b, juce::RangedAudioParameter& param,
+                                               std::function<void(float)> onValueChange)
+    : batcher(b), parameter(param), setValue(std::move(onValueChange))
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+    const auto index = static_cast<size_t>(parameter.getParameterIndex());
+    jassert(index < batcher.attachments.size());
+    batcher.attachments[index].push_back(this);
+}
+
+ParameterUpdateBatcher::Attachment::~Attachment()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+    auto& list = batcher.attachments[static_cast<size_t>(parameter.getParameterIndex())];
+    list.erase(std::remove(list.begin(), list.end(), this), list.end());
+}
+
+void ParameterUpdateBatcher::Attachment::update()
+{
+    if( setValue )
+        setValue(parameter.convertFrom0to1(parameter.getValue()));
+}
+
+template<typename Callback>
+void ParameterUpdateBatcher::Attachment::callIfParameterValueChanged(float newDenormalisedValue, Callback&& callback)
+{
+    const auto newValue = parameter.convertTo0to1(newDenormalisedValue);
+    if( parameter.getValue() != newValue )
+        callback(newValue);
+}
+
+void ParameterUpdateBatcher::Attachment::setValueAsCompleteGesture(float newDenormalisedValue)
+{
+    callIfParameterValueChanged(newDenormalisedValue, [this](float newValue)
+    {
+        beginGesture();
+        parameter.setValueNotifyingHost(newValue);
+        endGesture();
+    });
+}
+
+void ParameterUpdateBatcher::Attachment::beginGesture()
+{
+    parameter.beginChangeGesture();
+}
+
+void ParameterUpdateBatcher::Attachment::setValueAsPartOfGesture(float newDenormalisedValue)
+{
+    callIfParameterValueChanged(newDenormalisedValue, [this](float newValue)
+    {
+        parameter.setValueNotifyingHost(newValue);
+    });
+}
+
+void ParameterUpdateBatcher::Attachment::endGesture()
+{
+    parameter.endChangeGesture();
+}
+
+//==============================================================================
+BatchedSliderAttachment::BatchedSliderAttachment(ParameterUpdateBatcher& batcher, juce::RangedAudioParameter& param,
+                                                 juce::Slider& s)
+    : slider(s), attachment(batcher, param, [this](float newValue) { setValue(newValue); })
+{
+    //the same range and text handling juce::SliderParameterAttachment sets up
+    slider.valueFromTextFunction = [&param](const juce::String& text)
+    {
+        return static_cast<double>(param.convertFrom0to1(param.getValueForText(text)));
+    };
+    slider.textFromValueFunction = [&param](double value)
+    {
+        return param.getText(param.convertTo0to1(static_cast<float>(value)), 0);
+    };
+    slider.setDoubleClickReturnValue(true, param.convertFrom0to1(param.getDefaultValue()));
+
+    auto range = param.getNormalisableRange();
+
+    auto convertFrom0To1 = [range](double start, double end, double normalised) mutable
+    {
+        range.start = static_cast<float>(start);
+        range.end = static_cast<float>(end);
+        return static_cast<double>(range.convertFrom0to1(static_cast<float>(normalised)));
+    };
+
+    auto convertTo0To1 = [range](double start, double end, double value) mutable
+    {
+        range.start = static_cast<float>(start);
+        range.end = static_cast<float>(end);
+        return static_cast<double>(range.convertTo0to1(static_cast<float>(value)));
+    };
+
+    auto snapToLegalValue = [range](double start, double end, double value) mutable
+    {
+        range.start = static_cast<float>(start);
+        range.end = static_cast<float>(end);
+        return static_cast<double>(range.snapToLegalValue(static_cast<float>(value)));
+    };
+
+    juce::NormalisableRange<double> sliderRange { static_cast<double>(range.start), static_cast<double>(range.end),
+                                                  std::move(convertFrom0To1), std::move(convertTo0To1),
+                                                  std::move(snapToLegalValue) };
+    sliderRange.interval = range.interval;
+    sliderRange.skew = range.skew;
+    sliderRange.symmetricSkew = range.symmetricSkew;
+    slider.setNormalisableRange(sliderRange);
+
+    attachment.update();
+    slider.valueChanged();
+    slider.addListener(this);
+}
+
+BatchedSliderAttachment::~BatchedSliderAttachment()
+{
+    slider.removeListener(this);
+}
+
+void BatchedSliderAttachment::setValue(float newValue)
+{
+    const juce::ScopedValueSetter<bool> svs(ignoreCallbacks, true);
+    slider.setValue(newValue, juce::sendNotificationSync);
+}
+
+void BatchedSliderAttachment::sliderValueChanged(juce::Slider*)
+{
+    if( ignoreCallbacks )
+        return;
+
+    attachment.setValueAsPartOfGesture(static_cast<float>(slider.getValue()));
+}
+
+//==============================================================================
+BatchedComboBoxAttachment::BatchedComboBoxAttachment(ParameterUpdateBatcher& batcher, juce::RangedAudioParameter& param,
+                                                     juce::ComboBox& c)
+    : comboBox(c), parameter(param), attachment(batcher, param, [this](float newValue) { setValue(newValue); })
+{
+    attachment.update();
+    comboBox.addListener(this);
+}
+
+BatchedComboBoxAttachment::~BatchedComboBoxAttachment()
+{
+    comboBox.removeListener(this);
+}
+
+void BatchedComboBoxAttachment::setValue(float newValue)
+{
+    const auto normalised = parameter.convertTo0to1(newValue);
+    const auto index = juce::roundToInt(normalised * static_cast<float>(comboBox.getNumItems() - 1));
+
+    if( index == comboBox.getSelectedItemIndex() )
+        return;
+
+    const juce::ScopedValueSetter<bool> svs(ignoreCallbacks, true);
+    comboBox.setSelectedItemIndex(index, juce::sendNotificationSync);
+}
+
+void BatchedComboBoxAttachment::comboBoxChanged(juce::ComboBox*)
+{
+    if( ignoreCallbacks )
+        return;
+
+    const auto numItems = comboBox.getNumItems();
+    const auto selected = static_cast<float>(comboBox.getSelectedItemIndex());
+    const auto normalised = numItems > 1 ? selected / static_cast<float>(numItems - 1) : 0.f;
+    attachment.setValueAsCompleteGesture(parameter.convertFrom0to1(normalised));
+}
+
+//==============================================================================
+BatchedButtonAttachment::BatchedButtonAttachment(ParameterUpdateBatcher& batcher, juce::RangedAudioParameter& param,
+                                                 juce::Button& b)
+    : button(b), attachment(batcher, param, [this](float newValue) { setValue(newValue); })
+{
+    attachment.update();
+    button.addListener(this);
+}
+
+BatchedButtonAttachment::~BatchedButtonAttachment()
+{
+    button.removeListener(this);
+}
+
+void BatchedButtonAttachment::setValue(float newValue)
+{
+    const juce::ScopedValueSetter<bool> svs(ignoreCallbacks, true);
+    button.setToggleState(newValue >= 0.5f, juce::sendNotificationSync);
+}
+
+void BatchedButtonAttachment::buttonClicked(juce::Button*)
+{
+    if( ignoreCallbacks )
+        return;
+
+    attachment.setValueAsCompleteGesture(button.getToggleState() ? 1.f : 0.f);
+}
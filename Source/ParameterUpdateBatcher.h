@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    ParameterUpdateBatcher.h
+    parameter changes for the editor, collected and handed over once a frame.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ juce's apvts attachments each listen to their own parameter and post a message for every
+ change that doesn't come from the message thread. a host automating a handful of
+ parameters queues hundreds of those a second per open editor, every one ending in a
+ repaint, and the meters and the analyzer stutter behind them.
+
+ here a change only sets the parameter's bit in a dirty set (lock free, any thread, no
+ message). the editor's timer calls flush(), and every control attached to a dirty
+ parameter gets the parameter's latest value once, however often it moved in between. so
+ the gui cost per frame is bounded by the number of controls, not by the automation.
+
+ the control -> parameter direction is unchanged: gestures and values go straight to the
+ parameter, like juce::ParameterAttachment. the attachments below are juce's slider, combo
+ box and button attachments with the other direction going through here.
+*/
+class ParameterUpdateBatcher : private juce::AudioProcessorParameter::Listener
+{
+public:
+    //one control's link to one parameter. message thread only
+    class Attachment
+    {
+    public:
+        //onValueChange gets the denormalised value, from flush() and from update()
+        Attachment(ParameterUpdateBatcher& batcher, juce::RangedAudioParameter& param,
+                   std::function<void(float)> onValueChange);
+        ~Attachment();
+
+        //hands the control the parameter's current value, flush() calls it for dirty parameters
+        void update();
+
+        void setValueAsCompleteGesture(float newDenormalisedValue);
+        void beginGesture();
+        void setValueAsPartOfGesture(float newDenormalisedValue);
+        void endGesture();
+
+    private:
+        friend class ParameterUpdateBatcher;
+
+        template<typename Callback>
+        void callIfParameterValueChanged(float newDenormalisedValue, Callback&& callback);
+
+        ParameterUpdateBatcher& batcher;
+        juce::RangedAudioParameter& parameter;
+        std::function<void(float)> setValue;
+
+        JUCE_DECLARE_NON_COPYABLE(Attachment)
+    };
+
+    //listens to every parameter the processor has, so it has to be built after they're added
+    explicit ParameterUpdateBatcher(juce::AudioProcessor& processor);
+    ~ParameterUpdateBatcher() override;
+
+    //message thread, once a frame
+    void flush();
+
+private:
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int, bool) override {}
+
+    static constexpr size_t bitsPerWord = 64;
+
+    juce::Array<juce::AudioProcessorParameter*> parameters;
+    //bit i is parameter index i
+    std::unique_ptr<std::atomic<uint64_t>[]> dirtyWords;
+    size_t numDirtyWords = 0;
+    //by parameter index, more than one editor or control can show the same parameter
+    std::vector<std::vector<Attachment*>> attachments;
+
+    JUCE_DECLARE_NON_COPYABLE(ParameterUpdateBatcher)
+};
+
+class BatchedSliderAttachment : private juce::Slider::Listener
+{
+public:
+    BatchedSliderAttachment(ParameterUpdateBatcher& batcher, juce::RangedAudioParameter& param, juce::Slider& slider);
+    ~BatchedSliderAttachment() override;
+
+private:
+    void setValue(float newValue);
+    void sliderValueChanged(juce::Slider*) override;
+    void sliderDragStarted(juce::Slider*) override { attachment.beginGesture(); }
+    void sliderDragEnded(juce::Slider*) override { attachment.endGesture(); }
+
+    juce::Slider& slider;
+    ParameterUpdateBatcher::Attachment attachment;
+    bool ignoreCallbacks = false;
+};
+
+class BatchedComboBoxAttachment : private juce::ComboBox::Listener
+{
+public:
+    BatchedComboBoxAttachment(ParameterUpdateBatcher& batcher, juce::RangedAudioParameter& param, juce::ComboBox& comboBox);
+    ~BatchedComboBoxAttachment() override;
+
+private:
+    void setValue(float newValue);
+    void comboBoxChanged(juce::ComboBox*) override;
+
+    juce::ComboBox& comboBox;
+    juce::RangedAudioParameter& parameter;
+    ParameterUpdateBatcher::Attachment attachment;
+    bool ignoreCallbacks = false;
+};
+
+class BatchedButtonAttachment : private juce::Button::Listener
+{
+public:
+    BatchedButtonAttachment(ParameterUpdateBatcher& batcher, juce::RangedAudioParameter& param, juce::Button& button);
+    ~BatchedButtonAttachment() override;
+
+private:
+    void setValue(float newValue);
+    void buttonClicked(juce::Button*) override;
+
+    juce::Button& button;
+    ParameterUpdateBatcher::Attachment attachment;
+    bool ignoreCallbacks = false;
+};
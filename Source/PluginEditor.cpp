@@ -10,6 +10,7 @@
 #include "PluginEditor.h"
 #include "RotarySliderWithLabels.h"
 #include <Utilities.h>
+#include "DSP/SharedResources.h"
 //==============================================================================
 
 // Modern color scheme for this plugin
@@ -306,38 +307,13 @@ void drawModuleBackground(juce::Graphics &g, juce::Rectangle<int> bounds)
 
 static juce::String getNameFromDSPOption(Audio_proAudioProcessor::DSP_Option option)
 {
-    switch (option)     
+    if( option == Audio_proAudioProcessor::DSP_Option::END_OF_LIST )
     {
-        case Audio_proAudioProcessor::DSP_Option::Phase:
-            return "PHASE";
-        case Audio_proAudioProcessor::DSP_Option::Chorus:
-            return "CHORUS";
-        case Audio_proAudioProcessor::DSP_Option::Overdrive:
-            return "OVERDRIVE";
-        case Audio_proAudioProcessor::DSP_Option::LadderFilter:
-            return "LADDERFILTER";
-        case Audio_proAudioProcessor::DSP_Option::GeneralFilter:
-            return "GEN FILTER";
-        case Audio_proAudioProcessor::DSP_Option::END_OF_LIST:
-            jassertfalse;
+        jassertfalse;
+        return "NO SELECTION";
     }
-    
-    return "NO SELECTION";
-}
-static Audio_proAudioProcessor::DSP_Option getDSPOptionFromName( juce::String name)
-{
-    if( name == "PHASE" )
-        return Audio_proAudioProcessor::DSP_Option::Phase;
-    if( name == "CHORUS" )
-        return Audio_proAudioProcessor::DSP_Option::Chorus;
-    if( name == "OVERDRIVE" )
-        return Audio_proAudioProcessor::DSP_Option::Overdrive;
-    if( name == "LADDERFILTER" )
-        return Audio_proAudioProcessor::DSP_Option::LadderFilter;
-    if( name == "GEN FILTER" )
-        return Audio_proAudioProcessor::DSP_Option::GeneralFilter;
-    
-    return Audio_proAudioProcessor::DSP_Option::END_OF_LIST;
+
+    return Audio_proAudioProcessor::getEffectDescriptor(option).displayName;
 }
 HorizontalConstrainer::HorizontalConstrainer(std::function<juce::Rectangle<int>()> confinerBoundsGetter, 
                                              std::function<juce::Rectangle<int>()> confineeBoundsGetter) :
@@ -678,9 +654,18 @@ void ExtendedTabbedButtonBar::mouseDown(const juce::MouseEvent &e)
     }
 }
 
+void ExtendedTabbedButtonBar::addOptionTab(Audio_proAudioProcessor::DSP_Option option)
+{
+    optionForNewTab = option;
+    addTab(getNameFromDSPOption(option), juce::Colours::white, -1);
+    optionForNewTab = Audio_proAudioProcessor::DSP_Option::END_OF_LIST;
+}
+
 juce::TabBarButton* ExtendedTabbedButtonBar::createTabButton(const juce::String& tabName, int tabIndex)
 {
-    auto dspOption = getDSPOptionFromName(tabName);
+    //tabs only come from addOptionTab()
+    auto dspOption = optionForNewTab;
+    jassert(dspOption != Audio_proAudioProcessor::DSP_Option::END_OF_LIST);
     auto etbb = std::make_unique<ExtendedTabBarButton>(tabName, *this, dspOption);
     etbb->addMouseListener(this, false);
     
@@ -733,49 +718,32 @@ void ExtendedTabbedButtonBar::removeListener(Listener* l)
     listeners.remove(l); 
 }
 
+//the tab button owns it, so the attachment goes with it when the tabs are rebuilt
+struct TabBypassButton : juce::ToggleButton
+{
+    TabBypassButton(ParameterUpdateBatcher& updates, juce::RangedAudioParameter& param) : attachment(updates, param, *this) {}
+    
+    BatchedButtonAttachment attachment;
+};
+
 void ExtendedTabbedButtonBar::addBypassButtonToTab(int tabIndex, Audio_proAudioProcessor::DSP_Option option)
 {
     auto* tabButton = getTabButton(tabIndex);
     if (!tabButton) return;
     
-    // Create bypass button
-    auto bypassButton = std::make_unique<juce::ToggleButton>();
-    bypassButton->setButtonText("X");
-    bypassButton->setTooltip("Bypass " + getNameFromDSPOption(option));
-    bypassButton->setSize(16, 16);
-    
     // Get the bypass parameter for this DSP option
-    juce::AudioParameterBool* bypassParam = nullptr;
-    switch (option)
-    {
-        case Audio_proAudioProcessor::DSP_Option::Phase:
-            bypassParam = processor.phaserBypass;
-            break;
-        case Audio_proAudioProcessor::DSP_Option::Chorus:
-            bypassParam = processor.chorusBypass;
-            break;
-        case Audio_proAudioProcessor::DSP_Option::Overdrive:
-            bypassParam = processor.overdriveBypass;
-            break;
-        case Audio_proAudioProcessor::DSP_Option::LadderFilter:
-            bypassParam = processor.ladderFilterBypass;
-            break;
-        case Audio_proAudioProcessor::DSP_Option::GeneralFilter:
-            bypassParam = processor.generalFilterBypass;
-            break;
-        case Audio_proAudioProcessor::DSP_Option::END_OF_LIST:
-        default:
-            return; // No bypass parameter for this option
-    }
+    if( option == Audio_proAudioProcessor::DSP_Option::END_OF_LIST )
+        return; // No bypass parameter for this option
+
+    auto* bypassParam = processor.getBypassParameter(option);
     
     if (bypassParam)
     {
-        // Create attachment to connect button to parameter
-        auto attachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
-            processor.apvts, bypassParam->getName(100), *bypassButton);
-        
-        // Store the attachment so it doesn't get destroyed
-        bypassAttachments.push_back(std::move(attachment));
+        // Create bypass button, it carries its own attachment
+        auto bypassButton = std::make_unique<TabBypassButton>(processor.guiUpdates, *bypassParam);
+        bypassButton->setButtonText("X");
+        bypassButton->setTooltip("Bypass " + getNameFromDSPOption(option));
+        bypassButton->setSize(16, 16);
         
         // Set the bypass button as extra component on the tab
         tabButton->setExtraComponent(bypassButton.release(), juce::TabBarButton::afterText);
@@ -823,6 +791,105 @@ void DSP_Gui::resized()
     rightInputMeter.setBounds(rightInputArea);
     rightOutputMeter.setBounds(rightOutputArea);
 
+    // hidden panels get the bounds too, so showing one doesn't need a layout pass
+    panelBounds = bounds;
+    for( auto& panel : panels )
+        if( panel != nullptr )
+            panel->setBounds(panelBounds);
+}
+void DSP_Gui::paint( juce::Graphics& g )
+{
+    // Draw modern module background
+    drawModuleBackground(g, getLocalBounds());
+}
+
+void DSP_Gui::updateMeters()
+{
+    leftInputMeter.repaint();
+    rightInputMeter.repaint();
+    leftOutputMeter.repaint();
+    rightOutputMeter.repaint();
+}
+void DSP_Gui::showPanel( Audio_proAudioProcessor::DSP_Option option )
+{
+    auto index = static_cast<size_t>(option);
+    if( index >= panels.size() )
+    {
+        jassertfalse;
+        return;
+    }
+    
+    auto& panel = panels[index];
+    if( panel == nullptr )
+    {
+        const auto& params = processor.getparamsforoption(option);
+        jassert(params.size() > 0);
+        panel = std::make_unique<EffectPanel>(processor, params);
+        panel->setBounds(panelBounds);
+        addChildComponent(*panel);
+    }
+    
+    if( currentPanel == panel.get() )
+        return;
+    
+    if( currentPanel != nullptr )
+        currentPanel->setVisible(false);
+    
+    currentPanel = panel.get();
+    currentPanel->setVisible(true);
+}
+
+EffectPanel::EffectPanel(Audio_proAudioProcessor& p, const std::vector< juce::RangedAudioParameter* >& params) : processor(p)
+{
+    //float is sliders
+    //bool is checkboxes
+    //choice is comboboxes
+    //the parameter says which it is, so there's no cast per control
+    for(size_t i = 0; i < params.size(); i++)
+    {
+
+        auto p = params[i];
+
+        if( p->isBoolean() )
+        {
+            buttons.push_back(std::make_unique<juce::ToggleButton>("Bypass"));
+            auto& btn = *buttons.back();
+            buttonAttachments.push_back(std::make_unique<BatchedButtonAttachment>(processor.guiUpdates, *p, btn));
+        }
+        else if( p->isDiscrete() )
+        {
+            //make a combobox. a choice parameter's value strings are its choices
+            comboBoxes.push_back( std::make_unique<juce::ComboBox>());
+            auto& cb = *comboBoxes.back();
+            cb.addItemList(p->getAllValueStrings(), 1);
+            comboBoxAttachments.push_back(std::make_unique<BatchedComboBoxAttachment>(processor.guiUpdates, *p, cb));
+        }
+        else
+        {
+                   //sliders are used for float and choice params
+            sliders.push_back(std::make_unique<RotarySliderWithLabels>(p, p->label, p->getName(100)));
+            auto& slider = *sliders.back();
+            SimpleMBComp::addLabelPairs(slider.labels, *p, p->label);
+            slider.setSliderStyle(juce::Slider::SliderStyle::LinearVertical);
+            sliderAttachments.push_back(std::make_unique<BatchedSliderAttachment>(processor.guiUpdates, *p, slider));
+        }
+    }
+    //the IR file isn't a parameter, so the convolution page gets its own buttons
+    if( std::find(params.begin(), params.end(), processor.getBypassParameter(Audio_proAudioProcessor::DSP_Option::Convolution)) != params.end() )
+        addImpulseResponseButtons();
+
+     for( auto& slider : sliders )
+        addAndMakeVisible(slider.get());
+    for( auto& cb : comboBoxes)
+        addAndMakeVisible(cb.get());
+    for( auto& btn : buttons )
+        addAndMakeVisible(btn.get());
+}
+
+void EffectPanel::resized()
+{
+    auto bounds = getLocalBounds();
+
     // Enhanced control layout with better visual hierarchy
     
     // Buttons at top with improved styling
@@ -880,88 +947,584 @@ void DSP_Gui::resized()
         }
     }
     
-    // Add subtle visual cues - this could be used for parameter grouping in the future
-    // (Implementation would go in paint method)
 }
-void DSP_Gui::paint( juce::Graphics& g )
+
+void EffectPanel::visibilityChanged()
+{
+    //the IR can change while the page is hidden, e.g. a preset or session reload
+    if( loadIRButton != nullptr && isVisible() )
+    {
+        auto irFile = processor.getImpulseResponseFile();
+        loadIRButton->setButtonText(irFile == juce::File() ? juce::String("Load IR...") : irFile.getFileName());
+    }
+}
+
+void EffectPanel::addImpulseResponseButtons()
+{
+    auto irFile = processor.getImpulseResponseFile();
+
+    buttons.push_back(std::make_unique<juce::TextButton>(irFile == juce::File() ? juce::String("Load IR...")
+                                                                                  : irFile.getFileName()));
+    auto* loadButton = buttons.back().get();
+    loadIRButton = loadButton;
+    loadButton->setTooltip("Load an impulse response (wav, aiff, flac)");
+    loadButton->onClick = [this, loadButton]()
+    {
+        irChooser = std::make_unique<juce::FileChooser>("Load Impulse Response",
+                                                        processor.getImpulseResponseFile(),
+                                                        "*.wav;*.aif;*.aiff;*.flac");
+
+        auto flags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles;
+        //the chooser belongs to this panel, which lives as long as the editor
+        irChooser->launchAsync(flags, [this, loadButton](const juce::FileChooser& chooser)
+        {
+            auto file = chooser.getResult();
+            if( file == juce::File() )
+                return;
+
+            processor.loadImpulseResponse(file);
+            loadButton->setButtonText(file.getFileName());
+        });
+    };
+
+    buttons.push_back(std::make_unique<juce::TextButton>("Clear IR"));
+    buttons.back()->onClick = [this, loadButton]()
+    {
+        processor.loadImpulseResponse({});
+        loadButton->setButtonText("Load IR...");
+    };
+}
+
+RoutingControls::RoutingControls(Audio_proAudioProcessor& p) : processor(p)
+{
+    auto& updates = processor.guiUpdates;
+    
+    stereoModeComboBox.addItemList(processor.stereoMode->choices, 1);
+    stereoModeComboBox.setTooltip("Mid/Side runs the left chain on mid and the right chain on side");
+    stereoModeAttachment = std::make_unique<BatchedComboBoxAttachment>(updates, *processor.stereoMode, stereoModeComboBox);
+    addAndMakeVisible(stereoModeComboBox);
+    
+    bandsComboBox.addItemList(processor.multibandBands->choices, 1);
+    bandsComboBox.setTooltip("Split the signal into bands, each band runs the whole chain");
+    bandsAttachment = std::make_unique<BatchedComboBoxAttachment>(updates, *processor.multibandBands, bandsComboBox);
+    addAndMakeVisible(bandsComboBox);
+    
+    oversamplingComboBox.addItemList(processor.oversamplingFactor->choices, 1);
+    oversamplingComboBox.setTooltip("Run the whole chain at a multiple of the host rate. Adds latency and costs CPU in proportion");
+    oversamplingAttachment = std::make_unique<BatchedComboBoxAttachment>(updates, *processor.oversamplingFactor, oversamplingComboBox);
+    addAndMakeVisible(oversamplingComboBox);
+    
+    oversamplingFilterComboBox.addItemList(processor.oversamplingFilter->choices, 1);
+    oversamplingFilterComboBox.setTooltip("Minimum phase has less latency, linear phase keeps the phase flat up to the top");
+    oversamplingFilterAttachment = std::make_unique<BatchedComboBoxAttachment>(updates, *processor.oversamplingFilter, oversamplingFilterComboBox);
+    addAndMakeVisible(oversamplingFilterComboBox);
+    
+    renderQualityButton.setTooltip("Offline bounces run at 4x or more, with precise saturation and per sample parameter updates");
+    renderQualityAttachment = std::make_unique<BatchedButtonAttachment>(updates, *processor.renderQuality, renderQualityButton);
+    addAndMakeVisible(renderQualityButton);
+    
+    for( size_t i = 0; i < crossoverSliders.size(); ++i )
+    {
+        auto& slider = crossoverSliders[i];
+        slider.setSliderStyle(juce::Slider::SliderStyle::LinearBar);
+        slider.setTooltip(processor.crossoverFreqHz[i]->getName(100));
+        crossoverAttachments.push_back(std::make_unique<BatchedSliderAttachment>(updates, *processor.crossoverFreqHz[i], slider));
+        addAndMakeVisible(slider);
+    }
+    
+    for( size_t i = 0; i < bandButtons.size(); ++i )
+    {
+        auto& button = bandButtons[i];
+        button.setButtonText("B" + juce::String(i + 1));
+        button.setTooltip(processor.bandProcess[i]->getName(100));
+        bandAttachments.push_back(std::make_unique<BatchedButtonAttachment>(updates, *processor.bandProcess[i], button));
+        addAndMakeVisible(button);
+    }
+}
+
+void RoutingControls::resized()
+{
+    auto bounds = getLocalBounds().reduced(2);
+    
+    stereoModeComboBox.setBounds(bounds.removeFromLeft(100));
+    bounds.removeFromLeft(8);
+    bandsComboBox.setBounds(bounds.removeFromLeft(100));
+    bounds.removeFromLeft(8);
+    oversamplingComboBox.setBounds(bounds.removeFromLeft(60));
+    bounds.removeFromLeft(4);
+    oversamplingFilterComboBox.setBounds(bounds.removeFromLeft(120));
+    bounds.removeFromLeft(8);
+    renderQualityButton.setBounds(bounds.removeFromLeft(90));
+    bounds.removeFromLeft(8);
+    
+    auto buttonArea = bounds.removeFromRight(48 * static_cast<int>(bandButtons.size()));
+    for( auto& button : bandButtons )
+        button.setBounds(buttonArea.removeFromLeft(48));
+    
+    bounds.removeFromRight(8);
+    auto sliderWidth = bounds.getWidth() / static_cast<int>(crossoverSliders.size());
+    for( auto& slider : crossoverSliders )
+        slider.setBounds(bounds.removeFromLeft(sliderWidth).reduced(2, 0));
+}
+
+DeadlinePanel::DeadlinePanel(Audio_proAudioProcessor& p) : processor(p)
+{
+    setTooltip("processBlock time as a share of the buffer's duration. "
+               "near misses are blocks over 80%, overruns blocks over 100%");
+    
+    resetButton.onClick = [this]() { processor.deadlineMonitor.reset(); };
+    addAndMakeVisible(resetButton);
+    
+    dumpButton.setTooltip("Save the histogram as json");
+    dumpButton.onClick = [this]()
+    {
+        dumpChooser = std::make_unique<juce::FileChooser>("Save Deadline Histogram",
+                                                          juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                                                              .getChildFile("AudioProDeadlines.json"),
+                                                          "*.json");
+        
+        auto flags = juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::warnAboutOverwriting;
+        dumpChooser->launchAsync(flags, [this](const juce::FileChooser& chooser)
+        {
+            auto file = chooser.getResult();
+            if( file == juce::File() )
+                return;
+            
+            if( ! processor.deadlineMonitor.writeToFile(file) )
+                juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon,
+                                                       "Dump failed", "Couldn't write " + file.getFullPathName());
+        });
+    };
+    addAndMakeVisible(dumpButton);
+}
+
+void DeadlinePanel::resized()
+{
+    auto bounds = getLocalBounds().reduced(0, 3);
+    dumpButton.setBounds(bounds.removeFromRight(60));
+    bounds.removeFromRight(4);
+    resetButton.setBounds(bounds.removeFromRight(50));
+    bounds.removeFromRight(8);
+    textArea = bounds;
+}
+
+void DeadlinePanel::paint(juce::Graphics& g)
+{
+    auto percent = [](float load) { return juce::String(juce::roundToInt(load * 100.f)) + "%"; };
+    
+    auto text = "p50 " + percent(snapshot.p50)
+              + "  p95 " + percent(snapshot.p95)
+              + "  p99 " + percent(snapshot.p99)
+              + "  max " + percent(snapshot.max)
+              + "  near " + juce::String(static_cast<juce::int64>(snapshot.nearMisses))
+              + "  over " + juce::String(static_cast<juce::int64>(snapshot.overruns));
+    
+    auto colour = snapshot.overruns > 0 ? juce::Colours::red
+                : snapshot.nearMisses > 0 ? juce::Colours::orange
+                : PluginColors::getTextPrimary();
+    
+    g.setColour(colour);
+    g.setFont(juce::Font(juce::FontOptions(12.0f)));
+    g.drawText(text, textArea, juce::Justification::centredRight, true);
+}
+
+void DeadlinePanel::update()
+{
+    auto newSnapshot = processor.deadlineMonitor.getSnapshot();
+    if( newSnapshot.numBlocks == snapshot.numBlocks )
+        return;
+    
+    snapshot = newSnapshot;
+    repaint(textArea);
+}
+
+SpectrumOverlay::Transform::Transform(int order) : fft(order), window(static_cast<size_t>(1 << order))
+{
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), window.size(), juce::dsp::WindowingFunction<float>::hann, false);
+}
+
+std::shared_ptr<const SpectrumOverlay::Transform> SpectrumOverlay::Transform::get(int order)
+{
+    return SharedResources::get<Transform>("analyzer " + juce::String(order), [order] { return std::make_shared<Transform>(order); });
+}
+
+SpectrumOverlay::SpectrumOverlay(Audio_proAudioProcessor& p) : processor(p)
+{
+    for( int order = minFFTOrder; order <= maxFFTOrder; ++order )
+        transforms[static_cast<size_t>(order - minFFTOrder)] = Transform::get(order);
+    
+    //blackman windowed sinc at a quarter of the input rate. flat to 1/8 of it and about
+    //-75 dB from 3/8 up, which is all that can fold back into the band a level shows
+    constexpr auto centre = halfbandLength / 2;
+    constexpr auto pi = juce::MathConstants<float>::pi;
+    auto sum = 0.f;
+    for( int n = 0; n < halfbandLength; ++n )
+    {
+        auto x = 0.5f * static_cast<float>(n - centre);
+        auto sinc = n == centre ? 1.f : std::sin(pi * x) / (pi * x);
+        auto phase = 2.f * pi * static_cast<float>(n) / static_cast<float>(halfbandLength - 1);
+        auto blackman = 0.42f - 0.5f * std::cos(phase) + 0.08f * std::cos(2.f * phase);
+        
+        halfband[static_cast<size_t>(n)] = sinc * blackman;
+        sum += halfband[static_cast<size_t>(n)];
+    }
+    juce::FloatVectorOperations::multiply(halfband.data(), 1.f / sum, halfbandLength);
+    
+    resetLevels(pre);
+    resetLevels(post);
+    
+    viewBox.addItemList({ "Pre + Post", "Post", "Difference" }, 1);
+    viewBox.setSelectedItemIndex(static_cast<int>(view), juce::dontSendNotification);
+    viewBox.setTooltip("Difference shows the output minus the input, i.e. what the chain does to each frequency");
+    viewBox.onChange = [this]()
+    {
+        view = static_cast<View>(viewBox.getSelectedItemIndex());
+        rebuildPaths();
+        repaint();
+    };
+    addAndMakeVisible(viewBox);
+    
+    multiResolutionButton.setTooltip("Long ffts for the lows and short ones for the highs: finer bass detail and sharper transients");
+    multiResolutionButton.onClick = [this]()
+    {
+        multiResolution = multiResolutionButton.getToggleState();
+        
+        //the lower levels weren't fed while it was off
+        resetLevels(pre);
+        resetLevels(post);
+        updateBinPositions();
+        rebuildPaths();
+        repaint();
+    };
+    addAndMakeVisible(multiResolutionButton);
+    
+    startTimerHz(30);
+}
+
+SpectrumOverlay::~SpectrumOverlay()
+{
+    stopTimer();
+}
+
+void SpectrumOverlay::resized()
+{
+    auto bounds = getModuleBackgroundArea(getLocalBounds());
+    
+    auto controls = bounds.withTrimmedTop(6).withTrimmedRight(8).removeFromTop(22);
+    viewBox.setBounds(controls.removeFromRight(120));
+    controls.removeFromRight(6);
+    multiResolutionButton.setBounds(controls.removeFromRight(90));
+    
+    plotArea = bounds.reduced(12, 8).toFloat();
+    updateBinPositions();
+    rebuildPaths();
+}
+
+void SpectrumOverlay::paint(juce::Graphics& g)
 {
-    // Draw modern module background
     drawModuleBackground(g, getLocalBounds());
+    
+    const auto differenceView = view == View::Difference;
+    const auto lowDecibels = differenceView ? -differenceRange : minDecibels;
+    const auto highDecibels = differenceView ? differenceRange : maxDecibels;
+    const auto decibelStep = differenceView ? 6.f : 12.f;
+    
+    g.setFont(juce::Font(juce::FontOptions(10.0f)));
+    
+    for( auto freq : { 50.f, 100.f, 200.f, 500.f, 1000.f, 2000.f, 5000.f, 10000.f } )
+    {
+        auto x = plotArea.getX() + plotArea.getWidth() * juce::mapFromLog10(freq, 20.f, 20000.f);
+        g.setColour(PluginColors::getAnalyzerGridColor().brighter(0.15f));
+        g.drawVerticalLine(juce::roundToInt(x), plotArea.getY(), plotArea.getBottom());
+        
+        g.setColour(PluginColors::getScaleTextColor());
+        auto label = freq >= 1000.f ? juce::String(freq / 1000.f) + "k" : juce::String(freq);
+        g.drawText(label, juce::Rectangle<float>(x + 2.f, plotArea.getBottom() - 12.f, 30.f, 12.f), juce::Justification::centredLeft);
+    }
+    
+    for( auto decibels = lowDecibels + decibelStep; decibels < highDecibels; decibels += decibelStep )
+    {
+        auto y = juce::jmap(decibels, lowDecibels, highDecibels, plotArea.getBottom(), plotArea.getY());
+        g.setColour(decibels == 0.f ? PluginColors::getBorderLight() : PluginColors::getAnalyzerGridColor().brighter(0.15f));
+        g.drawHorizontalLine(juce::roundToInt(y), plotArea.getX(), plotArea.getRight());
+        
+        g.setColour(PluginColors::getScaleTextColor());
+        g.drawText(juce::String(juce::roundToInt(decibels)), juce::Rectangle<float>(plotArea.getX() + 2.f, y - 12.f, 30.f, 12.f), juce::Justification::centredLeft);
+    }
+    
+    if( differenceView )
+    {
+        g.setColour(PluginColors::getAccentOrange());
+        g.strokePath(differencePath, juce::PathStrokeType(1.5f));
+        return;
+    }
+    
+    if( view == View::PreAndPost )
+    {
+        g.setColour(PluginColors::getInputSignalColor().withAlpha(0.6f));
+        g.strokePath(pre.path, juce::PathStrokeType(1.f));
+    }
+    
+    g.setColour(PluginColors::getOutputSignalColor());
+    g.strokePath(post.path, juce::PathStrokeType(1.5f));
 }
 
-void DSP_Gui::updateMeters()
+void SpectrumOverlay::timerCallback()
 {
-    leftInputMeter.repaint();
-    rightInputMeter.repaint();
-    leftOutputMeter.repaint();
-    rightOutputMeter.repaint();
+    auto rate = processor.getSampleRate();
+    if( rate != sampleRate )
+    {
+        sampleRate = rate;
+        updateBinPositions();
+    }
+    
+    //every block pushes pre before post, so pre always has at least as many waiting. taking
+    //exactly as many keeps the two histories in step, sample for sample
+    const auto numPulled = pullSamples(processor.postTap, post, std::numeric_limits<int>::max());
+    if( numPulled == 0 )
+        return;
+    
+    pullSamples(processor.preTap, pre, numPulled);
+    analyze();
+    
+    rebuildPaths();
+    repaint();
 }
-void DSP_Gui::rebuildInterface( std::vector< juce::RangedAudioParameter* > params )
+
+int SpectrumOverlay::pullSamples(AnalyzerTap& tap, Trace& trace, int maxSamples)
 {
-    //float is sliders
-    //bool is checkboxes
-    //int is comboboxes
-        sliderAttachments.clear();
-    comboBoxAttachments.clear();
-    buttonAttachments.clear();
-    
-    sliders.clear();
-    comboBoxes.clear();
-    buttons.clear();
-    for(size_t i = 0; i < params.size(); i++)
+    auto numPulled = 0;
+    
+    //the workspace doubles as the pull buffer
+    while( auto numSamples = tap.pull(workspace.data(), juce::jmin(maxFFTSize, maxSamples - numPulled)) )
+    {
+        numPulled += numSamples;
+        write(trace.levels[0], workspace.data(), numSamples);
+        
+        //every level is decimated in place from the one above
+        for( size_t i = 1; i < static_cast<size_t>(getNumActiveLevels()) && numSamples > 0; ++i )
+        {
+            numSamples = decimate(trace.levels[i], workspace.data(), numSamples);
+            write(trace.levels[i], workspace.data(), numSamples);
+        }
+    }
+    
+    return numPulled;
+}
+
+int SpectrumOverlay::decimate(Level& level, float* samples, int numSamples) const
+{
+    //output j is written after inputs 2j and 2j + 1 have been read, so this can run in place
+    auto numOutputs = 0;
+    for( int i = 0; i < numSamples; ++i )
     {
+        //stored twice so the taps can be read without wrapping
+        auto index = static_cast<size_t>(level.delayIndex);
+        level.delay[index] = samples[i];
+        level.delay[index + halfbandLength] = samples[i];
+        level.delayIndex = (level.delayIndex + 1) % halfbandLength;
+        
+        level.oddSample = ! level.oddSample;
+        if( level.oddSample )
+            continue;
+        
+        auto* taps = level.delay.data() + level.delayIndex;
+        samples[numOutputs++] = std::inner_product(halfband.begin(), halfband.end(), taps, 0.f);
+    }
+    
+    return numOutputs;
+}
 
-        auto p = params[i];
+void SpectrumOverlay::write(Level& level, const float* samples, int numSamples)
+{
+    //never more than maxFFTSize at a time, that's the most pullSamples() asks the tap for
+    auto first = juce::jmin(numSamples, historySize - level.writeIndex);
+    std::copy_n(samples, first, level.history.data() + level.writeIndex);
+    std::copy_n(samples + first, numSamples - first, level.history.data());
+    
+    level.writeIndex = (level.writeIndex + numSamples) % historySize;
+    level.numNewSamples += numSamples;
+}
 
-                if( auto* choice = dynamic_cast<juce::AudioParameterChoice*>(params[i]) )
+void SpectrumOverlay::analyze()
+{
+    //what comes out of the chain went in getLatencySamples() earlier, so the pre window ends
+    //that much further back. each level runs at half the rate of the one above
+    const auto latency = processor.getLatencySamples();
+    
+    for( int i = 0; i < getNumActiveLevels(); ++i )
+    {
+        auto& postLevel = post.levels[static_cast<size_t>(i)];
+        auto& preLevel = pre.levels[static_cast<size_t>(i)];
+        const auto order = getFFTOrder(i);
+        const auto size = 1 << order;
+        
+        //half an fft of new samples between transforms, the slow levels mostly sit this out.
+        //both histories get the same samples, so post's count stands for both
+        if( postLevel.numNewSamples < size / 2 )
+            continue;
+        
+        postLevel.numNewSamples = 0;
+        preLevel.numNewSamples = 0;
+        auto& transform = *transforms[static_cast<size_t>(order - minFFTOrder)];
+        
+        //the newest 'size' samples of post and the 'size' before the latency of pre, oldest first.
+        //post goes in the real part, pre in the imaginary part
+        const auto preOffset = juce::jmin(latency >> i, historySize - size);
+        auto postIndex = (postLevel.writeIndex - size + historySize) % historySize;
+        auto preIndex = (preLevel.writeIndex - size - preOffset + 2 * historySize) % historySize;
+        for( size_t n = 0; n < static_cast<size_t>(size); ++n )
         {
-            //make a combobox
-            comboBoxes.push_back( std::make_unique<juce::ComboBox>());
-            auto& cb = *comboBoxes.back();
-            cb.addItemList(choice->choices, 1);
-            comboBoxAttachments.push_back(std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(processor.apvts, p->getName(100), cb));
+            const auto w = transform.window[n];
+            fftInput[n] = { postLevel.history[static_cast<size_t>(postIndex)] * w, preLevel.history[static_cast<size_t>(preIndex)] * w };
+            postIndex = (postIndex + 1) % historySize;
+            preIndex = (preIndex + 1) % historySize;
         }
-        else if( auto* toggle = dynamic_cast<juce::AudioParameterBool*>(params[i]) )
+        
+        transform.fft.perform(fftInput.data(), fftOutput.data(), false);
+        
+        //the two real spectra come back apart from the conjugate symmetry:
+        //post = (Z[k] + conj Z[N - k]) / 2, pre = (Z[k] - conj Z[N - k]) / 2i.
+        //a full scale sine reads 0 dB through the hann window, 4 / size with the halves folded
+        //in. then to the 2k fft's bin width, see multiResolutionOrders
+        const auto binWidthRatio = static_cast<float>((1 << i) * size) / static_cast<float>(maxFFTSize);
+        const auto scale = 2.f / static_cast<float>(size) * std::sqrt(binWidthRatio);
+        auto smooth = [](float& smoothed, float decibels)
         {
-
-          
-            buttons.push_back(std::make_unique<juce::ToggleButton>("Bypass"));
-            auto& btn = *buttons.back();
-            buttonAttachments.push_back(std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(processor.apvts, p->getName(100), btn));
+            //rises straight away, falls back over a few frames
+            smoothed = decibels > smoothed ? decibels : smoothed + (decibels - smoothed) * 0.3f;
+        };
+        
+        for( size_t bin = 0; bin <= static_cast<size_t>(size / 2); ++bin )
+        {
+            const auto z = fftOutput[bin];
+            const auto mirrored = std::conj(fftOutput[(static_cast<size_t>(size) - bin) & static_cast<size_t>(size - 1)]);
+            
+            smooth(postLevel.decibels[bin], juce::Decibels::gainToDecibels(std::abs(z + mirrored) * scale, minDecibels));
+            smooth(preLevel.decibels[bin], juce::Decibels::gainToDecibels(std::abs(z - mirrored) * scale, minDecibels));
         }
+    }
+}
+
+void SpectrumOverlay::resetLevels(Trace& trace)
+{
+    for( auto& level : trace.levels )
+    {
+        level.history.fill(0.f);
+        level.writeIndex = 0;
+        level.numNewSamples = 0;
+        level.decibels.fill(minDecibels);
+        level.delay.fill(0.f);
+        level.delayIndex = 0;
+        level.oddSample = false;
+    }
+}
+
+template<typename LevelGetter>
+void SpectrumOverlay::buildPath(juce::Path& path, LevelGetter&& getDecibels, float lowDecibels, float highDecibels) const
+{
+    path.clear();
+    
+    auto addPoint = [&](float x, float level)
+    {
+        auto y = juce::jmap(juce::jlimit(lowDecibels, highDecibels, level), lowDecibels, highDecibels, plotArea.getBottom(), plotArea.getY());
+        if( path.isEmpty() )
+            path.startNewSubPath(x, y);
         else
+            path.lineTo(x, y);
+    };
+    
+    //the top octaves have many bins to a pixel, those get drawn as one point at the highest level
+    auto columnX = -1.f, columnLevel = lowDecibels;
+    
+    //lowest frequencies first, they're on the last level
+    for( int level = getNumActiveLevels() - 1; level >= 0; --level )
+    {
+        auto& positions = binX[static_cast<size_t>(level)];
+        for( size_t bin = 1; bin < positions.size(); ++bin )
         {
-                   //sliders are used for float and choice params
-            sliders.push_back(std::make_unique<RotarySliderWithLabels>(p, p->label, p->getName(100)));
-            auto& slider = *sliders.back();
-            SimpleMBComp::addLabelPairs(slider.labels, *p, p->label);
-            slider.setSliderStyle(juce::Slider::SliderStyle::LinearVertical);
-            sliderAttachments.push_back(std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(processor.apvts, p->getName(100), slider));
+            auto x = positions[bin];
+            if( x < 0.f )
+                continue;
+            
+            auto decibels = getDecibels(static_cast<size_t>(level), bin);
+            if( columnX >= 0.f && x - columnX < 1.f )
+            {
+                columnLevel = juce::jmax(columnLevel, decibels);
+                continue;
+            }
+            
+            if( columnX >= 0.f )
+                addPoint(columnX, columnLevel);
+            
+            columnX = x;
+            columnLevel = decibels;
         }
     }
-     for( auto& slider : sliders )
-        addAndMakeVisible(slider.get());
-    for( auto& cb : comboBoxes)
-        addAndMakeVisible(cb.get());
-    for( auto& btn : buttons )
-        addAndMakeVisible(btn.get());
     
-    resized();
-
+    if( columnX >= 0.f )
+        addPoint(columnX, columnLevel);
 }
 
+void SpectrumOverlay::rebuildPaths()
+{
+    if( view == View::Difference )
+    {
+        buildPath(differencePath, [this](size_t level, size_t bin)
+        {
+            return post.levels[level].decibels[bin] - pre.levels[level].decibels[bin];
+        }, -differenceRange, differenceRange);
+        return;
+    }
+    
+    auto levelsOf = [](const Trace& trace)
+    {
+        return [&trace](size_t level, size_t bin) { return trace.levels[level].decibels[bin]; };
+    };
+    
+    buildPath(post.path, levelsOf(post), minDecibels, maxDecibels);
+    if( view == View::PreAndPost )
+        buildPath(pre.path, levelsOf(pre), minDecibels, maxDecibels);
+}
 
+void SpectrumOverlay::updateBinPositions()
+{
+    for( int i = 0; i < numLevels; ++i )
+    {
+        auto& positions = binX[static_cast<size_t>(i)];
+        positions.fill(-1.f);
+        
+        if( i >= getNumActiveLevels() || sampleRate <= 0.0 )
+            continue;
+        
+        //see the note on multiResolutionOrders
+        const auto size = 1 << getFFTOrder(i);
+        const auto levelRate = sampleRate / (1 << i);
+        const auto lowEdge = multiResolution && i < numLevels - 1 ? sampleRate / (1 << (i + 3)) : 0.0;
+        const auto highEdge = multiResolution && i > 0 ? sampleRate / (1 << (i + 2)) : sampleRate;
+        
+        for( int bin = 0; bin <= size / 2; ++bin )
+        {
+            auto freq = bin * levelRate / size;
+            if( freq < lowEdge || freq >= highEdge || freq < 20.0 || freq > 20000.0 )
+                continue;
+            
+            positions[static_cast<size_t>(bin)] = plotArea.getX() + plotArea.getWidth() * juce::mapFromLog10(static_cast<float>(freq), 20.f, 20000.f);
+        }
+    }
+}
 
 Audio_proAudioProcessorEditor::Audio_proAudioProcessorEditor (Audio_proAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p), customLookAndFeel(std::make_unique<CustomLookAndFeel>())
+    : AudioProcessorEditor (&p), audioProcessor (p)
 {
     // Apply modern look and feel
-    setLookAndFeel(customLookAndFeel.get());
+    setLookAndFeel(&customLookAndFeel.get());
     
     // Add components in proper Z-order
-    addAndMakeVisible(analyzer);
     addAndMakeVisible(tabbedComponent);
     addAndMakeVisible(dspGui);
+    addAndMakeVisible(routingControls);
+    addAndMakeVisible(deadlinePanel);
     
     // Set up interaction listeners
     tabbedComponent.addListener(this);
@@ -985,9 +1548,9 @@ Audio_proAudioProcessorEditor::Audio_proAudioProcessorEditor (Audio_proAudioProc
 
 Audio_proAudioProcessorEditor::~Audio_proAudioProcessorEditor()
 {   
+    audioProcessor.setEditorVisible(false);
     setLookAndFeel(nullptr);
     tabbedComponent.removeListener(this);
-    customLookAndFeel.reset();
 }
 
 //==============================================================================
@@ -1040,8 +1603,11 @@ void Audio_proAudioProcessorEditor::resized()
 {
     auto bounds = getLocalBounds();
     
-    // Reserve space for title bar
-    bounds.removeFromTop(25);
+    // Reserve space for title bar, the load readout sits on its right
+    deadlinePanel.setBounds(bounds.removeFromTop(25).removeFromRight(460).reduced(8, 0));
+    
+    // Routing strip (multiband) under the title
+    routingControls.setBounds(bounds.removeFromTop(28).reduced(8, 0));
     
     // Add padding around the entire interface
     bounds.reduce(8, 8);
@@ -1065,7 +1631,9 @@ void Audio_proAudioProcessorEditor::resized()
     dspGui.setBounds(bounds);
     
     // Analyzer with proper padding and rounded corners consideration
-    analyzer.setBounds(analyzerArea.reduced(2));
+    analyzerBounds = analyzerArea.reduced(2);
+    if( analyzer != nullptr )
+        analyzer->setBounds(analyzerBounds);
     
     // Ensure minimum size constraints
     auto minSize = juce::Point<int>(650, 450);
@@ -1105,7 +1673,7 @@ void Audio_proAudioProcessorEditor::addTabsFromDSPOrder(Audio_proAudioProcessor:
         tabbedComponent.clearTabs();
     for( auto v : newOrder ) 
     {
-        tabbedComponent.addTab(getNameFromDSPOption(v), juce::Colours::white, -1);
+        tabbedComponent.addOptionTab(v);
     }
  
     rebuildInterface();
@@ -1118,16 +1686,35 @@ void Audio_proAudioProcessorEditor::rebuildInterface()
    auto currenttab = tabbedComponent.getTabButton(currenttabindex);
    if( auto etbb = dynamic_cast<ExtendedTabBarButton*>(currenttab) )
    {
-        auto dspoption = etbb->getOption();
-        auto params = audioProcessor.getparamsforoption(dspoption);
-        jassert(params.size() > 0);
-        dspGui.rebuildInterface(params);
+        dspGui.showPanel(etbb->getOption());
    }
 }
+void Audio_proAudioProcessorEditor::visibilityChanged()
+{
+    audioProcessor.setEditorVisible(isShowing());
+}
+void Audio_proAudioProcessorEditor::parentHierarchyChanged()
+{
+    audioProcessor.setEditorVisible(isShowing());
+}
 void Audio_proAudioProcessorEditor::timerCallback()
 {
+    //hosts minimise or hide the plugin window without telling the editor
+    audioProcessor.setEditorVisible(isShowing());
+    //the controls whose parameters moved since the last frame, each once
+    audioProcessor.guiUpdates.flush();
+    
+    if( analyzer == nullptr )
+    {
+        analyzer = std::make_unique<SpectrumOverlay>(audioProcessor);
+        //behind everything else, where it was added first before
+        addAndMakeVisible(*analyzer, 0);
+        analyzer->setBounds(analyzerBounds);
+    }
+    
     // Update meters
     dspGui.updateMeters();
+    deadlinePanel.update();
     
     if(audioProcessor.restoredDspOrderFifo.getNumAvailableForReading() ==0)
     return;
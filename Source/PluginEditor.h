@@ -11,7 +11,6 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include <LookAndFeel.h>
-#include <SpectrumAnalyzer.h>
 // Forward declaration
 struct CustomLookAndFeel;
 
@@ -40,6 +39,8 @@ struct ExtendedTabbedButtonBar : juce::TabbedButtonBar, juce::DragAndDropTarget,
 void itemDragExit (const SourceDetails& dragSourceDetails) override;
   void itemDropped(const SourceDetails& dragSourceDetails) override;
    void mouseDown(const juce::MouseEvent& e) override;
+  //the tab for an option. createTabButton only gets the tab's name, so the option waits in optionForNewTab
+  void addOptionTab(Audio_proAudioProcessor::DSP_Option option);
   juce::TabBarButton* createTabButton(const juce::String& tabName, int tabIndex) override;
 
   struct Listener
@@ -65,7 +66,7 @@ private:
     juce::Point<int> previousDraggedTabCenterPosition; 
     juce::ListenerList<Listener> listeners;
     Audio_proAudioProcessor& processor;
-    std::vector<std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment>> bypassAttachments;
+    Audio_proAudioProcessor::DSP_Option optionForNewTab = Audio_proAudioProcessor::DSP_Option::END_OF_LIST;
 };
 //need some kind of horozontal constrrainer (todo)done
 
@@ -120,32 +121,203 @@ private:
     static constexpr float MAX_DECIBELS = 6.0f;
 };
 
-struct DSP_Gui : juce::Component
+//the controls for one DSP_Option. built the first time its tab is shown, then kept and
+//just hidden, so switching tabs doesn't recreate sliders and attachments
+struct EffectPanel : juce::Component
 {
-    DSP_Gui(Audio_proAudioProcessor& p);
+    EffectPanel(Audio_proAudioProcessor& p, const std::vector< juce::RangedAudioParameter* >& params);
     
     void resized() override;
-    void paint( juce::Graphics& g ) override;
+    void visibilityChanged() override;
     
-    void rebuildInterface( std::vector< juce::RangedAudioParameter* > params );
-    void toggleSliderEnablement(bool enabled);
-    void updateMeters();
+private:
+    void addImpulseResponseButtons();
     
     Audio_proAudioProcessor& processor;
     std::vector< std::unique_ptr<RotarySliderWithLabels> > sliders;
     std::vector< std::unique_ptr<juce::ComboBox> > comboBoxes;
     std::vector< std::unique_ptr<juce::Button> > buttons;
     
-    std::vector< std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> > sliderAttachments;
-    std::vector< std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> > comboBoxAttachments;
-    std::vector< std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> > buttonAttachments;
+    std::vector< std::unique_ptr<BatchedSliderAttachment> > sliderAttachments;
+    std::vector< std::unique_ptr<BatchedComboBoxAttachment> > comboBoxAttachments;
+    std::vector< std::unique_ptr<BatchedButtonAttachment> > buttonAttachments;
     
-    std::vector< juce::RangedAudioParameter* > currentParams;
+    std::unique_ptr<juce::FileChooser> irChooser;
+    juce::Button* loadIRButton = nullptr;
+};
+
+struct DSP_Gui : juce::Component
+{
+    DSP_Gui(Audio_proAudioProcessor& p);
+    
+    void resized() override;
+    void paint( juce::Graphics& g ) override;
+    
+    void showPanel( Audio_proAudioProcessor::DSP_Option option );
+    void updateMeters();
+    
+    Audio_proAudioProcessor& processor;
+    std::array< std::unique_ptr<EffectPanel>, static_cast<size_t>(Audio_proAudioProcessor::DSP_Option::END_OF_LIST) > panels;
+    EffectPanel* currentPanel = nullptr;
+    juce::Rectangle<int> panelBounds;
     
     // Level meters
     LevelMeter leftInputMeter, rightInputMeter;
     LevelMeter leftOutputMeter, rightOutputMeter;
 };
+
+//strip under the title bar for the parameters that route the whole chain rather than one effect
+//(stereo mode, multiband, oversampling)
+struct RoutingControls : juce::Component
+{
+    RoutingControls(Audio_proAudioProcessor& p);
+    
+    void resized() override;
+    
+private:
+    Audio_proAudioProcessor& processor;
+    juce::ComboBox stereoModeComboBox, bandsComboBox, oversamplingComboBox, oversamplingFilterComboBox;
+    std::array<juce::Slider, MultibandSplitter::maxCrossovers> crossoverSliders;
+    std::array<juce::ToggleButton, MultibandSplitter::maxBands> bandButtons;
+    juce::ToggleButton renderQualityButton { "HQ Render" };
+    
+    std::unique_ptr<BatchedButtonAttachment> renderQualityAttachment;
+    std::unique_ptr<BatchedComboBoxAttachment> stereoModeAttachment, bandsAttachment,
+                                               oversamplingAttachment, oversamplingFilterAttachment;
+    std::vector< std::unique_ptr<BatchedSliderAttachment> > crossoverAttachments;
+    std::vector< std::unique_ptr<BatchedButtonAttachment> > bandAttachments;
+};
+
+//processBlock load vs. the deadline, right side of the title bar
+struct DeadlinePanel : juce::Component, juce::SettableTooltipClient
+{
+    DeadlinePanel(Audio_proAudioProcessor& p);
+    
+    void resized() override;
+    void paint(juce::Graphics& g) override;
+    void update();
+    
+private:
+    Audio_proAudioProcessor& processor;
+    DeadlineMonitor::Snapshot snapshot;
+    juce::TextButton resetButton { "Reset" }, dumpButton { "Dump..." };
+    std::unique_ptr<juce::FileChooser> dumpChooser;
+    juce::Rectangle<int> textArea;
+};
+
+//input (pre) and output (post) spectrum of the chain, or post minus pre. the two traces
+//are windowed into the real and imaginary parts of one complex fft, so the second one
+//costs its history and path, not a transform
+struct SpectrumOverlay : juce::Component, juce::Timer
+{
+    //order matches the view box
+    enum class View
+    {
+        PreAndPost,
+        Post,
+        Difference
+    };
+    
+    SpectrumOverlay(Audio_proAudioProcessor& p);
+    ~SpectrumOverlay() override;
+    
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    void timerCallback() override;
+    
+private:
+    static constexpr int minFFTOrder = 9, maxFFTOrder = 11;
+    static constexpr int maxFFTSize = 1 << maxFFTOrder;
+    static constexpr int maxNumBins = maxFFTSize / 2 + 1;
+    //room for an fft and the latency behind it: the pre window ends getLatencySamples()
+    //before the post one, so both see the same stretch of audio
+    static constexpr int historySize = 2 * maxFFTSize;
+    static constexpr float minDecibels = -90.f, maxDecibels = 0.f, differenceRange = 24.f;
+    
+    /*
+     multi resolution: level k runs at sampleRate / 2^k and shows [sampleRate / 2^(k + 3),
+     sampleRate / 2^(k + 2)), except level 0 takes everything above and the last level
+     everything below. the short fft on top keeps transients sharp, the last level gets
+     the bin width of a 16k fft at full rate. a level is only transformed once it has
+     half an fft of new samples, so the slow levels are mostly skipped and a frame costs
+     about one 2k fft. with it off, level 0 is a plain 2k fft over the whole range.
+     
+     the bins get 4x narrower from one level to the next (2x into the last), so noise
+     read per bin would step down 6 dB (3 dB) at every boundary. each level is scaled to
+     the bin width of the plain 2k fft instead, a per Hz density: broadband material runs
+     straight through the boundaries and reads the same with it on or off. a pure tone
+     reads 6 dB low on level 0, true on level 1 and 6 / 9 dB high on the last two.
+    */
+    static constexpr int numLevels = 4;
+    static constexpr std::array<int, numLevels> multiResolutionOrders { 9, 10, 11, 11 };
+    
+    //one per fft size, shared by both traces, every level of that size and every open
+    //editor in the process (SharedResources). only ever used on the message thread, so the
+    //fft's fallback engine lock is never contended
+    struct Transform
+    {
+        explicit Transform(int order);
+        
+        static std::shared_ptr<const Transform> get(int order);
+        
+        juce::dsp::FFT fft;
+        std::vector<float> window;
+    };
+    
+    //halfband lowpass in front of every 2:1 decimation, flat to a quarter of the output rate
+    static constexpr int halfbandLength = 31;
+    
+    struct Level
+    {
+        //ring of the newest historySize samples at this level's rate
+        std::array<float, historySize> history {};
+        int writeIndex = 0;
+        int numNewSamples = 0;
+        std::array<float, maxNumBins> decibels;
+        
+        //the decimator feeding this level from the one above, unused on level 0
+        std::array<float, 2 * halfbandLength> delay {};
+        int delayIndex = 0;
+        bool oddSample = false;
+    };
+    
+    struct Trace
+    {
+        std::array<Level, numLevels> levels;
+        juce::Path path;
+    };
+    
+    int pullSamples(AnalyzerTap& tap, Trace& trace, int maxSamples);
+    int decimate(Level& level, float* samples, int numSamples) const;
+    void write(Level& level, const float* samples, int numSamples);
+    void analyze();
+    void resetLevels(Trace& trace);
+    void rebuildPaths();
+    template<typename LevelGetter>
+    void buildPath(juce::Path& path, LevelGetter&& getDecibels, float lowDecibels, float highDecibels) const;
+    void updateBinPositions();
+    
+    int getNumActiveLevels() const { return multiResolution ? numLevels : 1; }
+    int getFFTOrder(int level) const { return multiResolution ? multiResolutionOrders[static_cast<size_t>(level)] : maxFFTOrder; }
+    
+    Audio_proAudioProcessor& processor;
+    std::array<std::shared_ptr<const Transform>, maxFFTOrder - minFFTOrder + 1> transforms;
+    std::array<float, halfbandLength> halfband;
+    std::array<float, maxFFTSize> workspace {};
+    std::array<juce::dsp::Complex<float>, maxFFTSize> fftInput {}, fftOutput {};
+    Trace pre, post;
+    juce::Path differencePath;
+    
+    //x of every bin of every level, negative when the bin isn't drawn
+    std::array<std::array<float, maxNumBins>, numLevels> binX {};
+    double sampleRate = 0.0;
+    juce::Rectangle<float> plotArea;
+    
+    juce::ComboBox viewBox;
+    juce::ToggleButton multiResolutionButton { "Multi-res" };
+    View view = View::PreAndPost;
+    bool multiResolution = false;
+};
 //==
 
 class Audio_proAudioProcessorEditor  : public juce::AudioProcessorEditor, 
@@ -160,6 +332,8 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
     void timerCallback() override;
+    void visibilityChanged() override;
+    void parentHierarchyChanged() override;
     virtual void tabOrderChanged( Audio_proAudioProcessor::DSP_Order newOrder ) override;
     virtual void selectedTabChanged(int newCurrentTabIndex) override;
 
@@ -167,15 +341,15 @@ private:
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     Audio_proAudioProcessor& audioProcessor;
-    std::unique_ptr<CustomLookAndFeel> customLookAndFeel;
+    //one for every open editor in the process, built with the first
+    juce::SharedResourcePointer<CustomLookAndFeel> customLookAndFeel;
     DSP_Gui dspGui{audioProcessor};
+    RoutingControls routingControls{audioProcessor};
+    DeadlinePanel deadlinePanel{audioProcessor};
    ExtendedTabbedButtonBar tabbedComponent{audioProcessor};
-     SimpleMBComp::SpectrumAnalyzer analyzer
-    {
-        audioProcessor,
-        audioProcessor.leftSCSF,
-        audioProcessor.rightSCSF
-    };
+    //built on the first timer tick, so the window shows up before the analyzer's setup is done
+    std::unique_ptr<SpectrumOverlay> analyzer;
+    juce::Rectangle<int> analyzerBounds;
    static constexpr int meterWidth = 80;
    
 
@@ -8,57 +8,20 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
-auto getPhaserRateName() {return juce::String("Phaser RateHz");}
-auto getPhaserDepthName() {return juce::String("Phaser Depth %");}
-auto getPhaserCenterFreqName() {return juce::String("Phaser Center FreqHz");}
-auto getPhaserFeedbackName() {return juce::String("Phaser Feedback %");}
-auto getPhaserMixName() {return juce::String("Phaser Mix %");}
-auto getPhaserBypassName() { return juce::String("Phaser Bypass"); }
-
-
-auto getChorusRateName() {return juce::String("Chorus RateHz");}
-auto getChorusDepthName() {return juce::String("Chorus Depth %");}
-auto getChorusCenterDelayName() {return juce::String("Chorus Center DelayMs");}
-auto getChorusFeedbackName() {return juce::String("Chorus Feedback %");}
-auto getChorusMixName() {return juce::String("Chorus Mix %");}
-auto getChorusBypassName() { return juce::String("Chorus Bypass"); }
-auto getOverdriveSaturationName() {return juce::String("Overdrive Saturation %");}
-auto getOverdriveBypassName() { return juce::String("Overdrive Bypass"); }
-
-
-auto getLadderFilterModeName() { return juce::String("Ladder Filter Mode"); }
-auto getLadderFilterCutoffName() { return juce::String("Ladder Filter Cutoff Hz"); }
-auto getLadderFilterResonanceName() { return juce::String("Ladder Filter Resonance"); }
-auto getLadderFilterDriveName() { return juce::String("Ladder Filter Drive"); }
-auto getLadderFilterBypassName() { return juce::String("Ladder Filter Bypass"); }
-auto getLadderFilterChoices()
-{
-    return juce::StringArray
-    {
-        "LPF12",  // low-pass  12 dB/octave
-        "HPF12",  // high-pass 12 dB/octave
-        "BPF12",  // band-pass 12 dB/octave
-        "LPF24",  // low-pass  24 dB/octave
-        "HPF24",  // high-pass 24 dB/octave
-        "BPF24"   // band-pass 24 dB/octave
-    };
-}
 
-auto getGeneralFilterChoices()
+//quarter notes per repeat for each Delay Sync choice, Off uses Delay Time instead
+constexpr auto getDelaySyncBeats()
 {
-    return juce::StringArray
-    {
-         "Peak",
-        "bandpass",
-        "notch",
-        "allpass",
-    };
+    return std::array { 0.0, 4.0, 2.0, 1.0, 1.5, 2.0 / 3.0, 0.5, 0.75, 1.0 / 3.0, 0.25, 1.0 / 6.0 };
 }
-auto getGeneralFilterModeName() { return juce::String("General Filter Mode"); }
-auto getGeneralFilterFreqName() { return juce::String("General Filter Freq hz"); }
-auto getGeneralFilterQualityName() { return juce::String("General Filter Quality"); }
-auto getGeneralFilterGainName() { return juce::String("General Filter Gain"); }
-auto getGeneralFilterBypassName() { return juce::String("General Filter Bypass"); }
+static_assert(getDelaySyncBeats().size() == delaySyncChoices.size());
+
+//the rest of the parameters are in EffectDescriptors.h, these are numbered
+auto getCrossoverName(int index) { return juce::String("Crossover ") + juce::String(index + 1) + " Hz"; }
+auto getBandProcessName(int index) { return juce::String("Band ") + juce::String(index + 1) + " Process"; }
+
+//apvts.state property, so the IR comes back with the session
+auto getImpulseResponsePathProperty() { return juce::Identifier("ImpulseResponsePath"); }
 
 //==============================================================================
 Audio_proAudioProcessor::Audio_proAudioProcessor()
@@ -88,98 +51,179 @@ Audio_proAudioProcessor::Audio_proAudioProcessor()
 
     restoredDspOrderFifo.push(dspOrder);
 
-    //array of pointers to the parameters
-    auto floatParams= std::array
-    {
-        &phaserRateHz,
-        &phaserDepthPercent,
-        &phaserCenterFreqHz,
-        &phaserFeedbackPercent,
-        &phaserMixPercent,
-
-        &chorusRateHz,
-        &chorusDepthPercent,
-        &chorusCenterDelayMs,
-        &chorusFeedbackPercent,
-        &chorusMixPercent,
-
-        &overdriveSaturationPercent,
-
-        &ladderFilterCutoffHz,
-        &ladderFilterResonance,
-        &ladderFilterDrive,
-        &generalFilterFreqHz,
-        &generalFilterQuality,
-        &generalFilterGaindB
-        
+    //the named members the rest of the code reads, one per float in parameterSpecs and in
+    //the same order. the names are only here so a slip doesn't compile
+    struct FloatParamMember
+    {
+        juce::AudioParameterFloat* Audio_proAudioProcessor::* member;
+        const char* name;
     };
 
-    auto floatnameFuncs= std::array
-    {
-        &getPhaserRateName,
-        &getPhaserDepthName,
-        &getPhaserCenterFreqName,
-        &getPhaserFeedbackName,
-        &getPhaserMixName,
-        &getChorusRateName,
-        &getChorusDepthName,
-        &getChorusCenterDelayName,
-        &getChorusFeedbackName,
-        &getChorusMixName,
-
-        &getOverdriveSaturationName,
-
-        &getLadderFilterCutoffName,
-        &getLadderFilterResonanceName,
-        &getLadderFilterDriveName,
-        &getGeneralFilterFreqName,
-        &getGeneralFilterQualityName,
-        &getGeneralFilterGainName
+    static constexpr std::array floatParamMembers
+    {
+        FloatParamMember { &Audio_proAudioProcessor::phaserRateHz, getPhaserRateName() },
+        FloatParamMember { &Audio_proAudioProcessor::phaserDepthPercent, getPhaserDepthName() },
+        FloatParamMember { &Audio_proAudioProcessor::phaserCenterFreqHz, getPhaserCenterFreqName() },
+        FloatParamMember { &Audio_proAudioProcessor::phaserFeedbackPercent, getPhaserFeedbackName() },
+        FloatParamMember { &Audio_proAudioProcessor::phaserMixPercent, getPhaserMixName() },
+        FloatParamMember { &Audio_proAudioProcessor::chorusRateHz, getChorusRateName() },
+        FloatParamMember { &Audio_proAudioProcessor::chorusDepthPercent, getChorusDepthName() },
+        FloatParamMember { &Audio_proAudioProcessor::chorusCenterDelayMs, getChorusCenterDelayName() },
+        FloatParamMember { &Audio_proAudioProcessor::chorusFeedbackPercent, getChorusFeedbackName() },
+        FloatParamMember { &Audio_proAudioProcessor::chorusMixPercent, getChorusMixName() },
+        FloatParamMember { &Audio_proAudioProcessor::overdriveSaturationPercent, getOverdriveSaturationName() },
+        FloatParamMember { &Audio_proAudioProcessor::ladderFilterCutoffHz, getLadderFilterCutoffName() },
+        FloatParamMember { &Audio_proAudioProcessor::ladderFilterResonance, getLadderFilterResonanceName() },
+        FloatParamMember { &Audio_proAudioProcessor::ladderFilterDrive, getLadderFilterDriveName() },
+        FloatParamMember { &Audio_proAudioProcessor::generalFilterFreqHz, getGeneralFilterFreqName() },
+        FloatParamMember { &Audio_proAudioProcessor::generalFilterQuality, getGeneralFilterQualityName() },
+        FloatParamMember { &Audio_proAudioProcessor::generalFilterGaindB, getGeneralFilterGainName() },
+        FloatParamMember { &Audio_proAudioProcessor::limiterCeilingdB, getLimiterCeilingName() },
+        FloatParamMember { &Audio_proAudioProcessor::limiterReleaseMs, getLimiterReleaseName() },
+        FloatParamMember { &Audio_proAudioProcessor::limiterLookaheadMs, getLimiterLookaheadName() },
+        FloatParamMember { &Audio_proAudioProcessor::convolutionMixPercent, getConvolutionMixName() },
+        FloatParamMember { &Audio_proAudioProcessor::convolutionGaindB, getConvolutionGainName() },
+        FloatParamMember { &Audio_proAudioProcessor::delayTimeMs, getDelayTimeName() },
+        FloatParamMember { &Audio_proAudioProcessor::delayFeedbackPercent, getDelayFeedbackName() },
+        FloatParamMember { &Audio_proAudioProcessor::delayLowCutHz, getDelayLowCutName() },
+        FloatParamMember { &Audio_proAudioProcessor::delayHighCutHz, getDelayHighCutName() },
+        FloatParamMember { &Audio_proAudioProcessor::delayMixPercent, getDelayMixName() },
+        FloatParamMember { &Audio_proAudioProcessor::envelopeDepthOctaves, getEnvelopeDepthName() },
+        FloatParamMember { &Audio_proAudioProcessor::envelopeAttackMs, getEnvelopeAttackName() },
+        FloatParamMember { &Audio_proAudioProcessor::envelopeReleaseMs, getEnvelopeReleaseName() },
     };
-    //connects each parameter to its name function for the apvts for float params
-    initCachedParams<juce::AudioParameterFloat*>(floatParams, floatnameFuncs);
+
+    static_assert([]
+    {
+        size_t next = 0;
+        for( const auto& spec : parameterSpecs )
+            if( spec.kind == ParameterKind::Float
+                && (next == floatParamMembers.size() || std::string_view(spec.name) != floatParamMembers[next++].name) )
+                return false;
+
+        return next == floatParamMembers.size();
+    }(), "floatParamMembers has to follow the floats in parameterSpecs");
+
+    //the crossovers are the last lanes
+    static_assert(static_cast<size_t>(SmoothedParam::Crossover1) + MultibandSplitter::maxCrossovers == numSmoothedParams,
+                  "Crossover1..3 have to be the last SmoothedParam lanes");
+
+    //5 ms linear unless the spec says otherwise. frequencies ramp in octaves and can take
+    //a bit longer without sounding sluggish at the top
+    auto setUpLane = [this](size_t lane, juce::AudioParameterFloat* param, SmoothingCurve curve)
+    {
+        smoothedParams[lane] = param;
+        smoothers.setCurve(lane, curve);
+        if( curve == SmoothingCurve::Multiplicative )
+            smoothers.setRampTime(lane, 0.02);
+    };
+
+    size_t nextMember = 0;
+    for( const auto& spec : parameterSpecs )
+    {
+        if( spec.kind != ParameterKind::Float )
+            continue;
+
+        //the IDs are literals, so this lookup doesn't allocate. the type is fixed by
+        //createParameterLayout(), so the dynamic_cast is only there to check it in debug builds
+        auto* param = apvts.getParameter(spec.name);
+        jassert(dynamic_cast<juce::AudioParameterFloat*>(param) != nullptr);
+        auto* cached = static_cast<juce::AudioParameterFloat*>(param);
+        this->*floatParamMembers[nextMember++].member = cached;
+
+        if( spec.lane != SmoothedParam::END_OF_LIST )
+            setUpLane(static_cast<size_t>(spec.lane), cached, spec.curve);
+    }
+
+    //the multiband parameters are numbered, so they're looked up by index
+    for( size_t i = 0; i < crossoverFreqHz.size(); ++i )
+    {
+        crossoverFreqHz[i] = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter(getCrossoverName(static_cast<int>(i))));
+        jassert(crossoverFreqHz[i] != nullptr);
+        setUpLane(static_cast<size_t>(crossoverSpec.lane) + i, crossoverFreqHz[i], crossoverSpec.curve);
+    }
+
+    for( size_t i = 0; i < bandProcess.size(); ++i )
+    {
+        bandProcess[i] = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter(getBandProcessName(static_cast<int>(i))));
+        jassert(bandProcess[i] != nullptr);
+    }
+
+    //every float parameter createParameterLayout() makes is either in the specs or a crossover
+    jassert(std::count_if(getParameters().begin(), getParameters().end(),
+                          [](auto* param) { return dynamic_cast<juce::AudioParameterFloat*>(param) != nullptr; })
+            == static_cast<std::ptrdiff_t>(floatParamMembers.size() + crossoverFreqHz.size()));
+
+    //a fresh bank holds 0 everywhere, which the log lanes can't take
+    updateSmoothersFromParams(0, SmootherUpdateMode::initialize);
 
     //now for choice params 
        auto choiceParams = std::array
     {
         &ladderFilterMode,
         &generalFilterMode,
+        &saturationQuality,
+        &multibandBands,
+        &stereoMode,
+        &envelopeTarget,
+        &oversamplingFactor,
+        &oversamplingFilter,
+        &delaySync,
     };
     
     auto choiceNameFuncs = std::array
     {
         &getLadderFilterModeName,
         &getGeneralFilterModeName,
+        &getSaturationQualityName,
+        &getMultibandBandsName,
+        &getStereoModeName,
+        &getEnvelopeTargetName,
+        &getOversamplingName,
+        &getOversamplingFilterName,
+        &getDelaySyncName,
     };
     
     initCachedParams<juce::AudioParameterChoice*>(choiceParams, choiceNameFuncs);
 
+    auto renderParams = std::array { &renderQuality };
+    auto renderNameFuncs = std::array { &getRenderQualityName };
+    initCachedParams<juce::AudioParameterBool*>(renderParams, renderNameFuncs);
 
-        auto bypassParams = std::array
-    {
-        &phaserBypass,
-        &chorusBypass,
-        &overdriveBypass,
-        &ladderFilterBypass,
-        &generalFilterBypass,
-    };
-    
-    auto bypassNameFuncs = std::array
+
+    //every effect's page, straight from the table. the bypass is the page's last entry
+    for( size_t i = 0; i < numDSPOptions; ++i )
     {
-        &getPhaserBypassName,
-        &getChorusBypassName,
-        &getOverdriveBypassName,
-        &getLadderFilterBypassName,
-        &getGeneralFilterBypassName,
-    };
+        const auto& descriptor = effectDescriptors[i];
+        auto& params = optionParams[i];
+        params.reserve(descriptor.numParams);
+
+        for( size_t j = 0; j < descriptor.numParams; ++j )
+        {
+            auto* param = apvts.getParameter(descriptor.paramNames[j]);
+            jassert(param != nullptr); // a name in the table that createParameterLayout() doesn't make
+            params.push_back(param);
+        }
+
+        jassert(dynamic_cast<juce::AudioParameterBool*>(params.back()) != nullptr);
+        optionBypasses[i] = static_cast<juce::AudioParameterBool*>(params.back());
+    }
 
-    initCachedParams<juce::AudioParameterBool*>(bypassParams, bypassNameFuncs);
+    for( auto& set : chainSets )
+        for( auto& chain : set )
+            chain.emplace(*this);
+
+    //polls reprepareRequested. without a message loop (the render tool) it never fires,
+    //and nothing needs it to: there every setting is in place before prepareToPlay
+    startTimerHz(10);
 }
   
   
 
 Audio_proAudioProcessor::~Audio_proAudioProcessor()
 {
+    //the batch renderer destroys instances on its worker threads
+    stopTimer();
 }
 
 //==============================================================================
@@ -249,177 +293,247 @@ void Audio_proAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBl
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
+    juce::ignoreUnused(samplesPerBlock);
+
+    activeOversamplingIndex = oversamplingFactor->getIndex();
+    activeOversamplingFilterIndex = oversamplingFilter->getIndex();
+    renderQualityActive = wantsRenderQuality();
+    reprepareRequested = false;
+    preloadedChainRate = 0.0;
+    preloadedEngines = 0;
+    renderUpdateCountdown = 0;
+    controlBlockPosition = 0;
+    controlBlockEnergy = 0.0;
+    preparedBands = getWantedPreparedBands();
+    numConvolutionEngines = 4 * preparedBands;
+
+    //an offline render gets at least renderOversamplingExponent and per sample control updates
+    auto exponent = getWantedOversamplingExponent();
+    subBlockSize = renderQualityActive ? renderSubBlockSize : maxSubBlockSize;
+
+    oversampler.prepare(exponent, static_cast<OversamplingFilter>(activeOversamplingFilterIndex), maxSubBlockSize);
+    chainSampleRate = sampleRate * oversampler.getFactor();
+
+    //the chains only ever see one sub block at a time
     juce::dsp::ProcessSpec spec;
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = samplesPerBlock;
+    spec.sampleRate = chainSampleRate;
+    spec.maximumBlockSize = static_cast<juce::uint32>(maxSubBlockSize * oversampler.getFactor());
     spec.numChannels = 1;
-    leftChannel.prepare(spec);
-    rightChannel.prepare(spec);
-        for( auto smoother : getSmoothers() )
+    //the limiters always delay by the longest lookahead, in whole host samples
+    auto limiterSpec = spec;
+    limiterSpec.numChannels = 2;
+    const auto limiterDelay = static_cast<int>(std::ceil(LookaheadLimiter<float>::maxLookaheadMs * 0.001 * sampleRate)) * oversampler.getFactor();
+    for( auto& limiter : limiters )
+        limiter.setDelaySamples(limiterDelay);
+
+    //the delay lines run at the host rate. only the live chains of the prepared bands hold
+    //the whole maxDelaySeconds, a shadow only writes for the length of a fade before it
+    //takes the live ring over, see advanceOrderFade()
+    for( size_t set = 0; set < chainSets.size(); ++set )
+        for( size_t chain = 0; chain < chainSets[set].size(); ++chain )
+        {
+            auto& delay = chainSets[set][chain]->delay.dsp;
+            const auto playing = set == liveChainSet && chain < static_cast<size_t>(2 * preparedBands);
+            delay.setDecimation(oversampler.getFactor());
+            delay.setRingSeconds(playing ? TempoDelay<float>::maxDelaySeconds : orderFadeSeconds);
+        }
+
+    //every chain's buffers in one block, in processing order
+    dspArena.build([this, &spec, &limiterSpec](DSPArena& arena) { layoutChainArena(arena, spec, limiterSpec); });
+    forEveryChainDSP([&spec](MonoChannelDSP& dsp) { dsp.prepare(spec); });
+    for( auto& limiter : limiters )
+        limiter.prepare(limiterSpec);
+
+    orderFadeLength = juce::jmax(1, juce::roundToInt(orderFadeSeconds * chainSampleRate));
+    orderFadeGains.resize(static_cast<size_t>(orderFadeLength + 1));
+    for( size_t i = 0; i < orderFadeGains.size(); ++i )
+        orderFadeGains[i] = std::sin(juce::MathConstants<float>::halfPi * static_cast<float>(i) / static_cast<float>(orderFadeLength));
+
+    //a fade in flight just lands, every chain has been cleared anyway
+    if( isOrderFading() )
+        dspOrder = fadeOrder;
+    if( hasPendingOrder )
+        dspOrder = pendingOrder;
+    hasPendingOrder = false;
+    orderFadePosition = -1;
+
+    deadlineMonitor.prepare(sampleRate);
+    envelopeFollower.prepare(sampleRate);
+
+    //stereo, like the limiters
+    splitter.prepare(limiterSpec);
+    numBands = 1;
+    splitter.setNumBands(numBands);
+    updateMultiband();
+
+    //force updateGeneralFilterCoefficients() to design for the new sample rate
+    generalFilterCoefficientsMode = GeneralFilterMode::END_OF_LIST;
+    filterFreq = 0.f;
+
+    limiterLookaheadSamples = -1;
+    updateLimiterLookahead();
+    setLatencySamples(limiterDelay / oversampler.getFactor() + oversampler.getLatencySamples());
+
+    //a package built for this rate and engine count survives the re-prepare. otherwise it
+    //goes (the audio thread is stopped, so straight away) and one the timer had built ahead
+    //takes over, or a new load starts and the stages pass through until it lands
+    auto* package = impulseResponseLoader.getActivePackage();
+    if( package == nullptr || ! package->matches(chainSampleRate, numConvolutionEngines) )
     {
-        smoother->reset(sampleRate, 0.005);
+        impulseResponseLoader.releaseActivePackage();
+        if( ! impulseResponseLoader.takePendingPackage(chainSampleRate, numConvolutionEngines)
+            && getImpulseResponseFile() != juce::File() )
+            impulseResponseLoader.requestLoad(getImpulseResponseFile(), chainSampleRate, numConvolutionEngines);
     }
-    
-    updateSmoothersFromParams(1, SmootherUpdateMode::initialize);
-  leftSCSF.prepare(samplesPerBlock);
-    rightSCSF.prepare(samplesPerBlock);
+    assignConvolutionEngines();
+    //prepare() snaps every lane to its target, so the targets go in first
+    updateSmoothersFromParams(0, SmootherUpdateMode::initialize);
+    smoothers.prepare(chainSampleRate);
+    updateCrossovers();
+}
+
+bool Audio_proAudioProcessor::wantsRenderQuality() const noexcept
+{
+    return isNonRealtime() && renderQuality->get();
+}
+
+bool Audio_proAudioProcessor::chainConfigChanged() const noexcept
+{
+    return oversamplingFactor->getIndex() != activeOversamplingIndex
+        || oversamplingFilter->getIndex() != activeOversamplingFilterIndex
+        || multibandBands->getIndex() + 1 > preparedBands;
 }
+
+int Audio_proAudioProcessor::getWantedPreparedBands() const noexcept
+{
+    if( isNonRealtime() )
+        return MultibandSplitter::maxBands;
+
+    return juce::jmax(preparedBands, multibandBands->getIndex() + 1);
+}
+
+int Audio_proAudioProcessor::getWantedOversamplingExponent() const noexcept
+{
+    auto exponent = oversamplingFactor->getIndex();
+    if( wantsRenderQuality() )
+        exponent = juce::jmax(exponent, renderOversamplingExponent);
+
+    return exponent;
+}
+
+void Audio_proAudioProcessor::timerCallback()
+{
+    if( ! reprepareRequested.load() )
+        return;
+
+    //not prepared yet, prepareToPlay will read the parameters itself. and a re-prepare
+    //clears every delay line, so it only happens when something really changed
+    if( getSampleRate() <= 0.0 || ! chainConfigChanged() )
+    {
+        reprepareRequested = false;
+        preloadedChainRate = 0.0;
+        preloadedEngines = 0;
+        return;
+    }
+
+    //a loaded IR has to be rebuilt for a new chain rate or more bands. that happens first,
+    //while the old chain keeps playing with the old package, so the reverb is there right
+    //after the switch
+    const auto nextChainRate = getSampleRate() * (1 << getWantedOversamplingExponent());
+    const auto nextEngines = 4 * getWantedPreparedBands();
+    const auto file = getImpulseResponseFile();
+    if( file != juce::File() && (nextChainRate != chainSampleRate || nextEngines != numConvolutionEngines) )
+    {
+        if( preloadedChainRate != nextChainRate || preloadedEngines != nextEngines )
+        {
+            impulseResponseLoader.requestLoad(file, nextChainRate, nextEngines);
+            preloadedChainRate = nextChainRate;
+            preloadedEngines = nextEngines;
+            return;
+        }
+
+        if( impulseResponseLoader.isLoading() )
+            return;
+    }
+
+    //suspendProcessing() takes the callback lock, so processBlock isn't running while
+    //the chain is rebuilt at the new rate
+    suspendProcessing(true);
+    prepareToPlay(getSampleRate(), getBlockSize());
+    suspendProcessing(false);
+}
+
 void Audio_proAudioProcessor::updateSmoothersFromParams(int numSamplesToSkip, SmootherUpdateMode init)
 {   
-    //refernce?? doubt
-    auto paramsNeedingSmoothing = std::vector
-    {
-        phaserRateHz,
-        phaserDepthPercent,
-        phaserCenterFreqHz, 
-        phaserFeedbackPercent,
-        phaserMixPercent,
-        chorusRateHz,
-        chorusDepthPercent,
-        chorusCenterDelayMs,
-        chorusFeedbackPercent,
-        chorusMixPercent,
-        overdriveSaturationPercent,
-        ladderFilterCutoffHz,
-        ladderFilterResonance,
-        ladderFilterDrive,
-        generalFilterFreqHz,
-        generalFilterQuality,
-        generalFilterGaindB,
-  
-    };
-    
-    auto smoothers = getSmoothers();
-    jassert( smoothers.size() == paramsNeedingSmoothing.size() );
-    
-    for( size_t i = 0; i < smoothers.size(); ++i )
+    //runs every sub block, so nothing in here allocates
+    for( size_t i = 0; i < smoothedParams.size(); ++i )
     {
-        auto smoother = smoothers[i];
-        auto param = paramsNeedingSmoothing[i];
+        auto value = smoothedParams[i]->get();
         
         if( init == SmootherUpdateMode::initialize )
-            smoother->setCurrentAndTargetValue( param->get() );
+            smoothers.setCurrentAndTargetValue(i, value);
         else
-            smoother->setTargetValue(param->get());
-        
-        smoother->skip(numSamplesToSkip);
+            smoothers.setTargetValue(i, value);
     }
     
-    
+    smoothers.skip(numSamplesToSkip);
+}
+
+const std::vector<juce::RangedAudioParameter*>& Audio_proAudioProcessor::getparamsforoption(DSP_Option option) const noexcept
+{
+    jassert(option != DSP_Option::END_OF_LIST);
+    return optionParams[juce::jmin(static_cast<size_t>(option), numDSPOptions - 1)];
+}
+
+juce::AudioParameterBool* Audio_proAudioProcessor::getBypassParameter(DSP_Option option) const noexcept
+{
+    jassert(option != DSP_Option::END_OF_LIST);
+    return optionBypasses[juce::jmin(static_cast<size_t>(option), numDSPOptions - 1)];
 }
 
-std::vector<juce::RangedAudioParameter *> Audio_proAudioProcessor::getparamsforoption(DSP_Option option)
+void Audio_proAudioProcessor::MonoChannelDSP::layoutArena(DSPArena& arena, const juce::dsp::ProcessSpec& spec, const DSP_Order& order)
 {
-     // creating a function that returns a vector of audio parameters for a given DSP option
-     // This allows the GUI to know which parameters to display for each DSP effect
-     // The function takes a DSP_Option enum and returns all the relevant parameters for that effect
-     // This is used by the DSP_Gui to rebuild its interface when switching between different DSP effects
-     switch( option )
+    //phaser and chorus are juce's and keep their own buffers, the limiter is the processor's.
+    //a later order change doesn't move anything, it only costs some locality. anything the
+    //order doesn't have (it should have every option once) goes at the end, in DSP_Option order
+    std::array<bool, numDSPOptions> laidOut {};
+    std::array<DSP_Option, 2 * numDSPOptions> options {};
+    std::copy(order.begin(), order.end(), options.begin());
+    for( size_t i = 0; i < numDSPOptions; ++i )
+        options[numDSPOptions + i] = static_cast<DSP_Option>(i);
+
+    for( auto option : options )
     {
-        case DSP_Option::Phase:
-        {
-            return
-            {
-                phaserRateHz,
-                phaserCenterFreqHz,
-                phaserDepthPercent,
-                phaserFeedbackPercent,
-                phaserMixPercent,
-                phaserBypass,
-            };
-        }
-        case DSP_Option::Chorus:
-        {
-            return
-            {
-                chorusRateHz,
-                chorusDepthPercent,
-                chorusCenterDelayMs,
-                chorusFeedbackPercent,
-                chorusMixPercent,
-                chorusBypass,
-            };
-        }
-        case DSP_Option::Overdrive:
-        {
-            return
-            {
-                overdriveSaturationPercent,
-                overdriveBypass,
-            };
-        }
-        case DSP_Option::LadderFilter:
-        {
-            return
-            {
-                ladderFilterMode,
-                ladderFilterCutoffHz,
-                ladderFilterResonance,
-                ladderFilterDrive,
-                ladderFilterBypass,
-            };
-        }
-        case DSP_Option::GeneralFilter:
+        const auto index = static_cast<size_t>(option);
+        if( index >= numDSPOptions || laidOut[index] )
+            continue;
+
+        laidOut[index] = true;
+        switch( option )
         {
-            return
-            {
-                generalFilterMode,
-                generalFilterFreqHz,
-                generalFilterQuality,
-                generalFilterGaindB,
-                generalFilterBypass,
-            };
+            case DSP_Option::Overdrive:     overdrive.dsp.layoutArena(arena, spec); break;
+            case DSP_Option::LadderFilter:  ladderFilter.dsp.layoutArena(arena, spec); break;
+            case DSP_Option::GeneralFilter: generalFilter.dsp.layoutArena(arena, spec); break;
+            case DSP_Option::Convolution:   convolution.dsp.layoutArena(arena, spec); break;
+            case DSP_Option::Delay:         delay.dsp.layoutArena(arena, spec); break;
+            case DSP_Option::Phase:
+            case DSP_Option::Chorus:
+            case DSP_Option::Limiter:
+            case DSP_Option::END_OF_LIST:
+                break;
         }
-        case DSP_Option::END_OF_LIST:
-            break;
     }
-    
-    jassertfalse;
-    return { }; 
-}
-
-std::vector<juce::SmoothedValue<float> *> Audio_proAudioProcessor::getSmoothers()
-{
-    auto smoothers = std::vector
-    {
-        //alwasy change do depht is befroe centerfreq in phaser also
-        &phaserRateHzSmoother,
-         &phaserDepthPercentSmoother,
-        &phaserCenterFreqHzSmoother,
-        &phaserFeedbackPercentSmoother,
-        &phaserMixPercentSmoother,
-        &chorusRateHzSmoother,
-        &chorusDepthPercentSmoother,
-        &chorusCenterDelayMsSmoother,
-        &chorusFeedbackPercentSmoother,
-        &chorusMixPercentSmoother,
-        &overdriveSaturationSmoother,
-        &ladderFilterCutoffHzSmoother,
-        &ladderFilterResonanceSmoother,
-        &ladderFilterDriveSmoother,
-        &generalFilterFreqHzSmoother,
-        &generalFilterQualitySmoother,
-        &generalFilterGainSmoother,
-  
-    };
-    
-    return smoothers;
 }
 
 void Audio_proAudioProcessor::MonoChannelDSP::prepare(const juce::dsp::ProcessSpec &spec)
 {
     jassert(spec.numChannels == 1);
-    std::vector<juce::dsp::ProcessorBase*> dsp
-    {
-        &phaser,
-        &chorus,
-        &overdrive,
-        &ladderFilter,
-        &generalFilter
-    };
-    
-    for( auto p : dsp )
+    filterMode = GeneralFilterMode::END_OF_LIST;
+    coefficientsVersion = -1;
+    for( auto p : getProcessors() )
     {
+        if( p == nullptr )
+            continue;
 
         p->prepare(spec);
         p->reset();
@@ -429,6 +543,14 @@ void Audio_proAudioProcessor::MonoChannelDSP::prepare(const juce::dsp::ProcessSp
     overdrive.dsp.setCutoffFrequencyHz(20000.f);
 }
 
+void Audio_proAudioProcessor::MonoChannelDSP::reset()
+{
+    //runs on the audio thread when a band or the shadow chain comes in, so nothing here allocates
+    for( auto p : getProcessors() )
+        if( p != nullptr )
+            p->reset();
+}
+
 
 
 
@@ -469,149 +591,42 @@ Audio_proAudioProcessor::createParameterLayout()
 {
     juce::AudioProcessorValueTreeState::ParameterLayout layout;
     const int versionhint = 1;
-    //PHASERRATEHZ
-    auto name = getPhaserRateName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{name, versionhint},
-    name, juce::NormalisableRange<float>(0.01f, 2.f, 0.01f,1.f), 0.2f,"Hz"));
-    
-    //PHASERDEPTH 0 TO 1
-    name = getPhaserDepthName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{name, versionhint},
-    name, juce::NormalisableRange<float>(0.01f, 1.f, 0.01f,1.f), 0.05f,"%"));
-    
-    //PHASERCENTERFREQ 0 TO 1
-    name = getPhaserCenterFreqName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{name, versionhint},
-    name, juce::NormalisableRange<float>(20.f, 20000.f, 1.f,1.f), 1000.f,"Hz"));
-
-    //PHASERFEEDBACK -1 TO 1
-    name = getPhaserFeedbackName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{name, versionhint},
-    name, juce::NormalisableRange<float>(-1.f, 1.f, 0.01f,1.f), 0.0f,"%"));
-
-    //PHASERMIX 0 TO 1
-    name = getPhaserMixName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{name, versionhint},
-    name, juce::NormalisableRange<float>(0.01f, 1.f, 0.01f,1.f), 0.05f,"%"));
-
-    //PHASERBYPASS
-    name = getPhaserBypassName();
-    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name, versionhint}, name, false));
-
-    //CHORUSRATEHZ
-    name = getChorusRateName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{name, versionhint},
-    name, juce::NormalisableRange<float>(0.01f, 100.f, 0.01f,1.f), 0.2f,"Hz"));
-
-    //CHORUSDEPTH 0 TO 1
-    name = getChorusDepthName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{name, versionhint},
-    name, juce::NormalisableRange<float>(0.01f, 1.f, 0.01f,1.f), 0.05f,"%"));
-    
-    //CHORUSCENTERDELAYMS
-    name = getChorusCenterDelayName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{name, versionhint},
-    name, juce::NormalisableRange<float>(0.01f, 100.f, 0.01f,1.f), 7.5f,"ms"));
-    
-    //CHORUSFEEDBACK -1 TO 1
-    name = getChorusFeedbackName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{name, versionhint},
-    name, juce::NormalisableRange<float>(-1.f, 1.f, 0.01f,1.f), 0.0f,"%"));
-
-    //CHORUSMIX 0 TO 1
-    name = getChorusMixName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{name, versionhint},
-    name, juce::NormalisableRange<float>(0.01f, 1.f, 0.01f,1.f), 0.05f,"%"));
 
-    //CHORUSBYPASS
-    name = getChorusBypassName();
-    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name, versionhint}, name, false));
-
-    //OVERDRIVESATURATION 0 TO 1
-    name = getOverdriveSaturationName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{name, versionhint},
-    name, juce::NormalisableRange<float>(1.f, 100.f, 0.1f,1.f), 1.f,"%"));
+    auto addFloat = [&](const juce::String& name, const ParameterSpec& spec, float defaultValue)
+    {
+        const auto& range = spec.range;
+        layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{name, versionhint}, name,
+            juce::NormalisableRange<float>(range.start, range.end, range.interval, range.skew), defaultValue, spec.unit));
+    };
 
-    //OVERDRIVEBYPASS
-    name = getOverdriveBypassName();
-    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name, versionhint}, name, false));
+    //everything is in parameterSpecs, in the order hosts see it
+    for( const auto& spec : parameterSpecs )
+    {
+        const juce::String name = spec.name;
+        switch( spec.kind )
+        {
+            case ParameterKind::Float:
+                addFloat(name, spec, spec.defaultValue);
+                break;
+            case ParameterKind::Choice:
+                layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{name, versionhint}, name,
+                    juce::StringArray(spec.choices, spec.numChoices), static_cast<int>(spec.defaultValue)));
+                break;
+            case ParameterKind::Bool:
+                layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name, versionhint}, name, spec.defaultValue != 0.f));
+                break;
+        }
+    }
 
-    /*
-    //LADDERFILTERMODE
-    mode: ladder filter mode
-    cutoff: ladder filter cutoff hz
-    resonance: ladder filter resonance
-    drive: ladder filter drive
-    mode: ladder filter mode
-    cutoff: ladder filter cutoff hz
-    resonance: ladder filter resonance
-    drive: ladder filter drive
-    
-    */
+    static_assert(crossoverDefaults.size() == MultibandSplitter::maxCrossovers);
+    for( int i = 0; i < MultibandSplitter::maxCrossovers; ++i )
+        addFloat(getCrossoverName(i), crossoverSpec, crossoverDefaults[static_cast<size_t>(i)]);
 
-   name = getLadderFilterModeName();
-    auto choices = getLadderFilterChoices();
-    layout.add(std::make_unique<juce::AudioParameterChoice>(
-        juce::ParameterID{name, versionhint}, name, choices, 0));
-    
-    name = getLadderFilterCutoffName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-       juce::ParameterID{name, versionhint},
-       name,
-       juce::NormalisableRange<float>(20.f, 20000.f, 0.1f, 1.f),
-       20000.f,
-       "Hz"));
-    
-    name = getLadderFilterResonanceName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-       juce::ParameterID{name, versionhint},
-       name,
-       juce::NormalisableRange<float>(0.f, 100.f, 0.1f, 1.f),
-       0.f,
-       "%"));
-    
-    name = getLadderFilterDriveName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-       juce::ParameterID{name, versionhint},
-       name,
-       juce::NormalisableRange<float>(1.f, 100.f, 0.1f, 1.f),
-       1.f,
-       ""));
-    name = getLadderFilterBypassName();
-    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name, versionhint}, name, false));
-
-    name = getGeneralFilterModeName();
-    choices = getGeneralFilterChoices();
-    layout.add(std::make_unique<juce::AudioParameterChoice>(
-        juce::ParameterID{name, versionhint}, name, choices, 0));
-
-    name = getGeneralFilterFreqName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{name, versionhint},
-        name,
-        juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 1.f),
-        750.f,
-        "Hz"));
-//GENERALFILTERQUALITY 0.1 TO 10
-    name = getGeneralFilterQualityName();
-    
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{name, versionhint},
-        name,
-        juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f),
-        1.f,
-        ""));
-    //GENERALFILTERGAIN -24dB TO 24dB
-    name = getGeneralFilterGainName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{name, versionhint},
-        name,
-        juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f),
-        0.f,
-        "dB"));
-          
-       name = getGeneralFilterBypassName();
-    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name, versionhint}, name, false));
+    for( int i = 0; i < MultibandSplitter::maxBands; ++i )
+    {
+        auto name = getBandProcessName(i);
+        layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name, versionhint}, name, bandProcessSpec.defaultValue != 0.f));
+    }
 
     return layout;
 }
@@ -619,109 +634,549 @@ Audio_proAudioProcessor::createParameterLayout()
 void Audio_proAudioProcessor::MonoChannelDSP::updateDSPFromParams()
 {
        //might have to see the layout to confirm that the rnages of all paramters are correct
-    phaser.dsp.setRate(p.phaserRateHzSmoother.getCurrentValue());
-    phaser.dsp.setDepth(p.phaserDepthPercentSmoother.getCurrentValue());
-    phaser.dsp.setCentreFrequency(p.phaserCenterFreqHzSmoother.getCurrentValue());
-    phaser.dsp.setFeedback(p.phaserFeedbackPercentSmoother.getCurrentValue());
-    phaser.dsp.setMix(p.phaserMixPercentSmoother.getCurrentValue());
-
-    chorus.dsp.setRate(p.chorusRateHzSmoother.getCurrentValue());
-    chorus.dsp.setDepth(p.chorusDepthPercentSmoother.getCurrentValue());
-    chorus.dsp.setCentreDelay(p.chorusCenterDelayMsSmoother.getCurrentValue());
-    chorus.dsp.setFeedback(p.chorusFeedbackPercentSmoother.getCurrentValue());
-    chorus.dsp.setMix(p.chorusMixPercentSmoother.getCurrentValue());
-
-    overdrive.dsp.setDrive(p.overdriveSaturationSmoother.getCurrentValue());
+    phaser.dsp.setRate(p.getSmoothedValue(SmoothedParam::PhaserRate));
+    phaser.dsp.setDepth(p.getSmoothedValue(SmoothedParam::PhaserDepth));
+    phaser.dsp.setCentreFrequency(p.getSmoothedValue(SmoothedParam::PhaserCenterFreq));
+    phaser.dsp.setFeedback(p.getSmoothedValue(SmoothedParam::PhaserFeedback));
+    phaser.dsp.setMix(p.getSmoothedValue(SmoothedParam::PhaserMix));
+
+    chorus.dsp.setRate(p.getSmoothedValue(SmoothedParam::ChorusRate));
+    chorus.dsp.setDepth(p.getSmoothedValue(SmoothedParam::ChorusDepth));
+    chorus.dsp.setCentreDelay(p.getSmoothedValue(SmoothedParam::ChorusCenterDelay));
+    chorus.dsp.setFeedback(p.getSmoothedValue(SmoothedParam::ChorusFeedback));
+    chorus.dsp.setMix(p.getSmoothedValue(SmoothedParam::ChorusMix));
+
+    auto quality = p.renderQualityActive ? SaturationQuality::Precise
+                                         : static_cast<SaturationQuality>(p.saturationQuality->getIndex());
+    overdrive.dsp.setSaturationQuality(quality);
+    ladderFilter.dsp.setSaturationQuality(quality);
+
+    overdrive.dsp.setDrive(p.getSmoothedValue(SmoothedParam::OverdriveSaturation));
     
     ladderFilter.dsp.setMode(
     static_cast<juce::dsp::LadderFilterMode>(p.ladderFilterMode->getIndex()));
-    ladderFilter.dsp.setCutoffFrequencyHz(p.ladderFilterCutoffHzSmoother.getCurrentValue());
-    ladderFilter.dsp.setResonance(p.ladderFilterResonanceSmoother.getCurrentValue());
-    ladderFilter.dsp.setDrive(p.ladderFilterDriveSmoother.getCurrentValue());
+    //the envelope moves the cutoff once per sub block, already smoothed by its attack and
+    //release. the filter only ramps across the sub block then, so it follows the envelope
+    const auto envelopeDrivesCutoff = p.activeEnvelopeTarget == EnvelopeTarget::LadderCutoff && p.getSampleRate() > 0.0;
+    ladderFilter.dsp.setCutoffRampSeconds(envelopeDrivesCutoff ? static_cast<float>(p.subBlockSize / p.getSampleRate())
+                                                               : FastLadderFilter<float>::defaultCutoffRampSeconds);
+    ladderFilter.dsp.setCutoffFrequencyHz(p.getModulatedFrequency(EnvelopeTarget::LadderCutoff,
+                                                                  p.getSmoothedValue(SmoothedParam::LadderFilterCutoff)));
+    ladderFilter.dsp.setResonance(p.getSmoothedValue(SmoothedParam::LadderFilterResonance));
+    ladderFilter.dsp.setDrive(p.getSmoothedValue(SmoothedParam::LadderFilterDrive));
+
+    convolution.dsp.setMix(p.getSmoothedValue(SmoothedParam::ConvolutionMix));
+    convolution.dsp.setGainDecibels(p.getSmoothedValue(SmoothedParam::ConvolutionGain));
+
+    delay.dsp.setDelaySeconds(p.delaySeconds);
+    delay.dsp.setFeedback(p.getSmoothedValue(SmoothedParam::DelayFeedback));
+    delay.dsp.setLowCutHz(p.getSmoothedValue(SmoothedParam::DelayLowCut));
+    delay.dsp.setHighCutHz(p.getSmoothedValue(SmoothedParam::DelayHighCut));
+    delay.dsp.setMix(p.getSmoothedValue(SmoothedParam::DelayMix));
+
+    //the coefficients are designed once for both channels in updateGeneralFilterCoefficients()
+    if( coefficientsVersion != p.generalFilterCoefficientsVersion )
+    {
+        coefficientsVersion = p.generalFilterCoefficientsVersion;
 
-    // need to update genral coeeffs here
-    auto sampleRate = p.getSampleRate();
-    //update generalFilter coefficients
+        generalFilter.dsp.setCoefficients(p.generalFilterCoefficients);
+
+        //only a mode change is a big enough jump to need the state cleared
+        if( filterMode != p.generalFilterCoefficientsMode )
+        {
+            filterMode = p.generalFilterCoefficientsMode;
+            generalFilter.reset();
+        }
+    }
+}
+
+void Audio_proAudioProcessor::updateGeneralFilterCoefficients()
+{
     //choices: peak, bandpass, notch, allpass
-    auto genMode = p.generalFilterMode->getIndex();
-    auto genHz = p.generalFilterFreqHzSmoother.getCurrentValue();
-    auto genQ = p.generalFilterQualitySmoother.getCurrentValue();
-    auto genGain = p.generalFilterGainSmoother.getCurrentValue();
-    
+    auto genMode = static_cast<GeneralFilterMode>(generalFilterMode->getIndex());
+    auto genHz = getModulatedFrequency(EnvelopeTarget::GeneralFilterFreq, getSmoothedValue(SmoothedParam::GeneralFilterFreq));
+    auto genQ = getSmoothedValue(SmoothedParam::GeneralFilterQuality);
+    auto genGain = getSmoothedValue(SmoothedParam::GeneralFilterGain);
+
     bool filterChanged = false;
     filterChanged |= (filterFreq != genHz);
     filterChanged |= (filterQ != genQ);
     filterChanged |= (filterGain != genGain);
-    
-    auto updatedMode = static_cast<GeneralFilterMode>(genMode);
-    filterChanged |= (filterMode != updatedMode);
-    
-    if( filterChanged )
-    {
-        filterMode = updatedMode;
-        filterFreq = genHz;
-        filterQ = genQ;
-        filterGain = genGain;
-        
-        juce::dsp::IIR::Coefficients<float>::Ptr coefficients;
-        switch(filterMode)
+    filterChanged |= (generalFilterCoefficientsMode != genMode);
+
+    if( ! filterChanged )
+        return;
+
+    filterFreq = genHz;
+    filterQ = genQ;
+    filterGain = genGain;
+
+    //a render doesn't care about the cost of a design, so it gets the exact values
+    const auto& coefficients = renderQualityActive
+                             ? CoefficientCache::designExact(genMode, filterFreq, filterQ, filterGain, chainSampleRate)
+                             : generalFilterCoefficientCache.get(genMode, filterFreq, filterQ, filterGain, chainSampleRate);
+
+    //a smoother step can land in the same quantized bucket, no need to touch the channels then
+    if( coefficients == generalFilterCoefficients && genMode == generalFilterCoefficientsMode )
+        return;
+
+    generalFilterCoefficients = coefficients;
+    generalFilterCoefficientsMode = genMode;
+    ++generalFilterCoefficientsVersion;
+}
+
+void Audio_proAudioProcessor::updateLimiterLookahead()
+{
+    const auto factor = oversampler.getFactor();
+    auto samples = juce::roundToInt(limiterLookaheadMs->get() * 0.001 * chainSampleRate / factor) * factor;
+    if( samples == limiterLookaheadSamples )
+        return;
+
+    //only the detector moves, the delay and so the latency stay where prepareToPlay put them
+    for( auto& limiter : limiters )
+        limiter.setLookaheadSamples(samples);
+    limiterLookaheadSamples = limiters[0].getLookaheadSamples();
+}
+
+void Audio_proAudioProcessor::updateConvolutionEngines()
+{
+    if( impulseResponseLoader.updateActivePackage(chainSampleRate, numConvolutionEngines) )
+        assignConvolutionEngines();
+}
+
+void Audio_proAudioProcessor::assignConvolutionEngines()
+{
+    //one engine per chain object of the prepared bands, [set][band * 2 + channel] like
+    //chainSets, so it stays with its chain whichever set is live. an empty package clears
+    //the IR, and so does one built for another rate or band count, until the load
+    //prepareToPlay asked for arrives
+    auto* package = impulseResponseLoader.getActivePackage();
+    if( package != nullptr && ! package->matches(chainSampleRate, numConvolutionEngines) )
+        package = nullptr;
+
+    const auto chainsPerSet = static_cast<size_t>(2 * preparedBands);
+    for( size_t set = 0; set < chainSets.size(); ++set )
+        for( size_t chain = 0; chain < chainSets[set].size(); ++chain )
         {
-            case GeneralFilterMode::Peak:
-            {
-                coefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate,
-                                                                                   filterFreq,
-                                                                                   filterQ,
-                                                                                   juce::Decibels::decibelsToGain(filterGain));
-                break;
-            }
-            case GeneralFilterMode::Bandpass:
+            const auto index = set * chainsPerSet + chain;
+            auto* engine = package != nullptr && chain < chainsPerSet && index < package->engines.size()
+                         ? package->engines[index].get() : nullptr;
+            chainSets[set][chain]->convolution.dsp.setEngine(engine);
+        }
+}
+
+void Audio_proAudioProcessor::loadImpulseResponse(const juce::File& file)
+{
+    apvts.state.setProperty(getImpulseResponsePathProperty(), file.getFullPathName(), nullptr);
+
+    //before prepareToPlay there's no rate to resample to, prepareToPlay picks the path up
+    if( chainSampleRate > 0.0 )
+        impulseResponseLoader.requestLoad(file, chainSampleRate, numConvolutionEngines);
+}
+
+juce::File Audio_proAudioProcessor::getImpulseResponseFile() const
+{
+    auto path = apvts.state.getProperty(getImpulseResponsePathProperty()).toString();
+    if( path.isEmpty() )
+        return {};
+
+    return juce::File(path);
+}
+
+Audio_proAudioProcessor::MonoChannelDSP& Audio_proAudioProcessor::getChannelDSP(int channel, int band)
+{
+    jassert(channel == 0 || channel == 1);
+    jassert(juce::isPositiveAndBelow(band, MultibandSplitter::maxBands));
+
+    return *chainSets[liveChainSet][static_cast<size_t>(band * 2 + channel)];
+}
+
+Audio_proAudioProcessor::MonoChannelDSP& Audio_proAudioProcessor::getShadowDSP(int channel, int band)
+{
+    jassert(channel == 0 || channel == 1);
+    jassert(juce::isPositiveAndBelow(band, MultibandSplitter::maxBands));
+
+    return *chainSets[1 - liveChainSet][static_cast<size_t>(band * 2 + channel)];
+}
+
+void Audio_proAudioProcessor::updateMultiband()
+{
+    //more bands than were prepared wait for the re-prepare processBlock asks for
+    auto newNumBands = juce::jmin(multibandBands->getIndex() + 1, preparedBands);
+
+    if( newNumBands != numBands )
+    {
+        //bands coming back in still have the state from the last time they ran, and the
+        //parameters too, since only the active bands are updated. the shadow one as well
+        //when a fade is running
+        for( int band = numBands; band < newNumBands; ++band )
+            for( int channel = 0; channel < 2; ++channel )
             {
-                coefficients = juce::dsp::IIR::Coefficients<float>::makeBandPass(sampleRate, 
-                                                                                 filterFreq,
-                                                                                 filterQ);
-                break;
+                auto& live = getChannelDSP(channel, band);
+                live.updateDSPFromParams();
+                live.reset();
+
+                if( isOrderFading() )
+                {
+                    auto& shadow = getShadowDSP(channel, band);
+                    shadow.updateDSPFromParams();
+                    shadow.reset();
+                }
             }
-            case GeneralFilterMode::Notch:
+
+        numBands = newNumBands;
+        splitter.setNumBands(numBands);
+        updateCrossovers();
+    }
+}
+
+void Audio_proAudioProcessor::layoutChainArena(DSPArena& arena, const juce::dsp::ProcessSpec& spec, const juce::dsp::ProcessSpec& limiterSpec)
+{
+    //processBands() runs every band and channel slot by slot, in chainSets order
+    auto layoutBands = [&](size_t set, int firstBand, int endBand)
+    {
+        for( int band = firstBand; band < endBand; ++band )
+            for( int channel = 0; channel < 2; ++channel )
+                chainSets[set][static_cast<size_t>(band * 2 + channel)]->layoutArena(arena, spec, dspOrder);
+    };
+
+    for( auto set : { liveChainSet, 1 - liveChainSet } )
+    {
+        layoutBands(set, 0, preparedBands);
+        limiters[set].layoutArena(arena, limiterSpec);
+    }
+
+    for( auto set : { liveChainSet, 1 - liveChainSet } )
+        layoutBands(set, preparedBands, MultibandSplitter::maxBands);
+}
+
+void Audio_proAudioProcessor::updateCrossovers()
+{
+    //smoothed like the other frequencies, so dragging a crossover doesn't step the filters.
+    //the splitter skips the redesign when nothing moved
+    for( int i = 0; i < numBands - 1; ++i )
+    {
+        splitter.setCrossoverFrequency(i, getSmoothedValue(static_cast<SmoothedParam>(static_cast<int>(SmoothedParam::Crossover1) + i)));
+    }
+}
+
+size_t Audio_proAudioProcessor::getLimiterSlot(const DSP_Order& order) noexcept
+{
+    return static_cast<size_t>(std::distance(order.begin(), std::find(order.begin(), order.end(), DSP_Option::Limiter)));
+}
+
+void Audio_proAudioProcessor::processBands(juce::dsp::AudioBlock<float> stereoBlock)
+{
+    const auto numSamples = stereoBlock.getNumSamples();
+    const auto fading = isOrderFading();
+    jassert(numSamples <= shadowScratch[0][0].size());
+
+    /*
+     the bands only run the slots before the limiter. the limiter and whatever comes after
+     it run once over the sum, so the bands adding up can't push the output over the ceiling:
+
+        in -> split -> band chains [0, limiter) -> sum -> limiter -> band 0's chain (limiter, end) -> out
+
+     with one band that's just the whole chain. during a fade the shadow set does the same
+     with its own order on copies of the bands, summed in shadowScratch[channel][0].
+     the live chains go slot by slot over every band and channel, so the slots that can run
+     in SIMD lanes see all the chains at once, see processSlotInLanes()
+    */
+    const auto liveLimiterSlot = getLimiterSlot(dspOrder);
+    const auto shadowLimiterSlot = getLimiterSlot(fadeOrder);
+    const auto split = numBands > 1;
+
+    if( split )
+        splitter.split(stereoBlock.getChannelPointer(0), stereoBlock.getChannelPointer(1), static_cast<int>(numSamples));
+
+    std::array<float*, numChainsPerSet> channels {};
+    std::array<bool, MultibandSplitter::maxBands> bypassedBands {};
+
+    for( int band = 0; band < numBands; ++band )
+    {
+        bypassedBands[static_cast<size_t>(band)] = split && ! bandProcess[static_cast<size_t>(band)]->get();
+
+        for( int channel = 0; channel < 2; ++channel )
+        {
+            auto* samples = split ? splitter.getBandBlock(band, channel, static_cast<int>(numSamples)).getChannelPointer(0)
+                                  : stereoBlock.getChannelPointer(static_cast<size_t>(channel));
+            channels[static_cast<size_t>(band * 2 + channel)] = samples;
+
+            if( fading )
             {
-                coefficients = juce::dsp::IIR::Coefficients<float>::makeNotch(sampleRate,
-                                                                              filterFreq,
-                                                                              filterQ);
-                break;
+                float* shadowSamples = shadowScratch[static_cast<size_t>(channel)][static_cast<size_t>(band)].data();
+                juce::FloatVectorOperations::copy(shadowSamples, samples, static_cast<int>(numSamples));
+                getShadowDSP(channel, band).process(juce::dsp::AudioBlock<float>(&shadowSamples, 1, numSamples),
+                                                    fadeOrder, 0, shadowLimiterSlot, bypassedBands[static_cast<size_t>(band)]);
             }
-            case GeneralFilterMode::Allpass:
+        }
+    }
+
+    for( size_t slot = 0; slot < liveLimiterSlot; ++slot )
+    {
+        if( processSlotInLanes(dspOrder[slot], channels, bypassedBands, numSamples) )
+            continue;
+
+        for( int band = 0; band < numBands; ++band )
+            for( int channel = 0; channel < 2; ++channel )
             {
-                coefficients = juce::dsp::IIR::Coefficients<float>::makeAllPass(sampleRate,
-                                                                                filterFreq,
-                                                                                filterQ);
-                break;
-            }
-            case GeneralFilterMode::END_OF_LIST:
-            { //very imp to have this case shoudk never be hit 
-                jassertfalse;
-                break;
+                auto* samples = channels[static_cast<size_t>(band * 2 + channel)];
+                getChannelDSP(channel, band).process(juce::dsp::AudioBlock<float>(&samples, 1, numSamples),
+                                                     dspOrder, slot, slot + 1, bypassedBands[static_cast<size_t>(band)]);
             }
+    }
+
+    for( int channel = 0; channel < 2; ++channel )
+    {
+        if( split )
+            splitter.sum(channel, stereoBlock.getChannelPointer(static_cast<size_t>(channel)), static_cast<int>(numSamples));
+
+        if( fading )
+        {
+            auto& scratch = shadowScratch[static_cast<size_t>(channel)];
+            for( int band = 1; band < numBands; ++band )
+                juce::FloatVectorOperations::add(scratch[0].data(), scratch[static_cast<size_t>(band)].data(), static_cast<int>(numSamples));
         }
-        
-        if( coefficients != nullptr )
+    }
+}
+
+bool Audio_proAudioProcessor::processSlotInLanes(DSP_Option option, const std::array<float*, numChainsPerSet>& channels,
+                                                 const std::array<bool, MultibandSplitter::maxBands>& bypassedBands, size_t numSamples)
+{
+    //every band and channel has the same settings for these, and a filter is cheap enough
+    //per sample that running it for up to SIMDLanes::width chains at once pays for packing them
+    if( option != DSP_Option::GeneralFilter && option != DSP_Option::Overdrive && option != DSP_Option::LadderFilter )
+        return false;
+
+    //bypassed, both leave the samples where they are
+    if( optionBypasses[static_cast<size_t>(option)]->get() )
+        return true;
+
+    auto& liveSet = chainSets[liveChainSet];
+    auto ladderOf = [option](MonoChannelDSP& chain) -> FastLadderFilter<float>&
+    {
+        return option == DSP_Option::Overdrive ? chain.overdrive.dsp : chain.ladderFilter.dsp;
+    };
+
+    std::array<size_t, numChainsPerSet> lanes {};
+    size_t numChains = 0;
+    for( int band = 0; band < numBands; ++band )
+    {
+        if( bypassedBands[static_cast<size_t>(band)] )
+            continue;
+
+        for( size_t index = static_cast<size_t>(band * 2); index < static_cast<size_t>(band * 2 + 2); ++index )
+            if( option == DSP_Option::GeneralFilter || ladderOf(*liveSet[index]).isEnabled() )
+                lanes[numChains++] = index;
+    }
+
+    for( size_t first = 0; first < numChains; first += SIMDLanes::width )
+    {
+        const auto numLanes = juce::jmin(SIMDLanes::width, numChains - first);
+        std::array<float*, SIMDLanes::width> laneChannels {};
+        for( size_t i = 0; i < numLanes; ++i )
+            laneChannels[i] = channels[lanes[first + i]];
+
+        SIMDLanes::interleave(laneChannels.data(), numLanes, laneFrames.data(), numSamples);
+
+        if( option == DSP_Option::GeneralFilter )
         {
+            std::array<Biquad*, SIMDLanes::width> filters {};
+            for( size_t i = 0; i < numLanes; ++i )
+                filters[i] = &liveSet[lanes[first + i]]->generalFilter.dsp;
 
-            //DONT WORRY IF THIS JAASSERT HITS JUST COMMENT STHIS OUT LOL 
-           //if( generalFilter.dsp.coefficients->coefficients.size() != coefficients->coefficients.size() )
-           //{
-           //    jassertfalse;    
-           //}
-            //this is the actual update of the coefficients
-            *generalFilter.dsp.coefficients = *coefficients;
-            generalFilter.reset();
+            Biquad::processLanes(filters, numLanes, laneFrames.data(), numSamples);
+        }
+        else
+        {
+            std::array<FastLadderFilter<float>*, SIMDLanes::width> filters {};
+            for( size_t i = 0; i < numLanes; ++i )
+                filters[i] = &ladderOf(*liveSet[lanes[first + i]]);
+
+            FastLadderFilter<float>::processLanes(filters, numLanes, laneFrames.data(), numSamples);
+        }
+
+        SIMDLanes::deinterleave(laneFrames.data(), numSamples, laneChannels.data(), numLanes);
+    }
+
+    return true;
+}
+
+void Audio_proAudioProcessor::processLimiter(juce::dsp::AudioBlock<float> stereoBlock)
+{
+    //bypassed it still delays, so the latency doesn't move
+    const auto bypass = getBypassParameter(DSP_Option::Limiter)->get();
+
+    juce::dsp::ProcessContextReplacing<float> context(stereoBlock);
+    context.isBypassed = bypass;
+    limiters[liveChainSet].process(context);
+
+    if( ! isOrderFading() )
+        return;
+
+    std::array<float*, 2> shadowChannels { shadowScratch[0][0].data(), shadowScratch[1][0].data() };
+    juce::dsp::AudioBlock<float> shadowBlock(shadowChannels.data(), 2, stereoBlock.getNumSamples());
+    juce::dsp::ProcessContextReplacing<float> shadowContext(shadowBlock);
+    shadowContext.isBypassed = bypass;
+    limiters[1 - liveChainSet].process(shadowContext);
+}
+
+void Audio_proAudioProcessor::processTail(juce::dsp::AudioBlock<float> block, int channel)
+{
+    auto* samples = block.getChannelPointer(0);
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+
+    getChannelDSP(channel, 0).process(block, dspOrder, getLimiterSlot(dspOrder) + 1, numDSPOptions);
+
+    if( ! isOrderFading() )
+        return;
+
+    float* shadowSamples = shadowScratch[static_cast<size_t>(channel)][0].data();
+    getShadowDSP(channel, 0).process(juce::dsp::AudioBlock<float>(&shadowSamples, 1, static_cast<size_t>(numSamples)),
+                                     fadeOrder, getLimiterSlot(fadeOrder) + 1, numDSPOptions);
+
+    //the position only moves once both channels are done, see advanceOrderFade()
+    for( int n = 0; n < numSamples; ++n )
+    {
+        auto position = static_cast<size_t>(juce::jmin(orderFadePosition + n, orderFadeLength));
+        auto fadeOut = orderFadeGains[static_cast<size_t>(orderFadeLength) - position];
+        samples[n] = samples[n] * fadeOut + shadowSamples[n] * orderFadeGains[position];
+    }
+}
+
+void Audio_proAudioProcessor::startOrderFade(const DSP_Order& newOrder)
+{
+    if( isOrderFading() )
+    {
+        pendingOrder = newOrder;
+        hasPendingOrder = true;
+        return;
+    }
+
+    //clicking a tab pushes the order it already has
+    if( newOrder == dspOrder )
+        return;
+
+    //nothing playing yet, nothing to fade
+    if( orderFadeGains.empty() )
+    {
+        dspOrder = newOrder;
+        return;
+    }
+
+    fadeOrder = newOrder;
+    orderFadePosition = 0;
+
+    //the shadow of an active band ran with whatever parameters it had at the end of the
+    //last fade. they go in before the reset, so the filters and smoothers start from the
+    //current settings instead of gliding there. inactive bands are set up by updateMultiband()
+    //if they come back in. the reset is cheap: the convolver only marks its delay line stale
+    for( int band = 0; band < numBands; ++band )
+        for( int channel = 0; channel < 2; ++channel )
+        {
+            auto& shadow = getShadowDSP(channel, band);
+            shadow.updateDSPFromParams();
+            shadow.reset();
         }
-    }    
+
+    //the limiter's line already holds the next limiterDelay samples of output. the shadow
+    //takes them over rather than starting that far behind in silence
+    limiters[1 - liveChainSet].copyStateFrom(limiters[liveChainSet]);
+}
+
+void Audio_proAudioProcessor::advanceOrderFade(int numSamples)
+{
+    if( ! isOrderFading() )
+        return;
+
+    orderFadePosition += numSamples;
+    if( orderFadePosition < orderFadeLength )
+        return;
+
+    //the shadow has the new order and all the state that's audible now. its delay lines
+    //take the long rings over, the outgoing chains get the short ones
+    auto& outgoing = chainSets[liveChainSet];
+    auto& incoming = chainSets[1 - liveChainSet];
+    for( size_t chain = 0; chain < incoming.size(); ++chain )
+        incoming[chain]->delay.dsp.takeRingFrom(outgoing[chain]->delay.dsp);
+
+    liveChainSet = 1 - liveChainSet;
+    dspOrder = fadeOrder;
+    orderFadePosition = -1;
+
+    if( hasPendingOrder )
+    {
+        hasPendingOrder = false;
+        startOrderFade(pendingOrder);
+    }
+}
+
+void Audio_proAudioProcessor::updateEnvelope(double sumOfSquares, int numSamples)
+{
+    activeEnvelopeTarget = static_cast<EnvelopeTarget>(envelopeTarget->getIndex());
+    if( activeEnvelopeTarget == EnvelopeTarget::Off )
+    {
+        envelopeFollower.reset();
+        return;
+    }
+
+    envelopeFollower.setAttackMs(envelopeAttackMs->get());
+    envelopeFollower.setReleaseMs(envelopeReleaseMs->get());
+    envelopeFollower.process(sumOfSquares, 2, numSamples);
 }
 
+float Audio_proAudioProcessor::getModulatedFrequency(EnvelopeTarget target, float frequencyHz) const noexcept
+{
+    if( target != activeEnvelopeTarget )
+        return frequencyHz;
+
+    return juce::jlimit(20.f, 20000.f, frequencyHz * envelopeFrequencyRatio);
+}
+
+void Audio_proAudioProcessor::updateDelayTime()
+{
+    static constexpr auto syncBeats = getDelaySyncBeats();
+    static_assert(syncBeats[0] == 0.0); // Off
+
+    const auto syncIndex = static_cast<size_t>(delaySync->getIndex());
+    jassert(syncIndex < syncBeats.size());
+
+    //longer than the ring (slow tempos, whole notes) just sits at TempoDelay::maxDelaySeconds
+    if( syncIndex > 0 && syncIndex < syncBeats.size() )
+        delaySeconds = syncBeats[syncIndex] * 60.0 / hostBpm;
+    else
+        delaySeconds = delayTimeMs->get() * 0.001;
+}
+
+void Audio_proAudioProcessor::updateDSPFromParams()
+{
+    //once per sub block, every channel then just multiplies by it
+    envelopeFrequencyRatio = envelopeFollower.getFrequencyRatio(getSmoothedValue(SmoothedParam::EnvelopeDepth));
+    updateGeneralFilterCoefficients();
+    updateDelayTime();
+    updateCrossovers();
+    forEachChannelDSP([](MonoChannelDSP& dsp) { dsp.updateDSPFromParams(); });
+
+    //in M/S the limiter measures the left/right the pair decodes to
+    const auto midSide = static_cast<StereoMode>(stereoMode->getIndex()) == StereoMode::MidSide;
+    for( auto& limiter : limiters )
+    {
+        limiter.setCeilingDecibels(getSmoothedValue(SmoothedParam::LimiterCeiling));
+        limiter.setRelease(limiterReleaseMs->get());
+        limiter.setMidSide(midSide);
+    }
+
+    if( isOrderFading() )
+        for( int band = 0; band < numBands; ++band )
+            for( int channel = 0; channel < 2; ++channel )
+                getShadowDSP(channel, band).updateDSPFromParams();
+}
 
 
 
 void Audio_proAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    DeadlineMonitor::ScopedBlock deadlineTimer(deadlineMonitor, buffer.getNumSamples());
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -740,8 +1195,21 @@ void Audio_proAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, ju
     
     
 
-    leftChannel.updateDSPFromParams();
-    rightChannel.updateDSPFromParams();
+    //updateDSPFromParams() runs at the top of every sub block below, doing it here as well
+    //was a whole extra parameter update per host buffer, which is most of the cost of tiny buffers
+    updateLimiterLookahead();
+    updateConvolutionEngines();
+    updateMultiband();
+
+    //the synced delay follows the tempo, a host without a playhead or a tempo keeps the last one
+    if( auto* playHead = getPlayHead() )
+        if( auto position = playHead->getPosition() )
+            if( auto bpm = position->getBpm(); bpm.hasValue() && *bpm > 0.0 )
+                hostBpm = *bpm;
+
+    //never during an offline render, the bounce keeps the chain it was prepared with
+    if( chainConfigChanged() && ! isNonRealtime() )
+        reprepareRequested = true;
 
     auto newDSPOrder= DSP_Order();
     newDSPOrder.fill(DSP_Option::END_OF_LIST);  // Initialize with sentinel value
@@ -754,56 +1222,104 @@ void Audio_proAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, ju
         jassertfalse;
         #endif
     }
-    //if pulled,replace
+    //if pulled, fade over to it
     if(hasNewOrder)
     {
-        dspOrder = newDSPOrder;
-        
-
+        startOrderFade(newDSPOrder);
     }
 
 
     const auto numSamples = buffer.getNumSamples(); // (1)
     auto samplesRemaining = numSamples;
-    auto maxSamplesToProcess = juce::jmin(samplesRemaining, 64); // (2)
+    //sub blocks end on the control block grid, see controlBlockPosition // (2)
     
-    leftPreRMS.set( buffer.getRMSLevel(0, 0, numSamples) );
-    rightPreRMS.set( buffer.getRMSLevel(1, 0, numSamples) );
+    //the meters are measured in the same sub block passes as the M/S encode/decode
+    const auto midSide = static_cast<StereoMode>(stereoMode->getIndex()) == StereoMode::MidSide;
+    MidSide::Energy preEnergy {}, postEnergy {};
+    //nothing GUI-only runs without an editor on screen. the input is still measured
+    //for the envelope follower when it's switched on
+    const auto guiTaps = guiTapsActive.load();
+    const auto measureInput = guiTaps || static_cast<EnvelopeTarget>(envelopeTarget->getIndex()) != EnvelopeTarget::Off;
+
+    //before the M/S encode, so the pre trace is always the plain input
+    if( guiTaps )
+        preTap.push(buffer.getReadPointer(0), buffer.getReadPointer(1), numSamples);
 
     auto block = juce::dsp::AudioBlock<float>(buffer);
       size_t startSample = 0; 
           while( samplesRemaining > 0 ) // (3)
     {
         /*
-         The first time through this loop samplesToProcess will be 64, because maxSmplesToProcess is set to 64, and samplesRamaining is 72.
-         the 2nd time this loop runs, samplesToProcess will be 8, because the previous loop consumed 64 of the 72 samples.
+         with the grid at 0 and 72 samples in, the first time through this loop samplesToProcess will be 64,
+         the 2nd time it will be 8, and the next buffer starts with the 56 that finish that control block.
          */
 
         //figure out how many samples to actually process.
-        auto samplesToProcess = juce::jmin(samplesRemaining, maxSamplesToProcess); // (4)
-        //advance each smoother 'samplesToProcess' samples
-        updateSmoothersFromParams(samplesToProcess, SmootherUpdateMode::liveInRealtime); // (5)
-        
-        //update the DSP
-        leftChannel.updateDSPFromParams();  // (6)
-        rightChannel.updateDSPFromParams();
-        
+        auto samplesToProcess = juce::jmin(samplesRemaining, subBlockSize - controlBlockPosition); // (4)
+
         //create a sub block from the buffer, and
-        auto subBlock = block.getSubBlock(startSample, samplesToProcess); // (7)
-        //till now was rpeprocessing
+        auto subBlock = block.getSubBlock(startSample, samplesToProcess); // (5)
+        auto* left = subBlock.getChannelPointer(0);
+        auto* right = subBlock.getChannelPointer(1);
+        //the input meter pass also measures the energy the envelope follows
+        auto preEnergyBefore = preEnergy[0] + preEnergy[1];
+        if( midSide )
+            MidSide::encode(left, right, samplesToProcess, preEnergy);
+        else if( measureInput )
+            MidSide::measure(left, right, samplesToProcess, preEnergy);
+        controlBlockEnergy += preEnergy[0] + preEnergy[1] - preEnergyBefore;
+
+        //the chain runs on this, at chainSampleRate
+        auto chainBlock = oversampler.processUp(subBlock);
+        const auto chainSamples = static_cast<int>(chainBlock.getNumSamples());
+
+        //advance each smoother 'chainSamples' samples
+        updateSmoothersFromParams(chainSamples, SmootherUpdateMode::liveInRealtime); // (6)
+        
+        //update the DSP. a render does it every sample while a smoother or the envelope is
+        //moving something, otherwise at the realtime rate, which is all the unsmoothed
+        //parameters ever get
+        renderUpdateCountdown -= samplesToProcess;
+        if( ! renderQualityActive || renderUpdateCountdown <= 0 || smoothers.isAnySmoothing()
+            || activeEnvelopeTarget != EnvelopeTarget::Off )
+        {
+            updateDSPFromParams();  // (7)
+            renderUpdateCountdown = maxSubBlockSize;
+        }
         //now process
-        leftChannel.process(subBlock.getSingleChannelBlock(0), dspOrder); // (8)
-        rightChannel.process(subBlock.getSingleChannelBlock(1), dspOrder);
+        processBands(chainBlock); // (8)
+        processLimiter(chainBlock);
+        processTail(chainBlock.getSingleChannelBlock(0), 0);
+        processTail(chainBlock.getSingleChannelBlock(1), 1);
+        advanceOrderFade(chainSamples);
+        oversampler.processDown(subBlock);
         //now is teh postpcessing
+        if( midSide )
+            MidSide::decode(left, right, samplesToProcess, postEnergy);
+        else if( guiTaps )
+            MidSide::measure(left, right, samplesToProcess, postEnergy);
+
+        //a finished control block moves the envelope, for the dsp updates from the next one on
+        controlBlockPosition += samplesToProcess;
+        if( controlBlockPosition == subBlockSize )
+        {
+            updateEnvelope(controlBlockEnergy, subBlockSize);
+            controlBlockEnergy = 0.0;
+            controlBlockPosition = 0;
+        }
 
         startSample += samplesToProcess; // (9)
         samplesRemaining -= samplesToProcess;
     }
-    leftPostRMS.set( buffer.getRMSLevel(0, 0, numSamples) );
-    rightPostRMS.set( buffer.getRMSLevel(1, 0, numSamples) );
-//spectru anyalser
-    leftSCSF.update(buffer);
-    rightSCSF.update(buffer);
+    if( guiTaps )
+    {
+        leftPreRMS.set( MidSide::getRMS(preEnergy, 0, numSamples) );
+        rightPreRMS.set( MidSide::getRMS(preEnergy, 1, numSamples) );
+        leftPostRMS.set( MidSide::getRMS(postEnergy, 0, numSamples) );
+        rightPostRMS.set( MidSide::getRMS(postEnergy, 1, numSamples) );
+        //spectru anyalser
+        postTap.push(buffer.getReadPointer(0), buffer.getReadPointer(1), numSamples);
+    }
 
 
 
@@ -812,39 +1328,23 @@ void Audio_proAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, ju
 }
 
 
-void Audio_proAudioProcessor::MonoChannelDSP::process(juce::dsp::AudioBlock<float> block, const DSP_Order &dspOrder)
+void Audio_proAudioProcessor::MonoChannelDSP::process(juce::dsp::AudioBlock<float> block, const DSP_Order &dspOrder, size_t firstSlot, size_t endSlot, bool bypassAll)
 {
     Dsp_pointers dspPointers;
     dspPointers.fill({}); //this was previously dspPointers.fill(nullptr);
+    const auto processors = getProcessors();
     
-    for( size_t i = 0; i < dspPointers.size(); ++i )
+    for( size_t i = firstSlot; i < juce::jmin(endSlot, dspPointers.size()); ++i )
     {
-        switch (dspOrder[i])
+        const auto option = static_cast<size_t>(dspOrder[i]);
+        if( option >= processors.size() )
         {
-            case DSP_Option::Phase:
-                dspPointers[i].processor = &phaser;
-                dspPointers[i].bypass = p.phaserBypass->get();
-                break;
-            case DSP_Option::Chorus:
-                dspPointers[i].processor = &chorus;
-                dspPointers[i].bypass = p.chorusBypass->get();
-                break;
-            case DSP_Option::Overdrive:
-                dspPointers[i].processor = &overdrive;
-                dspPointers[i].bypass = p.overdriveBypass->get();
-                break;
-            case DSP_Option::LadderFilter:
-                dspPointers[i].processor = &ladderFilter;
-                dspPointers[i].bypass = p.ladderFilterBypass->get();
-                break;
-            case DSP_Option::GeneralFilter:
-                dspPointers[i].processor = &generalFilter;
-                dspPointers[i].bypass = p.generalFilterBypass->get();
-                break;
-            case DSP_Option::END_OF_LIST:
-                jassertfalse;
-                break;
+            jassertfalse;
+            continue;
         }
+
+        dspPointers[i].processor = processors[option];
+        dspPointers[i].bypass = p.optionBypasses[option]->get() || bypassAll;
     }
     
     //now process:
@@ -874,6 +1374,30 @@ void Audio_proAudioProcessor::MonoChannelDSP::process(juce::dsp::AudioBlock<floa
 
 
 //==============================================================================
+void Audio_proAudioProcessor::setEditorVisible(bool isVisible)
+{
+    if( isVisible == guiTapsActive.load() )
+        return;
+
+    if( isVisible )
+    {
+        //the audio thread isn't writing to any of these while the taps are off, so the rings
+        //can be made the first time, and whatever is left from the last time the editor was
+        //up can be thrown away before they restart
+        preTap.allocate();
+        postTap.allocate();
+        preTap.discard();
+        postTap.discard();
+
+        leftPreRMS.set(0.f);
+        rightPreRMS.set(0.f);
+        leftPostRMS.set(0.f);
+        rightPostRMS.set(0.f);
+    }
+
+    guiTapsActive.store(isVisible);
+}
+
 bool Audio_proAudioProcessor::hasEditor() const
 {
     return true; // (change this to false if you choose to not supply an editor)
@@ -908,10 +1432,23 @@ struct juce::VariantConverter<Audio_proAudioProcessor::DSP_Order>
         while(!mis.isExhausted()){
             vec.push_back(mis.readInt());
         }
-        jassert(vec.size()==dspOrder.size());
-        for(size_t i = 0; i < vec.size(); ++i)
+        //sessions saved before an effect was added have a shorter order.
+        //keep the saved order and append the missing effects at the end
+        using Option = Audio_proAudioProcessor::DSP_Option;
+        constexpr auto numOptions = static_cast<int>(Option::END_OF_LIST);
+        jassert(vec.size() <= dspOrder.size());
+        dspOrder.fill(Option::END_OF_LIST);
+        size_t numRestored = 0;
+        for( auto value : vec )
         {
-            dspOrder[i]= static_cast<Audio_proAudioProcessor::DSP_Option>(vec[i]);
+            if( numRestored < dspOrder.size() && juce::isPositiveAndBelow(value, numOptions) )
+                dspOrder[numRestored++] = static_cast<Option>(value);
+        }
+        for( int i = 0; i < numOptions && numRestored < dspOrder.size(); ++i )
+        {
+            auto option = static_cast<Option>(i);
+            if( std::find(dspOrder.begin(), dspOrder.begin() + numRestored, option) == dspOrder.begin() + numRestored )
+                dspOrder[numRestored++] = option;
         }
         return dspOrder;
      }
@@ -962,6 +1499,9 @@ void Audio_proAudioProcessor::setStateInformation (const void* data, int sizeInB
             //for gui 
             restoredDspOrderFifo.push(order);
         }
+
+        //the path came back with the tree, reload it (or clear the IR if this session had none)
+        loadImpulseResponse(getImpulseResponseFile());
         //debugging the apvts state
         DBG( apvts.state.toXmlString() );
 
@@ -974,7 +1514,7 @@ void Audio_proAudioProcessor::setStateInformation (const void* data, int sizeInB
             order.fill(DSP_Option::LadderFilter);
             order[0] = DSP_Option::Chorus;
             
-            chorusBypass->setValueNotifyingHost(1.f);
+            getBypassParameter(DSP_Option::Chorus)->setValueNotifyingHost(1.f);
             dspOrderFifo.push(order);
         });
 #endif
@@ -10,27 +10,36 @@
 
 #include <JuceHeader.h>
 #include <Fifo.h>
-#include <SingleChannelSampleFifo.h>
+#include "EffectDescriptors.h"
+#include "ParameterUpdateBatcher.h"
+#include "DSP/FastLadderFilter.h"
+#include "DSP/CoefficientCache.h"
+#include "DSP/LookaheadLimiter.h"
+#include "DSP/ImpulseResponseLoader.h"
+#include "DSP/MultibandSplitter.h"
+#include "DSP/MidSide.h"
+#include "DSP/DeadlineMonitor.h"
+#include "DSP/SmootherBank.h"
+#include "DSP/EnvelopeFollower.h"
+#include "DSP/AnalyzerTap.h"
+#include "DSP/ChainOversampler.h"
+#include "DSP/DSPArena.h"
+#include "DSP/Biquad.h"
+#include "DSP/TempoDelay.h"
+#include <optional>
 //==============================================================================
 /**
 */
  //metering
     static constexpr int NEGATIVE_INFINITY = -72;
     static constexpr int MAX_DECIBELS = 12;
-    enum class GeneralFilterMode
-    {
-        Peak,
-        Bandpass,
-        Notch,
-        Allpass,
-        END_OF_LIST
-    };
   
 
 class Audio_proAudioProcessor  : public juce::AudioProcessor
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
+                             , private juce::Timer
 {
 public:
     //==============================================================================
@@ -76,9 +85,19 @@ public:
       Overdrive,
       LadderFilter,
       GeneralFilter,
+      Limiter,
+      Convolution,
+      Delay,
       END_OF_LIST
       
     };
+    static constexpr size_t numDSPOptions = static_cast<size_t>(DSP_Option::END_OF_LIST);
+    static_assert(effectDescriptors.size() == numDSPOptions, "one EffectDescriptor per DSP_Option, in the same order");
+    static const EffectDescriptor& getEffectDescriptor(DSP_Option option) noexcept
+    {
+        jassert(option != DSP_Option::END_OF_LIST);
+        return effectDescriptors[juce::jmin(static_cast<size_t>(option), numDSPOptions - 1)];
+    }
 
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     juce::AudioProcessorValueTreeState apvts{ *this, nullptr, "Settings",
@@ -101,57 +120,90 @@ public:
     juce::AudioParameterFloat* phaserCenterFreqHz=nullptr;
     juce::AudioParameterFloat* phaserFeedbackPercent=nullptr;
     juce::AudioParameterFloat* phaserMixPercent=nullptr;
- juce::AudioParameterBool* phaserBypass = nullptr;  
     juce::AudioParameterFloat* chorusRateHz = nullptr;
     juce::AudioParameterFloat* chorusDepthPercent = nullptr;
     juce::AudioParameterFloat* chorusCenterDelayMs = nullptr;
     juce::AudioParameterFloat* chorusFeedbackPercent = nullptr;
     juce::AudioParameterFloat* chorusMixPercent = nullptr;
-    juce::AudioParameterBool* chorusBypass = nullptr;
     juce::AudioParameterFloat* overdriveSaturationPercent = nullptr;
-    juce::AudioParameterBool* overdriveBypass = nullptr;
+    juce::AudioParameterChoice* saturationQuality = nullptr;
   juce::AudioParameterChoice* ladderFilterMode = nullptr;
     juce::AudioParameterFloat* ladderFilterCutoffHz = nullptr;
     juce::AudioParameterFloat* ladderFilterResonance = nullptr;
     juce::AudioParameterFloat* ladderFilterDrive = nullptr;
-  juce::AudioParameterBool* ladderFilterBypass = nullptr;
     juce::AudioParameterChoice* generalFilterMode = nullptr;
     juce::AudioParameterFloat* generalFilterFreqHz = nullptr;
     juce::AudioParameterFloat* generalFilterQuality = nullptr;
     juce::AudioParameterFloat* generalFilterGaindB = nullptr;
-    juce::AudioParameterBool* generalFilterBypass = nullptr;
+    juce::AudioParameterFloat* limiterCeilingdB = nullptr;
+    juce::AudioParameterFloat* limiterReleaseMs = nullptr;
+    juce::AudioParameterFloat* limiterLookaheadMs = nullptr;
+    juce::AudioParameterFloat* convolutionMixPercent = nullptr;
+    juce::AudioParameterFloat* convolutionGaindB = nullptr;
+    juce::AudioParameterFloat* delayTimeMs = nullptr;
+    juce::AudioParameterChoice* delaySync = nullptr;
+    juce::AudioParameterFloat* delayFeedbackPercent = nullptr;
+    juce::AudioParameterFloat* delayLowCutHz = nullptr;
+    juce::AudioParameterFloat* delayHighCutHz = nullptr;
+    juce::AudioParameterFloat* delayMixPercent = nullptr;
+    juce::AudioParameterChoice* multibandBands = nullptr;
+    juce::AudioParameterChoice* stereoMode = nullptr;
+    juce::AudioParameterChoice* envelopeTarget = nullptr;
+    juce::AudioParameterFloat* envelopeDepthOctaves = nullptr;
+    juce::AudioParameterFloat* envelopeAttackMs = nullptr;
+    juce::AudioParameterFloat* envelopeReleaseMs = nullptr;
+    juce::AudioParameterChoice* oversamplingFactor = nullptr;
+    juce::AudioParameterChoice* oversamplingFilter = nullptr;
+    juce::AudioParameterBool* renderQuality = nullptr;
+    std::array<juce::AudioParameterFloat*, MultibandSplitter::maxCrossovers> crossoverFreqHz {};
+    std::array<juce::AudioParameterBool*, MultibandSplitter::maxBands> bandProcess {};
    
    
 
-       juce::SmoothedValue<float>
-    phaserRateHzSmoother,
-    phaserDepthPercentSmoother,
-    phaserCenterFreqHzSmoother,
-    phaserFeedbackPercentSmoother,
-    phaserMixPercentSmoother,
-    chorusRateHzSmoother,
-    chorusDepthPercentSmoother,
-    chorusCenterDelayMsSmoother,
-    chorusFeedbackPercentSmoother,
-    chorusMixPercentSmoother,
-    overdriveSaturationSmoother,
-    ladderFilterCutoffHzSmoother,
-    ladderFilterResonanceSmoother,
-    ladderFilterDriveSmoother,
-    generalFilterFreqHzSmoother,
-    generalFilterQualitySmoother,
-    generalFilterGainSmoother,
-    inputGainSmoother,
-    outputGainSmoother;
+    //one lane per smoothed float parameter, in EffectDescriptors.h with the rest of the specs
+    using SmoothedParam = ::SmoothedParam;
+
+    static constexpr size_t numSmoothedParams = static_cast<size_t>(SmoothedParam::END_OF_LIST);
+    SmootherBank<numSmoothedParams> smoothers;
+    std::array<juce::AudioParameterFloat*, numSmoothedParams> smoothedParams {};
+
+    float getSmoothedValue(SmoothedParam param) const noexcept { return smoothers.getCurrentValue(static_cast<size_t>(param)); }
   juce::Atomic<float> leftPreRMS, rightPreRMS, leftPostRMS, rightPostRMS;
-SimpleMBComp::SingleChannelSampleFifo<juce::AudioBuffer<float>> leftSCSF { SimpleMBComp::Channel::Left }, rightSCSF { SimpleMBComp::Channel::Right };
+    //written by processBlock, read by the editor's load panel
+    DeadlineMonitor deadlineMonitor;
+    //the state of every chain, rebuilt in prepareToPlay. the render tool's cache benchmark
+    //switches it to scattered before preparing, to compare against
+    DSPArena dspArena;
+    //the analyzer's feeds, the input before the chain and the output after it
+    AnalyzerTap preTap, postTap;
+    //every parameter change marks a dirty bit, the editors' controls pick them up once a frame
+    ParameterUpdateBatcher guiUpdates { *this };
+
+    //message thread. the editor reports whether it's on screen, the meters and analyzer
+    //taps above are only fed while it is
+    void setEditorVisible(bool isVisible);
+
+    //the option's editor page, in effectDescriptors order with the bypass last
+    const std::vector<juce::RangedAudioParameter*>& getparamsforoption(DSP_Option option) const noexcept;
+    juce::AudioParameterBool* getBypassParameter(DSP_Option option) const noexcept;
 
-   std::vector<juce::RangedAudioParameter*> getparamsforoption(DSP_Option option);
+    //message thread. the file is read and partitioned on the loader thread, an empty file clears the IR
+    void loadImpulseResponse(const juce::File& file);
+    juce::File getImpulseResponseFile() const;
+    //the IR from the last load is still being read and transformed
+    bool isLoadingImpulseResponse() const noexcept { return impulseResponseLoader.isLoading(); }
+    bool didImpulseResponseFail() const noexcept { return impulseResponseLoader.didLastLoadFail(); }
 
 
     DSP_Order dspOrder;
 
 private:
+    std::atomic<bool> guiTapsActive { false };
+
+    //resolved from effectDescriptors once in the constructor, indexed by DSP_Option
+    std::array<std::vector<juce::RangedAudioParameter*>, numDSPOptions> optionParams;
+    std::array<juce::AudioParameterBool*, numDSPOptions> optionBypasses {};
+
     template<typename DSP>
     struct DSP_Choice : juce::dsp::ProcessorBase
     {
@@ -175,28 +227,208 @@ private:
        struct MonoChannelDSP
     {
         MonoChannelDSP(Audio_proAudioProcessor& proc) : p(proc) {}
-        DSP_Choice<juce::dsp::DelayLine<float>> delay;
         DSP_Choice<juce::dsp::Phaser<float>> phaser;
         DSP_Choice<juce::dsp::Chorus<float>> chorus;
-        DSP_Choice<juce::dsp::LadderFilter<float>> overdrive, ladderFilter;
-        DSP_Choice<juce::dsp::IIR::Filter<float>> generalFilter;
+        DSP_Choice<FastLadderFilter<float>> overdrive, ladderFilter;
+        DSP_Choice<Biquad> generalFilter;
+        DSP_Choice<ConvolutionStage> convolution;
+        DSP_Choice<TempoDelay<float>> delay;
+
+        //every slot above, indexed by DSP_Option. the limiter is stereo linked, so it's the
+        //processor's (see limiters) and its slot here is empty
+        std::array<juce::dsp::ProcessorBase*, numDSPOptions> getProcessors() noexcept
+        {
+            return { &phaser, &chorus, &overdrive, &ladderFilter, &generalFilter, nullptr, &convolution, &delay };
+        }
         
+        //takes every buffer this chain needs from the arena, in the order the chain runs them
+        void layoutArena(DSPArena& arena, const juce::dsp::ProcessSpec& spec, const DSP_Order& order);
         void prepare(const juce::dsp::ProcessSpec& spec);
         
         void updateDSPFromParams();
         
-        void process(juce::dsp::AudioBlock<float> block, const DSP_Order& dspOrder);
+        void reset();
+        
+        //the slots [firstSlot, endSlot) of the order. bypassAll runs them all bypassed, so a
+        //switched off band still feeds the delay's history
+        void process(juce::dsp::AudioBlock<float> block, const DSP_Order& dspOrder, size_t firstSlot, size_t endSlot, bool bypassAll = false);
         
     private:
         Audio_proAudioProcessor& p;
         GeneralFilterMode filterMode = GeneralFilterMode::END_OF_LIST;
-        //all the parameters for the general filter are outside range of the dsp
-        float filterFreq = 0.f, filterQ = 0.f, filterGain = -100.f;        
+        //which generalFilterCoefficients this channel has copied in, -1 forces a copy
+        int coefficientsVersion = -1;
     };
 
+    //designed once per sub block and copied into both channels
+    CoefficientCache generalFilterCoefficientCache;
+    BiquadCoefficients generalFilterCoefficients { 1.f, 0.f, 0.f, 0.f, 0.f };
+    GeneralFilterMode generalFilterCoefficientsMode = GeneralFilterMode::END_OF_LIST;
+    int generalFilterCoefficientsVersion = 0;
+    //all the parameters for the general filter are outside range of the dsp
+    float filterFreq = 0.f, filterQ = 0.f, filterGain = -100.f;
+
+    void updateGeneralFilterCoefficients();
+    void updateDSPFromParams();
+
+    //the playhead's tempo from the last block that had one, the synced delay follows it
+    double hostBpm = 120.0;
+    //Delay Time, or the Delay Sync note at hostBpm. once per sub block, for every chain
+    double delaySeconds = 0.5;
+    void updateDelayTime();
+
+    //driven by the input meter pass, see updateEnvelope()
+    EnvelopeFollower envelopeFollower;
+    EnvelopeTarget activeEnvelopeTarget = EnvelopeTarget::Off;
+    float envelopeFrequencyRatio = 1.f;
+
+    void updateEnvelope(double sumOfSquares, int numSamples);
+    //the ladder cutoff / general filter frequency, moved by the envelope when it's the target
+    float getModulatedFrequency(EnvelopeTarget target, float frequencyHz) const noexcept;
+
+    //every chain runs at chainSampleRate, oversampler.getFactor() times the host rate. the
+    //input/output passes, the envelope and the meters stay at the host rate
+    ChainOversampler oversampler;
+    double chainSampleRate = 0.0;
+    int activeOversamplingIndex = -1, activeOversamplingFilterIndex = -1;
+    //a new factor or filter reallocates, so processBlock only raises this flag and the
+    //timer re-prepares on the message thread. nothing is posted from the audio thread
+    std::atomic<bool> reprepareRequested { false };
+    //the chain rate and engine count a loaded IR is being rebuilt for ahead of that
+    //re-prepare, 0 when none
+    double preloadedChainRate = 0.0;
+    int preloadedEngines = 0;
+    void timerCallback() override;
+    //what prepareToPlay would pick with the current parameters
+    int getWantedOversamplingExponent() const noexcept;
+
+    //offline (isNonRealtime() with Render Quality on) the chain runs at no less than 4x,
+    //with the precise saturation, exact filter coefficients and the smoothers and dsp
+    //updated every host sample while anything moves. realtime keeps whatever the parameters
+    //say and 64 sample control updates. only prepareToPlay switches between the two, hosts
+    //prepare before a bounce, and a switch half way through one would be audible in it
+    static constexpr int renderOversamplingExponent = 2;
+    static constexpr int renderSubBlockSize = 1;
+    bool renderQualityActive = false;
+    bool wantsRenderQuality() const noexcept;
+    //the factor or filter differ from what the chain was prepared with, or there are more
+    //bands than it was prepared for
+    bool chainConfigChanged() const noexcept;
+    //host samples until the next dsp update while rendering with nothing moving
+    int renderUpdateCountdown = 0;
+
+    //one stereo linked limiter per chain set, [set] like chainSets. its fixed delay of
+    //maxLookaheadMs plus the oversampling filters is the plugin's latency, the lookahead
+    //parameter only moves the detector. at the chain rate, multiples of the factor
+    std::array<LookaheadLimiter<float>, 2> limiters;
+    int limiterLookaheadSamples = -1;
+    void updateLimiterLookahead();
+
+    //every mono chain, [set][band * 2 + channel]. one set is live, the other is the shadow
+    //a new DSP order fades into, see startOrderFade(). the bands share their parameters
+    static constexpr int numChainsPerSet = 2 * MultibandSplitter::maxBands;
+    //held in place rather than one heap allocation each, so the chain objects are contiguous too
+    std::array<std::array<std::optional<MonoChannelDSP>, numChainsPerSet>, 2> chainSets;
+    size_t liveChainSet = 0;
+
+    //owns every ConvolutionPackage, the audio thread only swaps pointers
+    ImpulseResponseLoader impulseResponseLoader;
+    //one engine per mono chain of the prepared bands, in both sets, see assignConvolutionEngines().
+    //an engine holds its chain's convolution history, so the shadow can't borrow the live
+    //one's, but bands that were never prepared don't get any. 4 at one band, 16 at four
+    int numConvolutionEngines = 4;
+    void updateConvolutionEngines();
+    //hands the active package's engines to the chains, or clears them
+    void assignConvolutionEngines();
+
+    //both channels, see processBands()
+    MultibandSplitter splitter;
+    int numBands = 1;
+    //the bands that have IR engines, numBands stays at or below this. more bands than that
+    //re-prepare like a new oversampling factor does, it never shrinks, and a render
+    //prepares every band since it can't re-prepare half way through
+    int preparedBands = 1;
+    int getWantedPreparedBands() const noexcept;
+    //from the Crossover lanes, every sub block
+    void updateCrossovers();
+    //where the order's limiter is, the bands run the slots before it. the size if it isn't there
+    static size_t getLimiterSlot(const DSP_Order& order) noexcept;
+
+    MonoChannelDSP& getChannelDSP(int channel, int band);
+    MonoChannelDSP& getShadowDSP(int channel, int band);
+    //the live chains of the active bands
+    template<typename Func>
+    void forEachChannelDSP(Func&& func)
+    {
+        for( int band = 0; band < numBands; ++band )
+            for( int channel = 0; channel < 2; ++channel )
+                func(getChannelDSP(channel, band));
+    }
+    //live and shadow, for setup that has to match whichever set is live
+    template<typename Func>
+    void forEveryChainDSP(Func&& func)
+    {
+        for( auto& set : chainSets )
+            for( auto& chain : set )
+                func(*chain);
+    }
+
+    void updateMultiband();
+    //the chains and limiters in the order a sub block runs them: the live set band by band,
+    //its limiter, then the shadow set and its limiter. bands that aren't prepared last.
+    //the delay rings move between the sets when a fade ends, until the next prepare
+    void layoutChainArena(DSPArena& arena, const juce::dsp::ProcessSpec& spec, const juce::dsp::ProcessSpec& limiterSpec);
+    /*
+     one sub block goes through the chain in three passes, because the limiter needs both
+     channels at once:
+
+        processBands    both channels: split, the band chains up to the limiter, sum
+        processLimiter  both channels: the linked limiter
+        processTail     per channel: everything after the limiter, then the fade mix
+    */
+    void processBands(juce::dsp::AudioBlock<float> stereoBlock);
+    void processLimiter(juce::dsp::AudioBlock<float> stereoBlock);
+    void processTail(juce::dsp::AudioBlock<float> block, int channel);
+
+    /*
+     a new DSP order doesn't switch the live chains over mid signal. the shadow set is reset,
+     runs the new order on a copy of each sub block next to the old one, and the two are
+     mixed with equal power gains for orderFadeSeconds. then the shadow becomes the live
+     set. an order that comes in during a fade waits for it to finish. nothing here
+     allocates, and outside a fade the shadow set doesn't run at all.
+    */
+    static constexpr int maxSubBlockSize = 64;
+    //maxSubBlockSize, or renderSubBlockSize while rendering
+    int subBlockSize = maxSubBlockSize;
+    //host samples into the current control block of subBlockSize. sub blocks never cross
+    //its end, and the envelope only moves once one is complete, on its whole energy. so the
+    //dsp updates and the envelope land on the same samples whatever buffer sizes the host
+    //sends, at the cost of the envelope running one control block behind
+    int controlBlockPosition = 0;
+    double controlBlockEnergy = 0.0;
+    static constexpr double orderFadeSeconds = 0.02;
+    DSP_Order fadeOrder, pendingOrder;
+    bool hasPendingOrder = false;
+    //-1 when there's no fade running
+    int orderFadePosition = -1;
+    int orderFadeLength = 0;
+    //sin(pi/2 * i / orderFadeLength) for i in [0, orderFadeLength], built in prepareToPlay
+    std::vector<float> orderFadeGains;
+    //a sub block at the highest oversampling factor, [channel][band]. band 0 holds the shadow's
+    //sum from processBands() until processTail() mixes it in
+    using ShadowBuffer = std::array<float, (maxSubBlockSize << ChainOversampler::maxFactorExponent)>;
+    std::array<std::array<ShadowBuffer, MultibandSplitter::maxBands>, 2> shadowScratch {};
+
+    //the general filter and ladder slots of every live band and channel run together, as
+    //SIMDRegister lanes over these interleaved frames, see processSlotInLanes()
+    std::array<SIMDLanes::Register, std::tuple_size_v<ShadowBuffer>> laneFrames;
+    //false for the options that run chain by chain. [band * 2 + channel] like chainSets
+    bool processSlotInLanes(DSP_Option option, const std::array<float*, numChainsPerSet>& channels,
+                            const std::array<bool, MultibandSplitter::maxBands>& bypassedBands, size_t numSamples);
 
-    MonoChannelDSP leftChannel { *this };
-    MonoChannelDSP rightChannel { *this };
+    bool isOrderFading() const noexcept { return orderFadePosition >= 0; }
+    void startOrderFade(const DSP_Order& newOrder);
+    void advanceOrderFade(int numSamples);
 
     struct ProcessState
     {
@@ -212,13 +444,13 @@ private:
     {
         for( size_t i = 0; i < paramsArray.size(); ++i )
         {
-            auto ptrToParamPtr = paramsArray[i];
-            *ptrToParamPtr = dynamic_cast<ParamType>
-            (apvts.getParameter( funcsArray[i]() ));
-            jassert( *ptrToParamPtr != nullptr );
+            //the IDs are literals, so this lookup doesn't allocate. the type is fixed by
+            //createParameterLayout(), so the dynamic_cast is only there to check it in debug builds
+            auto* param = apvts.getParameter( funcsArray[i]() );
+            jassert( dynamic_cast<ParamType>(param) != nullptr );
+            *paramsArray[i] = static_cast<ParamType>(param);
         }
     }
-    std::vector<juce::SmoothedValue<float>*> getSmoothers();
         enum class SmootherUpdateMode
     {
         initialize,
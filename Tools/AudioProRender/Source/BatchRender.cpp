@@ -0,0 +1,205 @@
+/*
+  ==============================================================================
+
+    BatchRender.cpp
+    runs folders of audio files through the processor, one instance per file.
+
+  ==============================================================================
+*/
+
+#include "BatchRender.h"
+#include "../../../Source/PluginProcessor.h"
+#include <numeric>
+#include <thread>
+
+bool loadPresetState(const juce::File& file, juce::MemoryBlock& state)
+{
+    juce::MemoryBlock data;
+    if( ! file.loadFileAsData(data) || data.getSize() == 0 )
+        return false;
+
+    //the binary tree starts with the type name's length, never with '<'
+    if( static_cast<const char*>(data.getData())[0] == '<' )
+    {
+        auto tree = juce::ValueTree::fromXml(data.toString());
+        if( ! tree.isValid() )
+            return false;
+
+        state.reset();
+        juce::MemoryOutputStream mos(state, false);
+        tree.writeToStream(mos);
+        return true;
+    }
+
+    if( ! juce::ValueTree::readFromData(data.getData(), data.getSize()).isValid() )
+        return false;
+
+    state = data;
+    return true;
+}
+
+juce::Array<juce::File> findBatchInputs(const juce::File& directory, bool recursive, const juce::String& suffix,
+                                        juce::AudioFormatManager& formats)
+{
+    auto files = directory.findChildFiles(juce::File::findFiles, recursive, formats.getWildcardForAllFormats());
+
+    files.removeIf([&suffix](const juce::File& file) { return file.getFileNameWithoutExtension().endsWith(suffix); });
+    return files;
+}
+
+//a memory mapped reader when the format has one and the whole file maps, a streaming one otherwise
+static std::unique_ptr<juce::AudioFormatReader> createReader(const juce::File& file, juce::AudioFormatManager& formats,
+                                                              bool& memoryMapped)
+{
+    memoryMapped = false;
+
+    for( int i = 0; i < formats.getNumKnownFormats(); ++i )
+    {
+        auto* format = formats.getKnownFormat(i);
+        if( ! format->canHandleFile(file) )
+            continue;
+
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(format->createMemoryMappedReader(file));
+        if( mapped != nullptr && mapped->mapEntireFile() )
+        {
+            memoryMapped = true;
+            return mapped;
+        }
+    }
+
+    return std::unique_ptr<juce::AudioFormatReader>(formats.createReaderFor(file));
+}
+
+BatchFileResult renderBatchFile(const juce::File& input, const BatchSettings& settings, juce::AudioFormatManager& formats)
+{
+    BatchFileResult result;
+    result.input = input;
+    result.output = input.getSiblingFile(input.getFileNameWithoutExtension() + settings.suffix + ".wav");
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    auto fail = [&result, startTicks](const juce::String& error)
+    {
+        result.error = error;
+        result.seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        return result;
+    };
+
+    auto reader = createReader(input, formats, result.memoryMapped);
+    if( reader == nullptr )
+        return fail("couldn't open for reading");
+
+    result.numChannels = static_cast<int>(reader->numChannels);
+    result.sampleRate = reader->sampleRate;
+    result.numSamples = reader->lengthInSamples;
+
+    //the plugin is stereo, folding more channels down would be a guess at the layout
+    if( result.numChannels < 1 || result.numChannels > 2 )
+        return fail("has " + juce::String(result.numChannels) + " channels, only mono and stereo files are rendered");
+
+    const auto blockSize = juce::jmax(1, settings.blockSize);
+
+    auto processor = std::make_unique<Audio_proAudioProcessor>();
+    processor->setNonRealtime(true);
+    processor->setStateInformation(settings.state.getData(), static_cast<int>(settings.state.getSize()));
+    processor->setRateAndBufferSizeDetails(result.sampleRate, blockSize);
+    processor->prepareToPlay(result.sampleRate, blockSize);
+
+    //the IR is read and resampled on the loader thread, the first block has to have it
+    while( processor->isLoadingImpulseResponse() )
+        juce::Thread::sleep(1);
+
+    //without it the convolution would pass the file through dry, and the output would look fine
+    if( processor->getImpulseResponseFile() != juce::File() && processor->didImpulseResponseFail() )
+        return fail("couldn't load the preset's impulse response " + processor->getImpulseResponseFile().getFullPathName());
+
+    result.output.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream(result.output.createOutputStream());
+    if( stream == nullptr )
+        return fail("couldn't create " + result.output.getFullPathName());
+
+    //float stays float, integer files keep their depth
+    const auto bitDepth = reader->usesFloatingPointData || reader->bitsPerSample > 24 ? 32
+                        : reader->bitsPerSample > 16 ? 24 : 16;
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), result.sampleRate, 2,
+                                                                         bitDepth, reader->metadataValues, 0));
+    if( writer == nullptr )
+        return fail("couldn't write a " + juce::String(bitDepth) + " bit wav at " + juce::String(result.sampleRate) + " Hz");
+
+    stream.release(); // the writer owns it now
+
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+
+    //the first 'latency' samples out are the plugin's delay, the last 'latency' in are silence
+    const auto latency = static_cast<juce::int64>(processor->getLatencySamples());
+    const auto totalSamples = result.numSamples + latency;
+
+    for( juce::int64 position = 0; position < totalSamples; )
+    {
+        const auto numThisBlock = static_cast<int>(juce::jmin(static_cast<juce::int64>(blockSize), totalSamples - position));
+        const auto numFromFile = static_cast<int>(juce::jlimit(juce::int64(0), static_cast<juce::int64>(numThisBlock),
+                                                               result.numSamples - position));
+
+        //a mono reader fills both channels
+        if( numFromFile > 0 && ! reader->read(&buffer, 0, numFromFile, position, true, true) )
+            return fail("read error at sample " + juce::String(position));
+        buffer.clear(numFromFile, numThisBlock - numFromFile);
+
+        juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), 2, 0, numThisBlock);
+        processor->processBlock(block, midi);
+
+        const auto numToSkip = static_cast<int>(juce::jlimit(juce::int64(0), static_cast<juce::int64>(numThisBlock), latency - position));
+        if( numToSkip < numThisBlock && ! writer->writeFromAudioSampleBuffer(buffer, numToSkip, numThisBlock - numToSkip) )
+            return fail("write error at sample " + juce::String(position));
+
+        position += numThisBlock;
+    }
+
+    processor->releaseResources();
+    writer.reset();
+
+    result.succeeded = true;
+    result.seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    return result;
+}
+
+std::vector<BatchFileResult> renderBatch(const juce::Array<juce::File>& inputs, const BatchSettings& settings)
+{
+    std::vector<BatchFileResult> results(static_cast<size_t>(inputs.size()));
+
+    //largest first, whatever order the caller listed them in
+    std::vector<int> order(results.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&inputs](int a, int b) { return inputs[a].getSize() > inputs[b].getSize(); });
+
+    //the readers it creates are independent, so the workers can share it
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    //every instance is built, restored and run on its worker. the message loop isn't running
+    //while this waits, so no apvts timer or async update touches an instance from elsewhere
+    std::atomic<size_t> next { 0 };
+    auto work = [&]()
+    {
+        for( auto i = next++; i < order.size(); i = next++ )
+        {
+            auto index = static_cast<size_t>(order[i]);
+            results[index] = renderBatchFile(inputs[order[i]], settings, formats);
+        }
+    };
+
+    const auto numThreads = juce::jlimit(1, juce::jmax(1, inputs.size()), settings.numThreads);
+    std::vector<std::thread> workers;
+    for( int t = 1; t < numThreads; ++t )
+        workers.emplace_back(work);
+
+    //the calling thread is a worker too
+    work();
+
+    for( auto& worker : workers )
+        worker.join();
+
+    return results;
+}
@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    BatchRender.h
+    runs folders of audio files through the processor, one instance per file.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct BatchSettings
+{
+    //what getStateInformation() wrote, every file's instance restores it
+    juce::MemoryBlock state;
+    //<name><suffix>.wav is written next to each input, inputs that already end in it are skipped
+    juce::String suffix = "_audio_pro";
+    int blockSize = 512;
+    int numThreads = 1;
+};
+
+struct BatchFileResult
+{
+    juce::File input, output;
+    bool succeeded = false;
+    juce::String error;
+    bool memoryMapped = false;
+    int numChannels = 0;
+    double sampleRate = 0.0;
+    juce::int64 numSamples = 0;
+    //processor setup, the IR load and the render itself
+    double seconds = 0.0;
+};
+
+/*
+ a preset is either the binary state the plugin saves into a session (what
+ getStateInformation() writes) or the same tree as xml, e.g. a copy of
+ apvts.state.toXmlString()
+*/
+bool loadPresetState(const juce::File& file, juce::MemoryBlock& state);
+
+//every file the format manager can read, minus our own outputs
+juce::Array<juce::File> findBatchInputs(const juce::File& directory, bool recursive, const juce::String& suffix,
+                                        juce::AudioFormatManager& formats);
+
+/*
+ one fresh processor per file, prepared at the file's rate as an offline render, so
+ render quality applies. the file is streamed through in blockSize chunks, read from a
+ memory mapped reader where the format has one. the plugin's latency is skipped at the
+ start and flushed with silence at the end, so the output lines up with the input and
+ has the same length. always 2 channels, a mono input goes into both. files with more
+ channels fail, and so does every file when the preset's impulse response doesn't load.
+*/
+BatchFileResult renderBatchFile(const juce::File& input, const BatchSettings& settings, juce::AudioFormatManager& formats);
+
+/*
+ numThreads workers all pull the next file from one shared queue until it's empty. the
+ inputs are sorted largest first, so a long file doesn't start last and leave the other
+ cores idle at the end. results come back in the order of 'inputs'.
+*/
+std::vector<BatchFileResult> renderBatch(const juce::Array<juce::File>& inputs, const BatchSettings& settings);
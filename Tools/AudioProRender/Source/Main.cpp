@@ -0,0 +1,969 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    AudioProRender: offline renders, golden output checks and benchmarks for
+    the audio_pro processor.
+
+  ==============================================================================
+*/
+
+#include "RenderHarness.h"
+#include "BatchRender.h"
+#include "../../../Source/PluginEditor.h"
+#include "../../../Source/DSP/SharedResources.h"
+#include "../../../Source/DSP/FastMath.h"
+#include <numeric>
+
+#if JUCE_LINUX
+ #include <linux/perf_event.h>
+ #include <sys/ioctl.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+/*
+ golden [--reference <dir>] [--hashes <file>] [--write] [--tolerance <x>] [--report <file>] [--permutations <n>] [--offline]
+
+ renders the test signals through
+    - every DSP_Option on its own (the rest bypassed), compared sample by sample against
+      <dir>/<option>_<signal>.wav
+    - every DSP_Order permutation with everything active, compared as per window rms
+      against <dir>/permutations.json (40320 full renders would be far too big to store,
+      --permutations checks only the first n)
+ --hashes checks every one of those renders against a manifest of getOutputHash()es
+ instead, or as well. that's one line per render, small enough to commit with the source,
+ but exact: it only holds for the compiler and CPU family it was written with. the wav
+ references take a tolerance and are what to use across machines.
+ anything with the convolution active loads writeTestImpulse(), so the convolution is
+ checked with an IR rather than passing straight through.
+ --write makes the references and/or the manifest instead of checking them. --offline
+ renders in the plugin's render quality, which needs its own set of either.
+ ns/sample for every configuration goes in the report either way.
+*/
+static void runGolden(const juce::ArgumentList& args)
+{
+    const auto useReferences = args.containsOption("--reference");
+    const auto useHashes = args.containsOption("--hashes");
+    const auto referenceDir = useReferences ? args.getFileForOption("--reference") : juce::File();
+    const auto hashFile = useHashes ? args.getFileForOption("--hashes") : juce::File();
+    const auto writing = args.containsOption("--write");
+    const auto tolerance = args.containsOption("--tolerance") ? args.getValueForOption("--tolerance").getFloatValue() : 1.0e-4f;
+    const auto maxPermutations = args.containsOption("--permutations") ? args.getValueForOption("--permutations").getIntValue() : -1;
+
+    if( ! useReferences && ! useHashes )
+        juce::ConsoleApplication::fail("golden needs --reference <dir>, --hashes <file> or both");
+
+    if( useReferences )
+    {
+        if( writing )
+            referenceDir.createDirectory();
+        else if( ! referenceDir.isDirectory() )
+            juce::ConsoleApplication::fail("no references in " + referenceDir.getFullPathName() + ", run with --write first");
+    }
+
+    const auto storedHashes = useHashes && ! writing ? juce::JSON::parse(hashFile) : juce::var();
+    if( useHashes && ! writing && ! storedHashes.isObject() )
+        juce::ConsoleApplication::fail("no hashes in " + hashFile.getFullPathName() + ", run with --write first");
+
+    auto* hashes = new juce::DynamicObject();
+    juce::var hashesVar(hashes);
+
+    RenderConfig baseConfig;
+    baseConfig.nonRealtime = args.containsOption("--offline");
+    const auto singleSignals = makeTestSignals(baseConfig.sampleRate, static_cast<int>(baseConfig.sampleRate));
+    //a quarter second is enough to tell the orders apart
+    const auto permutationSignals = makeTestSignals(baseConfig.sampleRate, static_cast<int>(baseConfig.sampleRate / 4));
+    static constexpr int fingerprintWindow = 1024;
+
+    const auto testImpulse = writeTestImpulse(baseConfig.sampleRate);
+    if( testImpulse == juce::File() )
+        juce::ConsoleApplication::fail("couldn't write the test impulse response");
+
+    auto loadImpulseIfConvolving = [&testImpulse](RenderConfig& config)
+    {
+        const auto& active = config.activeOptions;
+        if( std::find(active.begin(), active.end(), DSP_Option::Convolution) != active.end() )
+            config.impulseResponse = testImpulse;
+    };
+
+    juce::Array<juce::var> configResults;
+    int numFailed = 0;
+
+    auto addResult = [&](const juce::String& name, const juce::String& signal, double nsPerSample, float error, bool hashMatches)
+    {
+        const auto passed = error <= tolerance && hashMatches;
+
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("config", name);
+        entry->setProperty("signal", signal);
+        entry->setProperty("nsPerSample", nsPerSample);
+        entry->setProperty("maxError", error);
+        entry->setProperty("hashMatches", hashMatches);
+        entry->setProperty("passed", passed);
+        configResults.add(juce::var(entry));
+
+        if( ! passed )
+        {
+            ++numFailed;
+            std::cout << "FAIL " << name << " / " << signal << " max error " << error
+                      << (hashMatches ? "" : ", hash differs") << std::endl;
+        }
+    };
+
+    //stores this render's hash, and checks it unless the manifest is being written
+    auto checkHash = [&](const juce::String& key, const juce::AudioBuffer<float>& output)
+    {
+        const auto hash = getOutputHash(output);
+        hashes->setProperty(key, hash);
+
+        return writing || ! useHashes || storedHashes[juce::Identifier(key)].toString() == hash;
+    };
+
+    //-1 is everything bypassed
+    std::vector<RenderConfig> singleConfigs;
+    for( int i = -1; i < numDSPOptions; ++i )
+    {
+        auto config = baseConfig;
+        config.name = i < 0 ? juce::String("bypassed") : getOptionName(static_cast<DSP_Option>(i));
+        if( i >= 0 )
+            config.activeOptions = { static_cast<DSP_Option>(i) };
+        loadImpulseIfConvolving(config);
+        singleConfigs.push_back(config);
+    }
+
+    //each filter again with the envelope follower moving it
+    for( auto [option, target] : { std::pair { DSP_Option::LadderFilter, EnvelopeTarget::LadderCutoff },
+                                   std::pair { DSP_Option::GeneralFilter, EnvelopeTarget::GeneralFilterFreq } } )
+    {
+        auto config = baseConfig;
+        config.name = getOptionName(option) + "+envelope";
+        config.activeOptions = { option };
+        config.envelopeTarget = target;
+        singleConfigs.push_back(config);
+    }
+
+    for( const auto& config : singleConfigs )
+    {
+        for( const auto& signal : singleSignals )
+        {
+            auto result = render(config, signal.buffer);
+            const auto hashMatches = checkHash(config.name + "_" + signal.name, result.output);
+            auto file = referenceDir.getChildFile(config.name + "_" + signal.name + ".wav");
+
+            if( writing )
+            {
+                if( useReferences && ! writeWavFile(file, result.output, config.sampleRate) )
+                    juce::ConsoleApplication::fail("couldn't write " + file.getFullPathName());
+
+                addResult(config.name, signal.name, result.nsPerSample, 0.f, true);
+                continue;
+            }
+
+            auto error = 0.f;
+            if( useReferences )
+            {
+                juce::AudioBuffer<float> reference;
+                error = readWavFile(file, reference) ? getMaxDifference(result.output, reference)
+                                                     : std::numeric_limits<float>::infinity();
+            }
+            addResult(config.name, signal.name, result.nsPerSample, error, hashMatches);
+        }
+    }
+
+    auto permutationsFile = referenceDir.getChildFile("permutations.json");
+    auto storedFingerprints = writing || ! useReferences ? juce::var() : juce::JSON::parse(permutationsFile);
+    auto* fingerprints = new juce::DynamicObject();
+    juce::var fingerprintsVar(fingerprints);
+
+    std::vector<int> indices(static_cast<size_t>(numDSPOptions));
+    std::iota(indices.begin(), indices.end(), 0);
+    int numPermutations = 0;
+
+    do
+    {
+        RenderConfig config = baseConfig;
+        for( size_t i = 0; i < indices.size(); ++i )
+        {
+            config.order[i] = static_cast<DSP_Option>(indices[i]);
+            config.activeOptions.push_back(static_cast<DSP_Option>(i));
+        }
+        config.name = getOrderName(config.order);
+        loadImpulseIfConvolving(config);
+
+        auto* perSignal = new juce::DynamicObject();
+        for( const auto& signal : permutationSignals )
+        {
+            auto result = render(config, signal.buffer);
+            auto rms = getWindowRMS(result.output, fingerprintWindow);
+            perSignal->setProperty(signal.name, rms);
+            const auto hashMatches = checkHash(config.name + "_" + signal.name, result.output);
+
+            if( writing )
+            {
+                addResult(config.name, signal.name, result.nsPerSample, 0.f, true);
+                continue;
+            }
+
+            auto error = 0.f;
+            if( useReferences )
+            {
+                auto* stored = storedFingerprints[juce::Identifier(config.name)][juce::Identifier(signal.name)].getArray();
+                error = std::numeric_limits<float>::infinity();
+                if( stored != nullptr && stored->size() == rms.size() )
+                {
+                    error = 0.f;
+                    for( int w = 0; w < rms.size(); ++w )
+                        error = juce::jmax(error, std::abs(static_cast<float>(rms[w]) - static_cast<float>((*stored)[w])));
+                }
+            }
+            addResult(config.name, signal.name, result.nsPerSample, error, hashMatches);
+        }
+
+        fingerprints->setProperty(config.name, juce::var(perSignal));
+        ++numPermutations;
+    }
+    while( std::next_permutation(indices.begin(), indices.end())
+           && (maxPermutations < 0 || numPermutations < maxPermutations) );
+
+    if( writing && useReferences && ! writeJsonFile(permutationsFile, fingerprintsVar) )
+        juce::ConsoleApplication::fail("couldn't write " + permutationsFile.getFullPathName());
+
+    if( writing && useHashes && ! writeJsonFile(hashFile, hashesVar) )
+        juce::ConsoleApplication::fail("couldn't write " + hashFile.getFullPathName());
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("mode", writing ? "write" : "check");
+    report->setProperty("sampleRate", baseConfig.sampleRate);
+    report->setProperty("blockSize", baseConfig.blockSize);
+    report->setProperty("nonRealtime", baseConfig.nonRealtime);
+    report->setProperty("tolerance", tolerance);
+    report->setProperty("numPermutations", numPermutations);
+    report->setProperty("numFailed", numFailed);
+    report->setProperty("results", configResults);
+    juce::var reportVar(report);
+
+    if( args.containsOption("--report") )
+        writeJsonFile(args.getFileForOption("--report"), reportVar);
+    else
+        std::cout << juce::JSON::toString(reportVar) << std::endl;
+
+    std::cout << configResults.size() << " renders, " << numFailed << " failed" << std::endl;
+
+    //fail() is how a ConsoleApplication command sets the exit code
+    if( numFailed > 0 )
+        juce::ConsoleApplication::fail(juce::String(numFailed) + " renders differ from the references");
+}
+
+/*
+ stress [--tolerance <x>] [--report <file>]
+
+ renders the test signals with everything active, once with fixed 512 sample buffers
+ and then with odd, random and adversarial buffer size sequences. the output has to
+ match the 512 render (by default exactly: constant parameters give the same smoother
+ values whatever the sub block boundaries are), and the per block cost is reported as
+ a distribution per sequence and per block size range, which shows where the fixed per
+ block work (parameter updates, the 64 sample split) starts to dominate.
+*/
+static void runStress(const juce::ArgumentList& args)
+{
+    const auto tolerance = args.containsOption("--tolerance") ? args.getValueForOption("--tolerance").getFloatValue() : 0.f;
+
+    RenderConfig baseConfig;
+    baseConfig.name = "all";
+    for( int i = 0; i < numDSPOptions; ++i )
+        baseConfig.activeOptions.push_back(static_cast<DSP_Option>(i));
+
+    //the envelope moves the ladder once per control block, which has to land on the same
+    //samples whatever the buffer sizes are
+    auto envelopeConfig = baseConfig;
+    envelopeConfig.name = "all+envelope";
+    envelopeConfig.envelopeTarget = EnvelopeTarget::LadderCutoff;
+
+    const auto signals = makeTestSignals(baseConfig.sampleRate, static_cast<int>(baseConfig.sampleRate));
+
+    std::vector<std::pair<juce::String, std::vector<int>>> sequences;
+    for( auto size : { 1, 3, 17, 63, 64, 65, 128, 1024 } )
+        sequences.push_back({ "fixed-" + juce::String(size), { size } });
+
+    {
+        juce::Random random(42);
+        std::vector<int> sizes;
+        for( int i = 0; i < 1000; ++i )
+            sizes.push_back(1 + random.nextInt(1024));
+        sequences.push_back({ "random-1-1024", sizes });
+    }
+
+    //tiny blocks straight after big ones, and sizes either side of the 64 sample split
+    sequences.push_back({ "adversarial", { 1, 1024, 3, 65, 17, 64, 1, 2, 127, 129, 511, 513 } });
+    sequences.push_back({ "alternating-1-1024", { 1, 1024 } });
+
+    struct Bucket { int low, high; const char* name; };
+    static constexpr Bucket buckets[] = { { 1, 1, "1" }, { 2, 16, "2-16" }, { 17, 63, "17-63" }, { 64, 64, "64" },
+                                          { 65, 511, "65-511" }, { 512, std::numeric_limits<int>::max(), "512+" } };
+
+    juce::Array<juce::var> sequenceResults;
+    int numFailed = 0;
+
+    for( const auto& sequenceConfig : { baseConfig, envelopeConfig } )
+    for( const auto& [sequenceName, sizes] : sequences )
+    {
+        const auto name = sequenceConfig.name + "/" + sequenceName;
+        std::vector<double> nsPerBlock, nsPerSample;
+        std::array<std::vector<double>, std::size(buckets)> bucketNsPerSample;
+        float maxError = 0.f;
+
+        for( const auto& signal : signals )
+        {
+            auto reference = render(sequenceConfig, signal.buffer);
+
+            auto config = sequenceConfig;
+            config.blockSizes = sizes;
+            auto result = render(config, signal.buffer);
+
+            maxError = juce::jmax(maxError, getMaxDifference(result.output, reference.output));
+
+            for( const auto& block : result.blocks )
+            {
+                auto perSample = block.ns / block.numSamples;
+                nsPerBlock.push_back(block.ns);
+                nsPerSample.push_back(perSample);
+
+                for( size_t b = 0; b < std::size(buckets); ++b )
+                    if( block.numSamples >= buckets[b].low && block.numSamples <= buckets[b].high )
+                        bucketNsPerSample[b].push_back(perSample);
+            }
+        }
+
+        auto passed = maxError <= tolerance;
+        if( ! passed )
+        {
+            ++numFailed;
+            std::cout << "FAIL " << name << " differs from the fixed 512 render by " << maxError << std::endl;
+        }
+
+        auto* bucketResults = new juce::DynamicObject();
+        for( size_t b = 0; b < std::size(buckets); ++b )
+            if( ! bucketNsPerSample[b].empty() )
+                bucketResults->setProperty(buckets[b].name, getDistribution(bucketNsPerSample[b]));
+
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("sequence", name);
+        entry->setProperty("maxError", maxError);
+        entry->setProperty("passed", passed);
+        entry->setProperty("nsPerBlock", getDistribution(nsPerBlock));
+        entry->setProperty("nsPerSample", getDistribution(nsPerSample));
+        entry->setProperty("nsPerSampleByBlockSize", juce::var(bucketResults));
+        sequenceResults.add(juce::var(entry));
+
+        std::cout << name << ": max error " << maxError
+                  << ", ns/sample p50 " << getPercentile(nsPerSample, 0.5)
+                  << " p99 " << getPercentile(nsPerSample, 0.99) << std::endl;
+    }
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("sampleRate", baseConfig.sampleRate);
+    report->setProperty("referenceBlockSize", baseConfig.blockSize);
+    report->setProperty("tolerance", tolerance);
+    report->setProperty("numFailed", numFailed);
+    report->setProperty("sequences", sequenceResults);
+    juce::var reportVar(report);
+
+    if( args.containsOption("--report") )
+        writeJsonFile(args.getFileForOption("--report"), reportVar);
+
+    if( numFailed > 0 )
+        juce::ConsoleApplication::fail(juce::String(numFailed) + " block size sequences differ from the fixed size render");
+}
+
+static double timeMs(const std::function<void()>& func)
+{
+    auto start = juce::Time::getHighResolutionTicks();
+    func();
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1000.0;
+}
+
+/*
+ instantiate [--instances <n>] [--no-editor] [--report <file>]
+
+ what opening a big session costs. n instances are built and kept alive together, like
+ an n track template: each is constructed, restores a saved state and is prepared. then
+ an editor is opened on each, ticked once (the first tick builds the analyzer) and
+ closed, and finally everything is destroyed. every phase is reported as a ms
+ distribution, plus how many shared resources the n instances ended up holding.
+*/
+static void runInstantiate(const juce::ArgumentList& args)
+{
+    const auto numInstances = args.containsOption("--instances") ? juce::jmax(1, args.getValueForOption("--instances").getIntValue()) : 100;
+    const auto withEditor = ! args.containsOption("--no-editor");
+
+    RenderConfig config;
+    for( int i = 0; i < numDSPOptions; ++i )
+        config.activeOptions.push_back(static_cast<DSP_Option>(i));
+
+    //what every instance restores, the way a host would from the session
+    juce::MemoryBlock state;
+    createProcessor(config)->getStateInformation(state);
+
+    std::vector<double> constructMs, restoreMs, prepareMs, editorOpenMs, editorFirstTickMs, editorCloseMs, destroyMs;
+    std::vector<std::unique_ptr<Audio_proAudioProcessor>> instances;
+
+    for( int i = 0; i < numInstances; ++i )
+    {
+        std::unique_ptr<Audio_proAudioProcessor> processor;
+        constructMs.push_back(timeMs([&] { processor = std::make_unique<Audio_proAudioProcessor>(); }));
+        restoreMs.push_back(timeMs([&] { processor->setStateInformation(state.getData(), static_cast<int>(state.getSize())); }));
+        prepareMs.push_back(timeMs([&]
+        {
+            processor->setRateAndBufferSizeDetails(config.sampleRate, config.blockSize);
+            processor->prepareToPlay(config.sampleRate, config.blockSize);
+        }));
+
+        instances.push_back(std::move(processor));
+    }
+
+    const auto numSharedResources = SharedResources::getNumLiveResources();
+
+    if( withEditor )
+    {
+        for( auto& processor : instances )
+        {
+            std::unique_ptr<juce::AudioProcessorEditor> editor;
+            editorOpenMs.push_back(timeMs([&] { editor.reset(processor->createEditorIfNeeded()); }));
+
+            if( auto* audioProEditor = dynamic_cast<Audio_proAudioProcessorEditor*>(editor.get()) )
+                editorFirstTickMs.push_back(timeMs([&] { audioProEditor->timerCallback(); }));
+
+            editorCloseMs.push_back(timeMs([&] { editor.reset(); }));
+        }
+    }
+
+    for( auto& processor : instances )
+        destroyMs.push_back(timeMs([&] { processor->releaseResources(); processor.reset(); }));
+
+    auto sum = [](const std::vector<double>& values) { return std::accumulate(values.begin(), values.end(), 0.0); };
+
+    auto* phases = new juce::DynamicObject();
+    phases->setProperty("construct", getDistribution(constructMs));
+    phases->setProperty("restoreState", getDistribution(restoreMs));
+    phases->setProperty("prepareToPlay", getDistribution(prepareMs));
+    if( withEditor )
+    {
+        phases->setProperty("editorOpen", getDistribution(editorOpenMs));
+        phases->setProperty("editorFirstTick", getDistribution(editorFirstTickMs));
+        phases->setProperty("editorClose", getDistribution(editorCloseMs));
+    }
+    phases->setProperty("destroy", getDistribution(destroyMs));
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("instances", numInstances);
+    report->setProperty("sharedResources", numSharedResources);
+    report->setProperty("sessionLoadMs", sum(constructMs) + sum(restoreMs) + sum(prepareMs));
+    report->setProperty("ms", juce::var(phases));
+    juce::var reportVar(report);
+
+    std::cout << numInstances << " instances, session load " << sum(constructMs) + sum(restoreMs) + sum(prepareMs) << " ms"
+              << " (construct p50 " << getPercentile(constructMs, 0.5)
+              << ", restore p50 " << getPercentile(restoreMs, 0.5)
+              << ", prepare p50 " << getPercentile(prepareMs, 0.5) << " ms)"
+              << ", " << numSharedResources << " shared resources" << std::endl;
+
+    if( withEditor )
+        std::cout << "editor open p50 " << getPercentile(editorOpenMs, 0.5)
+                  << " ms, first tick p50 " << getPercentile(editorFirstTickMs, 0.5)
+                  << " ms, close p50 " << getPercentile(editorCloseMs, 0.5) << " ms" << std::endl;
+
+    if( args.containsOption("--report") )
+        writeJsonFile(args.getFileForOption("--report"), reportVar);
+}
+
+/*
+ the cache and L1 data read miss counts of this thread, from perf_event_open. linux only,
+ and only where the kernel lets a user process count (perf_event_paranoid <= 2, and a
+ PMU that isn't hidden, which rules out most VMs). isAvailable() says whether it worked
+*/
+struct CacheMissCounters
+{
+    CacheMissCounters()
+    {
+       #if JUCE_LINUX
+        cacheMisses = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        l1dReadMisses = open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                                                 | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                                 | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+       #endif
+    }
+
+    ~CacheMissCounters()
+    {
+       #if JUCE_LINUX
+        for( auto fd : { cacheMisses, l1dReadMisses } )
+            if( fd >= 0 )
+                close(fd);
+       #endif
+    }
+
+    bool isAvailable() const noexcept { return cacheMisses >= 0 && l1dReadMisses >= 0; }
+
+    void start()
+    {
+       #if JUCE_LINUX
+        for( auto fd : { cacheMisses, l1dReadMisses } )
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+       #endif
+    }
+
+    //the counts since start(), {cache misses, L1D read misses}. zero when unavailable
+    std::pair<juce::int64, juce::int64> stop()
+    {
+        if( ! isAvailable() )
+            return {};
+
+       #if JUCE_LINUX
+        for( auto fd : { cacheMisses, l1dReadMisses } )
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+        return { read(cacheMisses), read(l1dReadMisses) };
+       #else
+        return {};
+       #endif
+    }
+
+private:
+   #if JUCE_LINUX
+    static int open(juce::uint32 type, juce::uint64 config)
+    {
+        perf_event_attr attr {};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    static juce::int64 read(int fd)
+    {
+        long long count = 0;
+        if( ::read(fd, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count)) )
+            return 0;
+
+        return static_cast<juce::int64>(count);
+    }
+   #endif
+
+    int cacheMisses = -1, l1dReadMisses = -1;
+};
+
+/*
+ cache [--instances <n>] [--block-size <n>] [--seconds <s>] [--mode arena|scattered] [--report <file>]
+
+ what the DSPArena buys with many instances on one core. n instances with everything
+ active run round robin, one host block each in turn, the way a host runs n tracks on
+ one thread. 100+ instances are far past L2, so every block starts by pulling its
+ chain state back in, and that's what separates the two layouts:
+    arena      every chain's buffers in one block (what the plugin does)
+    scattered  every buffer its own allocation, the layout from before the arena
+ both run by default, --mode runs one. the timed loop is wrapped in CacheMissCounters,
+ so where the kernel allows it the report has the cache and L1D read misses per sample
+ for each layout as well (the same events perf stat -e cache-misses,L1-dcache-load-misses
+ counts, but only for the timed part).
+*/
+static void runCache(const juce::ArgumentList& args)
+{
+    const auto numInstances = args.containsOption("--instances") ? juce::jmax(1, args.getValueForOption("--instances").getIntValue()) : 128;
+    const auto seconds = args.containsOption("--seconds") ? juce::jmax(0.1, args.getValueForOption("--seconds").getDoubleValue()) : 2.0;
+    const auto mode = args.getValueForOption("--mode");
+
+    RenderConfig baseConfig;
+    if( args.containsOption("--block-size") )
+        baseConfig.blockSize = juce::jmax(1, args.getValueForOption("--block-size").getIntValue());
+    for( int i = 0; i < numDSPOptions; ++i )
+        baseConfig.activeOptions.push_back(static_cast<DSP_Option>(i));
+
+    //noise, so nothing settles into a shortcut
+    const auto signals = makeTestSignals(baseConfig.sampleRate, static_cast<int>(seconds * baseConfig.sampleRate));
+    const auto& input = signals[1].buffer;
+    const auto numBlocks = input.getNumSamples() / baseConfig.blockSize;
+
+    juce::Array<juce::var> modeResults;
+
+    for( auto scattered : { false, true } )
+    {
+        const juce::String name = scattered ? "scattered" : "arena";
+        if( mode.isNotEmpty() && mode != name )
+            continue;
+
+        auto config = baseConfig;
+        config.scatteredState = scattered;
+
+        std::vector<std::unique_ptr<Audio_proAudioProcessor>> instances;
+        for( int i = 0; i < numInstances; ++i )
+            instances.push_back(createProcessor(config));
+
+        juce::AudioBuffer<float> block(2, baseConfig.blockSize);
+        juce::MidiBuffer midi;
+
+        auto runBlock = [&](Audio_proAudioProcessor& processor, int blockIndex)
+        {
+            for( int ch = 0; ch < 2; ++ch )
+                block.copyFrom(ch, 0, input, ch, blockIndex * baseConfig.blockSize, baseConfig.blockSize);
+            processor.processBlock(block, midi);
+        };
+
+        //one pass to get the IR-less steady state and the first touches out of the way
+        for( auto& processor : instances )
+            runBlock(*processor, 0);
+
+        CacheMissCounters counters;
+        counters.start();
+        const auto ms = timeMs([&]
+        {
+            for( int b = 1; b < numBlocks; ++b )
+                for( auto& processor : instances )
+                    runBlock(*processor, b);
+        });
+        const auto [cacheMisses, l1dReadMisses] = counters.stop();
+
+        const auto numSamples = static_cast<double>(numInstances) * (numBlocks - 1) * baseConfig.blockSize;
+        const auto nsPerSample = numSamples > 0.0 ? ms * 1.0e6 / numSamples : 0.0;
+        const auto arenaBytes = static_cast<juce::int64>(instances.front()->dspArena.getSizeInBytes());
+
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("mode", name);
+        entry->setProperty("nsPerSample", nsPerSample);
+        entry->setProperty("stateBytesPerInstance", arenaBytes);
+        if( counters.isAvailable() && numSamples > 0.0 )
+        {
+            entry->setProperty("cacheMissesPerSample", static_cast<double>(cacheMisses) / numSamples);
+            entry->setProperty("l1dReadMissesPerSample", static_cast<double>(l1dReadMisses) / numSamples);
+        }
+        modeResults.add(juce::var(entry));
+
+        std::cout << name << ": " << nsPerSample << " ns/sample per instance, "
+                  << arenaBytes / 1024 << " KiB of chain state per instance" << std::endl;
+
+        if( counters.isAvailable() && numSamples > 0.0 )
+            std::cout << "    " << static_cast<double>(cacheMisses) / numSamples << " cache misses, "
+                      << static_cast<double>(l1dReadMisses) / numSamples << " L1D read misses per sample" << std::endl;
+        else
+            std::cout << "    no hardware counters here, run it under perf stat for the miss counts" << std::endl;
+
+        for( auto& processor : instances )
+            processor->releaseResources();
+    }
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("instances", numInstances);
+    report->setProperty("sampleRate", baseConfig.sampleRate);
+    report->setProperty("blockSize", baseConfig.blockSize);
+    report->setProperty("modes", modeResults);
+    juce::var reportVar(report);
+
+    if( args.containsOption("--report") )
+        writeJsonFile(args.getFileForOption("--report"), reportVar);
+}
+
+/*
+ saturation [--samples <n>] [--report <file>]
+
+ the numbers in FastMath.h. every SaturationQuality curve, and the 128 point table
+ juce::dsp::LadderFilter saturates through, runs over a ramp across [-10, 10]. each
+ gets its max abs error against std::tanh and against juce's table, and its ns/sample
+ as the best of 7 passes over n samples (default 1 << 20).
+*/
+static void runSaturation(const juce::ArgumentList& args)
+{
+    const auto numSamples = args.containsOption("--samples") ? juce::jmax(1024, args.getValueForOption("--samples").getIntValue()) : 1 << 20;
+
+    const auto table = FastMath::getTanhTable<float>();
+    const juce::dsp::LookupTableTransform<float> juceTable([](float x) { return std::tanh(x); }, -5.f, 5.f, 128);
+
+    struct Curve
+    {
+        juce::String name;
+        std::function<float(float)> function;
+    };
+
+    //std::function costs every curve the same call, so the differences are the curves themselves
+    const std::vector<Curve> curves
+    {
+        { "Eco",     [](float x) { return FastMath::tanhRational(x); } },
+        { "Normal",  [&table](float x) { return (*table)(x); } },
+        { "Precise", [](float x) { return std::tanh(x); } },
+        { "juce",    [&juceTable](float x) { return juceTable(x); } },
+    };
+
+    std::vector<float> input(static_cast<size_t>(numSamples));
+    for( size_t i = 0; i < input.size(); ++i )
+        input[i] = -10.f + 20.f * static_cast<float>(i) / static_cast<float>(input.size());
+
+    juce::Array<juce::var> results;
+
+    for( const auto& curve : curves )
+    {
+        double errorVsTanh = 0.0, errorVsJuce = 0.0;
+        for( double x = -10.0; x <= 10.0; x += 1.0e-5 )
+        {
+            const auto sample = static_cast<float>(x);
+            const auto value = curve.function(sample);
+            errorVsTanh = juce::jmax(errorVsTanh, static_cast<double>(std::abs(value - std::tanh(sample))));
+            errorVsJuce = juce::jmax(errorVsJuce, static_cast<double>(std::abs(value - juceTable(sample))));
+        }
+
+        //summed so the compiler can't drop the calls
+        double bestMs = std::numeric_limits<double>::max();
+        volatile float sink = 0.f;
+        for( int pass = 0; pass < 7; ++pass )
+        {
+            float sum = 0.f;
+            bestMs = juce::jmin(bestMs, timeMs([&] { for( auto x : input ) sum += curve.function(x); }));
+            sink = sum;
+        }
+        juce::ignoreUnused(sink);
+
+        const auto nsPerSample = bestMs * 1.0e6 / static_cast<double>(numSamples);
+
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("curve", curve.name);
+        entry->setProperty("maxErrorVsTanh", errorVsTanh);
+        entry->setProperty("maxErrorVsJuce", errorVsJuce);
+        entry->setProperty("nsPerSample", nsPerSample);
+        results.add(juce::var(entry));
+
+        std::cout << curve.name << ": " << errorVsTanh << " max error vs std::tanh, " << errorVsJuce
+                  << " vs juce, " << nsPerSample << " ns/sample" << std::endl;
+    }
+
+    if( args.containsOption("--report") )
+        writeJsonFile(args.getFileForOption("--report"), juce::var(results));
+}
+
+/*
+ bands [--seconds <s>] [--block-size <n>] [--report <file>]
+
+ what the multiband mode costs against the single chain. every effect on, noise in,
+ rendered with Multiband Bands off and then with 2, 3 and 4 bands, each the best of 5
+ renders of s seconds (default 2). n bands cost less than n chains: only the slots
+ before the limiter run per band, and the crossovers, the general filter and the ladders
+ of every band and channel run side by side in SIMD lanes.
+*/
+static void runBands(const juce::ArgumentList& args)
+{
+    const auto seconds = args.containsOption("--seconds") ? juce::jmax(0.1, args.getValueForOption("--seconds").getDoubleValue()) : 2.0;
+
+    RenderConfig baseConfig;
+    if( args.containsOption("--block-size") )
+        baseConfig.blockSize = juce::jmax(1, args.getValueForOption("--block-size").getIntValue());
+    for( int i = 0; i < numDSPOptions; ++i )
+        baseConfig.activeOptions.push_back(static_cast<DSP_Option>(i));
+
+    //noise, so nothing settles into a shortcut
+    const auto signals = makeTestSignals(baseConfig.sampleRate, static_cast<int>(seconds * baseConfig.sampleRate));
+    const auto& input = signals[1].buffer;
+
+    juce::Array<juce::var> results;
+    double singleChainNs = 0.0;
+
+    for( int numBands = 1; numBands <= MultibandSplitter::maxBands; ++numBands )
+    {
+        auto config = baseConfig;
+        config.numBands = numBands;
+
+        double bestNs = std::numeric_limits<double>::max();
+        for( int pass = 0; pass < 5; ++pass )
+            bestNs = juce::jmin(bestNs, render(config, input).nsPerSample);
+
+        if( numBands == 1 )
+            singleChainNs = bestNs;
+
+        const auto ratio = singleChainNs > 0.0 ? bestNs / singleChainNs : 0.0;
+
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("bands", numBands);
+        entry->setProperty("nsPerSample", bestNs);
+        entry->setProperty("costVsSingleChain", ratio);
+        results.add(juce::var(entry));
+
+        std::cout << (numBands == 1 ? juce::String("single chain") : juce::String(numBands) + " bands") << ": "
+                  << bestNs << " ns/sample, " << ratio << "x the single chain" << std::endl;
+    }
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("sampleRate", baseConfig.sampleRate);
+    report->setProperty("blockSize", baseConfig.blockSize);
+    report->setProperty("seconds", seconds);
+    report->setProperty("results", results);
+
+    if( args.containsOption("--report") )
+        writeJsonFile(args.getFileForOption("--report"), juce::var(report));
+}
+
+/*
+ batch --preset <file> --input <dir> [--recursive] [--threads <n>] [--block-size <n>] [--suffix <s>] [--report <file>]
+
+ the nightly stem reprocessing without a DAW. every audio file in <dir> goes through its
+ own instance with the preset loaded, rendered offline (so with render quality), and
+ <name><suffix>.wav (default _audio_pro) is written next to it, latency compensated and
+ the same length as the input. the files are spread over n threads (default one per
+ core). the summary is total audio time against wall time, per file results go in the
+ report. exits with 1 if any file failed.
+*/
+static void runBatch(const juce::ArgumentList& args)
+{
+    BatchSettings settings;
+    settings.numThreads = args.containsOption("--threads") ? juce::jmax(1, args.getValueForOption("--threads").getIntValue())
+                                                           : juce::SystemStats::getNumCpus();
+    if( args.containsOption("--block-size") )
+        settings.blockSize = juce::jmax(1, args.getValueForOption("--block-size").getIntValue());
+    if( args.containsOption("--suffix") )
+        settings.suffix = args.getValueForOption("--suffix");
+
+    auto presetFile = args.getExistingFileForOption("--preset");
+    if( ! loadPresetState(presetFile, settings.state) )
+        juce::ConsoleApplication::fail("couldn't read a preset from " + presetFile.getFullPathName());
+
+    auto inputDir = args.getExistingFolderForOption("--input");
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+    auto inputs = findBatchInputs(inputDir, args.containsOption("--recursive"), settings.suffix, formats);
+    if( inputs.isEmpty() )
+        juce::ConsoleApplication::fail("no audio files in " + inputDir.getFullPathName());
+
+    std::cout << inputs.size() << " files on " << juce::jmin(settings.numThreads, inputs.size()) << " threads" << std::endl;
+
+    std::vector<BatchFileResult> results;
+    const auto wallSeconds = timeMs([&] { results = renderBatch(inputs, settings); }) * 0.001;
+
+    double audioSeconds = 0.0, cpuSeconds = 0.0;
+    juce::int64 numBytes = 0;
+    int numFailed = 0, numMapped = 0;
+    juce::Array<juce::var> fileResults;
+
+    for( const auto& result : results )
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("input", result.input.getFullPathName());
+        entry->setProperty("output", result.output.getFullPathName());
+        entry->setProperty("succeeded", result.succeeded);
+        entry->setProperty("error", result.error);
+        entry->setProperty("memoryMapped", result.memoryMapped);
+        entry->setProperty("channels", result.numChannels);
+        entry->setProperty("sampleRate", result.sampleRate);
+        entry->setProperty("samples", result.numSamples);
+        entry->setProperty("seconds", result.seconds);
+        fileResults.add(juce::var(entry));
+
+        cpuSeconds += result.seconds;
+        numMapped += result.memoryMapped ? 1 : 0;
+
+        if( ! result.succeeded )
+        {
+            ++numFailed;
+            std::cout << "FAIL " << result.input.getFullPathName() << ": " << result.error << std::endl;
+            continue;
+        }
+
+        audioSeconds += static_cast<double>(result.numSamples) / result.sampleRate;
+        numBytes += result.input.getSize();
+    }
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("preset", presetFile.getFullPathName());
+    report->setProperty("threads", settings.numThreads);
+    report->setProperty("blockSize", settings.blockSize);
+    report->setProperty("numFiles", static_cast<int>(results.size()));
+    report->setProperty("numFailed", numFailed);
+    report->setProperty("numMemoryMapped", numMapped);
+    report->setProperty("audioSeconds", audioSeconds);
+    report->setProperty("wallSeconds", wallSeconds);
+    report->setProperty("cpuSeconds", cpuSeconds);
+    report->setProperty("realtimeFactor", wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0);
+    report->setProperty("inputMBPerSecond", wallSeconds > 0.0 ? static_cast<double>(numBytes) / (1024.0 * 1024.0) / wallSeconds : 0.0);
+    report->setProperty("files", fileResults);
+    juce::var reportVar(report);
+
+    std::cout << static_cast<int>(results.size()) - numFailed << " of " << results.size() << " files rendered"
+              << " (" << numMapped << " memory mapped), " << audioSeconds << " s of audio in " << wallSeconds << " s"
+              << ", " << (wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0) << "x realtime"
+              << ", " << (wallSeconds > 0.0 ? cpuSeconds / wallSeconds : 0.0) << " cores busy on average" << std::endl;
+
+    if( args.containsOption("--report") )
+        writeJsonFile(args.getFileForOption("--report"), reportVar);
+
+    if( numFailed > 0 )
+        juce::ConsoleApplication::fail(juce::String(numFailed) + " files failed");
+}
+
+int main(int argc, char* argv[])
+{
+    //the apvts and the IR loader want a message manager around
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand("--help|-h", "Usage:", true);
+
+    app.addCommand({ "golden",
+                     "golden [--reference <dir>] [--hashes <file>] [--write] [--tolerance <x>] [--report <file>] [--permutations <n>] [--offline]",
+                     "Checks (or with --write, makes) golden renders and reports ns/sample per configuration",
+                     "Every DSP_Option on its own is compared sample by sample against <dir>/<option>_<signal>.wav, "
+                     "every DSP_Order permutation against the per window rms in <dir>/permutations.json. "
+                     "--hashes checks every render against a manifest of output hashes, exact and only for one compiler and CPU. "
+                     "The ladder and general filter are checked once more with the envelope follower moving them. "
+                     "The convolution runs with a generated test IR. "
+                     "Exits with 1 if anything differs by more than the tolerance (default 1e-4) or a hash differs.",
+                     runGolden });
+
+    app.addCommand({ "stress",
+                     "stress [--tolerance <x>] [--report <file>]",
+                     "Renders with odd, random and adversarial buffer sizes and reports per block cost",
+                     "Every sequence has to match a fixed 512 sample render within the tolerance (default 0, identical), "
+                     "once with every effect on and once more with the envelope follower on the ladder cutoff. "
+                     "The report has ns/block and ns/sample distributions (p50/p95/p99/max) per sequence and per block size range.",
+                     runStress });
+
+    app.addCommand({ "instantiate",
+                     "instantiate [--instances <n>] [--no-editor] [--report <file>]",
+                     "Times constructing, restoring, preparing and opening the editor of n instances (default 100)",
+                     "All n instances stay alive together, like a session with n tracks. "
+                     "The report has a ms distribution (p50/p95/p99/max) per phase and the number of shared resources held.",
+                     runInstantiate });
+
+    app.addCommand({ "cache",
+                     "cache [--instances <n>] [--block-size <n>] [--seconds <s>] [--mode arena|scattered] [--report <file>]",
+                     "Runs n instances (default 128) round robin and compares the arena chain state against scattered buffers",
+                     "Every instance processes one block in turn, like n tracks on one core. Reports ns/sample per instance for each "
+                     "layout. --mode runs just one, to measure the cache misses with perf stat.",
+                     runCache });
+
+    app.addCommand({ "saturation",
+                     "saturation [--samples <n>] [--report <file>]",
+                     "Measures every SaturationQuality curve against std::tanh and juce's ladder table",
+                     "Reports the max abs error over [-10, 10] against std::tanh and against the 128 point table "
+                     "juce::dsp::LadderFilter uses, and ns/sample as the best of 7 passes (default 1 << 20 samples).",
+                     runSaturation });
+
+    app.addCommand({ "bands",
+                     "bands [--seconds <s>] [--block-size <n>] [--report <file>]",
+                     "Compares the cost of 2, 3 and 4 multiband bands against the single chain",
+                     "Every effect is on and the input is noise. Reports ns/sample for Multiband Bands off and for each band count, "
+                     "as the best of 5 renders of s seconds (default 2), and each as a multiple of the single chain.",
+                     runBands });
+
+    app.addCommand({ "batch",
+                     "batch --preset <file> --input <dir> [--recursive] [--threads <n>] [--block-size <n>] [--suffix <s>] [--report <file>]",
+                     "Renders every audio file in a folder through the plugin with a preset, one instance per file",
+                     "The preset is a saved plugin state, binary or xml. Each file is rendered offline (render quality on) and written "
+                     "next to the input as <name><suffix>.wav (default _audio_pro), latency compensated. Files are spread over n "
+                     "threads (default one per core). Prints total audio time against wall time, --report has the per file results. "
+                     "Only mono and stereo files are rendered, and a preset whose impulse response doesn't load fails every file. "
+                     "Exits with 1 if any file failed.",
+                     runBatch });
+
+    return app.findAndRunCommand(argc, argv);
+}
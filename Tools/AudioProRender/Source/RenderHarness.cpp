@@ -0,0 +1,321 @@
+/*
+  ==============================================================================
+
+    RenderHarness.cpp
+
+  ==============================================================================
+*/
+
+#include "RenderHarness.h"
+
+juce::String getOptionName(DSP_Option option)
+{
+    if( option == DSP_Option::END_OF_LIST )
+    {
+        jassertfalse;
+        return "none";
+    }
+
+    return Audio_proAudioProcessor::getEffectDescriptor(option).shortName;
+}
+
+juce::String getOrderName(const DSP_Order& order)
+{
+    juce::StringArray names;
+    for( auto option : order )
+        names.add(getOptionName(option));
+
+    return names.joinIntoString("-");
+}
+
+DSP_Order getDefaultOrder()
+{
+    DSP_Order order;
+    for( size_t i = 0; i < order.size(); ++i )
+        order[i] = static_cast<DSP_Option>(i);
+
+    return order;
+}
+
+std::vector<TestSignal> makeTestSignals(double sampleRate, int numSamples)
+{
+    std::vector<TestSignal> signals;
+
+    //20 Hz -> 20 kHz log sweep at -6 dB, the right channel a quarter cycle behind so M/S has a side
+    {
+        TestSignal sweep { "sweep", juce::AudioBuffer<float>(2, numSamples) };
+        const auto duration = numSamples / sampleRate;
+        const auto k = std::log(20000.0 / 20.0);
+        for( int n = 0; n < numSamples; ++n )
+        {
+            auto t = n / sampleRate;
+            auto phase = juce::MathConstants<double>::twoPi * 20.0 * duration / k * (std::exp(t / duration * k) - 1.0);
+            sweep.buffer.setSample(0, n, 0.5f * static_cast<float>(std::sin(phase)));
+            sweep.buffer.setSample(1, n, 0.5f * static_cast<float>(std::cos(phase)));
+        }
+        signals.push_back(std::move(sweep));
+    }
+
+    {
+        TestSignal noise { "noise", juce::AudioBuffer<float>(2, numSamples) };
+        juce::Random random(1234);
+        for( int ch = 0; ch < 2; ++ch )
+            for( int n = 0; n < numSamples; ++n )
+                noise.buffer.setSample(ch, n, 0.5f * (random.nextFloat() * 2.f - 1.f));
+        signals.push_back(std::move(noise));
+    }
+
+    //full scale, 4 per second, so the limiter and the tails of everything get exercised
+    {
+        TestSignal impulses { "impulses", juce::AudioBuffer<float>(2, numSamples) };
+        impulses.buffer.clear();
+        const auto spacing = juce::jmax(1, static_cast<int>(sampleRate / 4.0));
+        for( int n = 0; n < numSamples; n += spacing )
+        {
+            impulses.buffer.setSample(0, n, 1.f);
+            impulses.buffer.setSample(1, n, -1.f);
+        }
+        signals.push_back(std::move(impulses));
+    }
+
+    return signals;
+}
+
+juce::File writeTestImpulse(double sampleRate)
+{
+    const auto numSamples = static_cast<int>(sampleRate / 2.0);
+    juce::AudioBuffer<float> impulse(2, numSamples);
+    juce::Random random(4321);
+
+    //a 60 dB decay over the half second, the left and right channels uncorrelated
+    const auto decayPerSample = std::log(0.001) / numSamples;
+    for( int ch = 0; ch < 2; ++ch )
+        for( int n = 0; n < numSamples; ++n )
+            impulse.setSample(ch, n, static_cast<float>(std::exp(decayPerSample * n)) * (random.nextFloat() * 2.f - 1.f));
+
+    auto file = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("audio_pro_test_ir.wav");
+    if( ! writeWavFile(file, impulse, sampleRate) )
+        return {};
+
+    return file;
+}
+
+static void setParameter(juce::RangedAudioParameter* param, float value)
+{
+    jassert(param != nullptr);
+    param->setValueNotifyingHost(param->convertTo0to1(value));
+}
+
+//settings that make every effect clearly audible, so a change in any of them shows up
+static void applyTestSettings(Audio_proAudioProcessor& p)
+{
+    setParameter(p.phaserRateHz, 0.5f);
+    setParameter(p.phaserDepthPercent, 0.6f);
+    setParameter(p.phaserCenterFreqHz, 800.f);
+    setParameter(p.phaserFeedbackPercent, 0.4f);
+    setParameter(p.phaserMixPercent, 0.5f);
+
+    setParameter(p.chorusRateHz, 1.2f);
+    setParameter(p.chorusDepthPercent, 0.4f);
+    setParameter(p.chorusCenterDelayMs, 8.f);
+    setParameter(p.chorusFeedbackPercent, 0.2f);
+    setParameter(p.chorusMixPercent, 0.5f);
+
+    setParameter(p.overdriveSaturationPercent, 20.f);
+
+    setParameter(p.ladderFilterMode, 3.f); // LPF24
+    setParameter(p.ladderFilterCutoffHz, 2000.f);
+    setParameter(p.ladderFilterResonance, 40.f);
+    setParameter(p.ladderFilterDrive, 2.f);
+
+    setParameter(p.generalFilterMode, 0.f); // Peak
+    setParameter(p.generalFilterFreqHz, 1000.f);
+    setParameter(p.generalFilterQuality, 1.5f);
+    setParameter(p.generalFilterGaindB, 6.f);
+
+    setParameter(p.limiterCeilingdB, -6.f);
+    setParameter(p.limiterReleaseMs, 50.f);
+    setParameter(p.limiterLookaheadMs, 1.5f);
+
+    setParameter(p.convolutionMixPercent, 0.5f);
+
+    //a fixed time, the harness has no playhead to sync to
+    setParameter(p.delaySync, 0.f); // Off
+    setParameter(p.delayTimeMs, 120.f);
+    setParameter(p.delayFeedbackPercent, 0.4f);
+    setParameter(p.delayLowCutHz, 100.f);
+    setParameter(p.delayHighCutHz, 6000.f);
+    setParameter(p.delayMixPercent, 0.4f);
+
+    //only on in the configs that pick a target
+    setParameter(p.envelopeDepthOctaves, 2.f);
+    setParameter(p.envelopeAttackMs, 5.f);
+    setParameter(p.envelopeReleaseMs, 80.f);
+}
+
+int RenderConfig::getMaximumBlockSize() const
+{
+    if( blockSizes.empty() )
+        return blockSize;
+
+    return *std::max_element(blockSizes.begin(), blockSizes.end());
+}
+
+std::unique_ptr<Audio_proAudioProcessor> createProcessor(const RenderConfig& config)
+{
+    auto processor = std::make_unique<Audio_proAudioProcessor>();
+    applyTestSettings(*processor);
+
+    for( int i = 0; i < numDSPOptions; ++i )
+    {
+        auto option = static_cast<DSP_Option>(i);
+        auto active = std::find(config.activeOptions.begin(), config.activeOptions.end(), option) != config.activeOptions.end();
+        setParameter(processor->getBypassParameter(option), active ? 0.f : 1.f);
+    }
+
+    setParameter(processor->envelopeTarget, static_cast<float>(config.envelopeTarget));
+    setParameter(processor->multibandBands, static_cast<float>(config.numBands - 1));
+
+    processor->dspOrderFifo.push(config.order);
+    processor->setNonRealtime(config.nonRealtime);
+    processor->dspArena.setScattered(config.scatteredState);
+    //before prepareToPlay this only stores the path, prepareToPlay starts the load
+    if( config.impulseResponse != juce::File() )
+        processor->loadImpulseResponse(config.impulseResponse);
+
+    processor->setRateAndBufferSizeDetails(config.sampleRate, config.getMaximumBlockSize());
+    processor->prepareToPlay(config.sampleRate, config.getMaximumBlockSize());
+
+    //the IR is read and transformed on the loader thread, the first block has to have it
+    while( processor->isLoadingImpulseResponse() )
+        juce::Thread::sleep(1);
+
+    return processor;
+}
+
+RenderResult render(const RenderConfig& config, const juce::AudioBuffer<float>& input)
+{
+    auto processor = createProcessor(config);
+
+    RenderResult result;
+    result.output.makeCopyOf(input);
+
+    juce::MidiBuffer midi;
+    const auto numSamples = input.getNumSamples();
+    juce::int64 ticks = 0;
+    size_t blockIndex = 0;
+
+    for( int start = 0; start < numSamples; )
+    {
+        auto requested = config.blockSizes.empty() ? config.blockSize
+                                                   : config.blockSizes[blockIndex++ % config.blockSizes.size()];
+        auto blockSize = juce::jmin(requested, numSamples - start);
+        //refers straight into the output, no copy
+        juce::AudioBuffer<float> block(result.output.getArrayOfWritePointers(), result.output.getNumChannels(), start, blockSize);
+
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        processor->processBlock(block, midi);
+        auto blockTicks = juce::Time::getHighResolutionTicks() - startTicks;
+
+        ticks += blockTicks;
+        result.blocks.push_back({ blockSize, juce::Time::highResolutionTicksToSeconds(blockTicks) * 1.0e9 });
+        start += blockSize;
+    }
+
+    processor->releaseResources();
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(ticks);
+    result.nsPerSample = numSamples > 0 ? seconds * 1.0e9 / numSamples : 0.0;
+    return result;
+}
+
+float getMaxDifference(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+{
+    if( a.getNumChannels() != b.getNumChannels() || a.getNumSamples() != b.getNumSamples() )
+        return std::numeric_limits<float>::infinity();
+
+    float maxDifference = 0.f;
+    for( int ch = 0; ch < a.getNumChannels(); ++ch )
+    {
+        auto* x = a.getReadPointer(ch);
+        auto* y = b.getReadPointer(ch);
+        for( int n = 0; n < a.getNumSamples(); ++n )
+            maxDifference = juce::jmax(maxDifference, std::abs(x[n] - y[n]));
+    }
+
+    return maxDifference;
+}
+
+juce::String getOutputHash(const juce::AudioBuffer<float>& buffer)
+{
+    auto hash = static_cast<juce::uint64>(0xcbf29ce484222325ULL);
+    auto add = [&hash](juce::uint64 value)
+    {
+        for( int byte = 0; byte < 8; ++byte )
+        {
+            hash ^= (value >> (8 * byte)) & 0xff;
+            hash *= 0x100000001b3ULL;
+        }
+    };
+
+    add(static_cast<juce::uint64>(buffer.getNumChannels()));
+    add(static_cast<juce::uint64>(buffer.getNumSamples()));
+
+    for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+    {
+        const auto* samples = buffer.getReadPointer(ch);
+        for( int n = 0; n < buffer.getNumSamples(); ++n )
+        {
+            //a nan or inf is a failure either way, it just has to hash to something
+            const auto x = std::isfinite(samples[n]) ? static_cast<double>(samples[n]) : 1.0e9;
+            add(static_cast<juce::uint64>(static_cast<juce::int64>(std::llround(x * 65536.0))));
+        }
+    }
+
+    return juce::String::toHexString(static_cast<juce::int64>(hash)).paddedLeft('0', 16);
+}
+
+juce::Array<juce::var> getWindowRMS(const juce::AudioBuffer<float>& buffer, int windowSize)
+{
+    juce::Array<juce::var> windows;
+    for( int start = 0; start + windowSize <= buffer.getNumSamples(); start += windowSize )
+        for( int ch = 0; ch < buffer.getNumChannels(); ++ch )
+            windows.add(buffer.getRMSLevel(ch, start, windowSize));
+
+    return windows;
+}
+
+bool writeWavFile(const juce::File& file, const juce::AudioBuffer<float>& buffer, double sampleRate)
+{
+    file.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream(file.createOutputStream());
+    if( stream == nullptr )
+        return false;
+
+    juce::WavAudioFormat wav;
+    //32 bit float, so the references don't add their own rounding to the comparison
+    std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate,
+                                                                         static_cast<unsigned int>(buffer.getNumChannels()),
+                                                                         32, {}, 0));
+    if( writer == nullptr )
+        return false;
+
+    stream.release(); // the writer owns it now
+    return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+}
+
+bool readWavFile(const juce::File& file, juce::AudioBuffer<float>& buffer)
+{
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> reader(wav.createReaderFor(file.createInputStream().release(), true));
+    if( reader == nullptr )
+        return false;
+
+    buffer.setSize(static_cast<int>(reader->numChannels), static_cast<int>(reader->lengthInSamples));
+    return reader->read(&buffer, 0, buffer.getNumSamples(), 0, true, true);
+}
+
+bool writeJsonFile(const juce::File& file, const juce::var& json)
+{
+    return file.replaceWithText(juce::JSON::toString(json));
+}
@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    RenderHarness.h
+    offline renders of Audio_proAudioProcessor for the AudioProRender tool.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+using DSP_Option = Audio_proAudioProcessor::DSP_Option;
+using DSP_Order = Audio_proAudioProcessor::DSP_Order;
+
+static constexpr int numDSPOptions = static_cast<int>(DSP_Option::END_OF_LIST);
+
+juce::String getOptionName(DSP_Option option);
+juce::String getOrderName(const DSP_Order& order);
+DSP_Order getDefaultOrder();
+
+struct TestSignal
+{
+    juce::String name;
+    juce::AudioBuffer<float> buffer;
+};
+
+//log sine sweep, white noise and an impulse train. seeded, so every run gets the same input
+std::vector<TestSignal> makeTestSignals(double sampleRate, int numSamples);
+
+//half a second of seeded, exponentially decaying stereo noise, a small room. written as a
+//32 bit wav to the temp directory (the plugin only loads IRs from disk), the file is returned
+juce::File writeTestImpulse(double sampleRate);
+
+//everything that decides what a render sounds like
+struct RenderConfig
+{
+    juce::String name;
+    DSP_Order order = getDefaultOrder();
+    //everything not in here is bypassed
+    std::vector<DSP_Option> activeOptions;
+    double sampleRate = 48000.0;
+    int blockSize = 512;
+    //when set, the host buffer sizes cycle through these instead of blockSize.
+    //prepareToPlay gets the largest one, like a host would report
+    std::vector<int> blockSizes;
+    //renders like a host bounce, which switches on the plugin's render quality
+    bool nonRealtime = false;
+    //every chain buffer allocated on its own instead of in the DSPArena, for the cache benchmark
+    bool scatteredState = false;
+    //loaded before prepareToPlay, and the render waits until it's in
+    juce::File impulseResponse;
+    //the envelope follower's target, with the depth and times from the test settings
+    EnvelopeTarget envelopeTarget = EnvelopeTarget::Off;
+    //1 is the Multiband Bands parameter's Off, 2-4 split at the default crossovers
+    int numBands = 1;
+
+    int getMaximumBlockSize() const;
+};
+
+struct BlockTiming
+{
+    int numSamples = 0;
+    double ns = 0.0;
+};
+
+struct RenderResult
+{
+    juce::AudioBuffer<float> output;
+    double nsPerSample = 0.0;
+    std::vector<BlockTiming> blocks;
+};
+
+/*
+ a fresh processor per render: the test settings go in before prepareToPlay so the
+ smoothers start at their targets, and the order goes through dspOrderFifo the same
+ way the editor sends it.
+*/
+std::unique_ptr<Audio_proAudioProcessor> createProcessor(const RenderConfig& config);
+RenderResult render(const RenderConfig& config, const juce::AudioBuffer<float>& input);
+
+float getMaxDifference(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b);
+
+//64 bit FNV-1a over the samples rounded to 2^-16, as 16 hex digits. small enough to commit
+//for every render, but only stable for one compiler and CPU family: a last bit difference
+//that happens to round the other way changes it, where the wav references would pass
+juce::String getOutputHash(const juce::AudioBuffer<float>& buffer);
+
+//rms per channel of each window, a compact fingerprint for the permutation renders
+juce::Array<juce::var> getWindowRMS(const juce::AudioBuffer<float>& buffer, int windowSize);
+
+bool writeWavFile(const juce::File& file, const juce::AudioBuffer<float>& buffer, double sampleRate);
+bool readWavFile(const juce::File& file, juce::AudioBuffer<float>& buffer);
+bool writeJsonFile(const juce::File& file, const juce::var& json);